@@ -0,0 +1,76 @@
+#include "bench_harness.hpp"
+#include "loopback_fanout.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+// Counts heap allocations on every thread but the uncounted ones while
+// enabled, to check that the steady-state feed path allocates nothing.
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> allocations{0};
+thread_local bool uncounted = false;
+}
+
+void* operator new(size_t size) {
+    if (counting.load(std::memory_order_relaxed) && !uncounted) allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+// Upstream book frames routed by DeribitClient, handed to a fan-out worker
+// and sent to one subscribed loopback client, as in the live feed. Warm-up
+// goes twice round the queue so every slot's buffers have grown; from then
+// on every allocation on the feed, fan-out and server threads is counted
+// (the client's own thread is not). Each frame is delivered before the next,
+// so send queues stay at steady-state depth. Fails if any frame allocated.
+MICROBENCH(alloc_feed_path) {
+    constexpr size_t kQueueCapacity = 4096;
+    constexpr size_t kFrames = 4096;
+    LoopbackFanout fanout(1, kQueueCapacity);
+    fanout.start(1, 19500);
+    std::atomic<bool> client_uncounted{false};
+    fanout.clients.get_io_service().post([&]() {
+        uncounted = true;
+        client_uncounted = true;
+    });
+    while (!client_uncounted) std::this_thread::yield();
+
+    auto frames = ctx.fixture_lines("book_changes.jsonl");
+    size_t routed = 0;
+    auto deliver = [&]() {
+        if (!fanout.wait_received(routed, std::chrono::seconds(5))) {
+            throw std::runtime_error("Frame " + std::to_string(routed) + " not delivered within 5s");
+        }
+    };
+    for (size_t i = 0; i < 2 * kQueueCapacity; ++i) {
+        fanout.upstream.process_message(frames[routed++ % frames.size()]);
+        deliver();
+    }
+
+    allocations.store(0);
+    counting.store(true);
+    ctx.measure_each(kFrames, [&]() {
+        fanout.upstream.process_message(frames[routed++ % frames.size()]);
+    }, deliver);
+    counting.store(false);
+
+    double per_frame = static_cast<double>(allocations.load()) / kFrames;
+    ctx.set_counter("frames", kFrames);
+    ctx.set_counter("allocs_per_frame", per_frame);
+    if (allocations.load() > 0) {
+        throw std::runtime_error(std::to_string(allocations.load()) + " allocations over " + std::to_string(kFrames) +
+                                 " steady-state frames (" + std::to_string(per_frame) + " per frame)");
+    }
+}
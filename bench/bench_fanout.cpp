@@ -0,0 +1,92 @@
+#include "bench_harness.hpp"
+#include "loopback_fanout.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+static const char kChannel[] = "book.BTC-PERPETUAL.agg2";
+
+// Times publish() without fan-out workers (lock, lookup and per-client send
+// enqueue on the calling thread). Each sample waits for every client to
+// receive the update before the next.
+static void run_fanout(BenchContext& ctx, size_t subscribers, uint16_t port, size_t samples) {
+    LoopbackFanout fanout(0, 0);
+    fanout.start(subscribers, port);
+    ctx.set_counter("subscribers", static_cast<double>(fanout.confirmed.load()));
+
+    // A lost update fails the benchmark instead of hanging it; the remaining
+    // samples are then published without waiting.
+    bool timed_out = false;
+    std::string frame = ctx.fixture_lines("book_changes.jsonl").at(0);
+    size_t expected = 0;
+    ctx.measure_each(samples, [&]() {
+        fanout.server.publish(kChannel, frame);
+    }, [&]() {
+        expected += subscribers;
+        if (!timed_out) timed_out = !fanout.wait_received(expected, std::chrono::seconds(5));
+    });
+    if (timed_out) {
+        throw std::runtime_error("Update not delivered to every subscriber within 5s (" + std::to_string(fanout.received.load()) + " received)");
+    }
+}
+
+MICROBENCH(fanout_broadcast_1) {
+    run_fanout(ctx, 1, 19101, 2000);
+}
+
+MICROBENCH(fanout_broadcast_10) {
+    run_fanout(ctx, 10, 19110, 2000);
+}
+
+MICROBENCH(fanout_broadcast_100) {
+    run_fanout(ctx, 100, 19200, 500);
+}
+
+// Downstream slowdown: 200 subscribers make every broadcast slower than the
+// back-to-back publishes feeding it. The recorded samples are how long each
+// publish() holds the upstream reader (its read lag); the counters give the
+// fan-out queue's occupancy, how long updates waited in it and how many were
+// dropped. With 0 workers the reader pays for every send itself.
+static void run_slow_consumer(BenchContext& ctx, size_t fanout_workers, uint16_t port) {
+    constexpr size_t kSubscribers = 200;
+    constexpr size_t kUpdates = 5000;
+    constexpr size_t kQueueCapacity = 256;
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    Counter& dropped = metrics.counter("deribit_fanout_queue_dropped_total", "Updates dropped because a fan-out queue was full");
+    LatencyHistogram& queue_wait = metrics.histogram("deribit_fanout_queue_wait_seconds", "Time updates spend queued for a fan-out worker");
+
+    LoopbackFanout fanout(fanout_workers, kQueueCapacity);
+    fanout.start(kSubscribers, port);
+    Gauge* depth = fanout_workers ? &metrics.gauge("deribit_fanout_queue_depth", "Updates waiting for a fan-out worker",
+                                                   MetricsRegistry::label("worker", "0")) : nullptr;
+    uint64_t dropped_before = dropped.value();
+    queue_wait.reset();
+
+    std::string frame = ctx.fixture_lines("book_changes.jsonl").at(0);
+    int64_t max_depth = 0;
+    ctx.measure_each(kUpdates, [&]() {
+        fanout.server.publish(kChannel, frame);
+    }, [&]() {
+        if (depth) max_depth = std::max(max_depth, depth->value());
+    });
+
+    uint64_t lost = dropped.value() - dropped_before;
+    if (!fanout.wait_received((kUpdates - lost) * kSubscribers, std::chrono::seconds(30))) {
+        throw std::runtime_error("Queued updates not delivered within 30s (" + std::to_string(fanout.received.load()) + " received)");
+    }
+    LatencyHistogram::Summary waited = queue_wait.summary();
+    ctx.set_counter("subscribers", kSubscribers);
+    ctx.set_counter("queue_capacity", fanout_workers ? kQueueCapacity : 0);
+    ctx.set_counter("queue_depth_max", static_cast<double>(max_depth));
+    ctx.set_counter("queue_wait_p50_us", waited.p50 / 1000.0);
+    ctx.set_counter("queue_wait_p99_us", waited.p99 / 1000.0);
+    ctx.set_counter("dropped", static_cast<double>(lost));
+}
+
+MICROBENCH(fanout_slow_consumer_inline) {
+    run_slow_consumer(ctx, 0, 19400);
+}
+
+MICROBENCH(fanout_slow_consumer_spsc) {
+    run_slow_consumer(ctx, 1, 19401);
+}
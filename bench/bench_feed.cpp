@@ -0,0 +1,143 @@
+#include "bench_harness.hpp"
+#include "deribit_client.hpp"
+#include "feed_monitor.hpp"
+#include "order_book.hpp"
+#include "latency_trace.hpp"
+
+using json = nlohmann::json;
+
+MICROBENCH(route_heartbeat) {
+    DeribitClient client;
+    std::string frame = ctx.fixture_lines("control_frames.jsonl").at(0);
+    ctx.measure([&]() {
+        client.process_message(frame);
+    });
+}
+
+MICROBENCH(route_book_change) {
+    DeribitClient client;
+    size_t routed = 0;
+    client.set_broadcast_callback([&](const std::string&, const std::string&) {
+        ++routed;
+    });
+
+    auto frames = ctx.fixture_lines("book_changes.jsonl");
+    size_t next = 0;
+    ctx.measure([&]() {
+        client.process_message(frames[next]);
+        if (++next == frames.size()) next = 0;
+    });
+    ctx.set_counter("frame_bytes", static_cast<double>(frames[0].size()));
+    do_not_optimize(routed);
+}
+
+// Same as route_book_change with every frame traced, to show tracing cost.
+MICROBENCH(route_book_change_traced) {
+    DeribitClient client;
+    LatencyTrace& trace = LatencyTrace::instance();
+    client.set_broadcast_callback([&](const std::string&, const std::string&) {
+        trace.mark(LatencyTrace::DISPATCH);
+        trace.mark(LatencyTrace::LOCK_ACQUIRE);
+    });
+
+    uint32_t rate = trace.sample_rate();
+    trace.set_sample_rate(1);
+    auto frames = ctx.fixture_lines("book_changes.jsonl");
+    size_t next = 0;
+    ctx.measure([&]() {
+        trace.begin_frame();
+        client.process_message(frames[next]);
+        trace.end_frame();
+        if (++next == frames.size()) next = 0;
+    });
+    trace.set_sample_rate(rate);
+    ctx.set_counter("traced_frames", static_cast<double>(trace.sampled_frames()));
+}
+
+MICROBENCH(route_book_snapshot) {
+    DeribitClient client;
+    size_t routed = 0;
+    client.set_broadcast_callback([&](const std::string&, const std::string&) {
+        ++routed;
+    });
+
+    std::string frame = ctx.fixture_lines("book_snapshot.json").at(0);
+    ctx.measure([&]() {
+        client.process_message(frame);
+    });
+    ctx.set_counter("frame_bytes", static_cast<double>(frame.size()));
+    do_not_optimize(routed);
+}
+
+// Per-frame cost of the upstream health monitor, including the one in 16
+// frames scanned for the exchange timestamp
+MICROBENCH(feed_monitor_frame) {
+    FeedMonitor monitor;
+    monitor.on_probe_reply(monitor.begin_probe(), FeedMonitor::wall_us(), FeedMonitor::wall_us());
+    auto frames = ctx.fixture_lines("book_changes.jsonl");
+    size_t next = 0;
+    ctx.measure([&]() {
+        monitor.on_frame(frames[next]);
+        if (++next == frames.size()) next = 0;
+    });
+    do_not_optimize(monitor.lag_us());
+}
+
+// Probe bookkeeping and the offset estimate over a full window
+MICROBENCH(feed_monitor_probe) {
+    FeedMonitor monitor;
+    ctx.measure([&]() {
+        uint64_t now = FeedMonitor::wall_us();
+        monitor.on_probe_reply(monitor.begin_probe(), now, now + 20);
+    });
+    do_not_optimize(monitor.offset_us());
+}
+
+MICROBENCH(encode_order_payload) {
+    ctx.measure([&]() {
+        std::string body = DeribitClient::build_order_payload("private/buy", "BTC-PERPETUAL", "limit", "10", "60000.5").dump();
+        do_not_optimize(body);
+    });
+}
+
+// Replays the recorded changes on top of the recorded snapshot. The change
+// sequence is repeated with shifted change ids so it stays contiguous.
+MICROBENCH(book_apply_change) {
+    json snapshot = json::parse(ctx.fixture_lines("book_snapshot.json").at(0))["params"]["data"];
+    std::vector<json> recorded;
+    for (const auto& line : ctx.fixture_lines("book_changes.jsonl")) {
+        recorded.push_back(json::parse(line)["params"]["data"]);
+    }
+
+    uint64_t first = recorded.front()["prev_change_id"];
+    uint64_t span = recorded.back()["change_id"].get<uint64_t>() - first;
+    std::vector<json> changes;
+    for (uint64_t round = 0; round < 64; ++round) {
+        for (auto data : recorded) {
+            data["prev_change_id"] = data["prev_change_id"].get<uint64_t>() + round * span;
+            data["change_id"] = data["change_id"].get<uint64_t>() + round * span;
+            changes.push_back(std::move(data));
+        }
+    }
+
+    OrderBook book;
+    book.apply(snapshot);
+    size_t next = 0;
+    ctx.measure([&]() {
+        if (next == changes.size()) {
+            book.apply(snapshot);
+            next = 0;
+        }
+        book.apply(changes[next++]);
+    });
+    ctx.set_counter("levels", static_cast<double>(book.bids().size() + book.asks().size()));
+}
+
+MICROBENCH(book_apply_snapshot) {
+    json snapshot = json::parse(ctx.fixture_lines("book_snapshot.json").at(0))["params"]["data"];
+    OrderBook book;
+    ctx.measure([&]() {
+        book.apply(snapshot);
+    });
+    ctx.set_counter("levels", static_cast<double>(book.bids().size() + book.asks().size()));
+}
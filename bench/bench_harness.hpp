@@ -0,0 +1,95 @@
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "latency_histogram.hpp"
+
+// Keeps the compiler from discarding a value computed inside a benchmark.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+class BenchContext {
+public:
+    BenchContext(const std::string& fixture_dir, double min_time_s)
+        : m_fixture_dir(fixture_dir), m_min_time(std::chrono::duration<double>(min_time_s)) {}
+
+    // Runs op in batches sized to ~10us and records the per-op time of each
+    // batch, until min_time has elapsed.
+    template <typename Op>
+    void measure(Op&& op) {
+        typedef std::chrono::steady_clock clock;
+
+        uint64_t warmup = 0;
+        auto start = clock::now();
+        while (clock::now() - start < std::chrono::milliseconds(2)) {
+            op();
+            ++warmup;
+        }
+        double ns_per_op = std::chrono::duration<double, std::nano>(clock::now() - start).count() / warmup;
+        uint64_t batch = ns_per_op >= 10000.0 ? 1 : static_cast<uint64_t>(10000.0 / ns_per_op) + 1;
+
+        start = clock::now();
+        while (clock::now() - start < m_min_time) {
+            auto t0 = clock::now();
+            for (uint64_t i = 0; i < batch; ++i) op();
+            auto t1 = clock::now();
+            m_histogram.record(static_cast<uint64_t>(std::chrono::duration<double, std::nano>(t1 - t0).count() / batch));
+            m_iterations += batch;
+        }
+    }
+
+    // Times each call of op individually; settle runs untimed after each call
+    // (e.g. to wait for asynchronous delivery before the next sample).
+    template <typename Op, typename Settle>
+    void measure_each(size_t samples, Op&& op, Settle&& settle) {
+        typedef std::chrono::steady_clock clock;
+        for (size_t i = 0; i < samples; ++i) {
+            auto t0 = clock::now();
+            op();
+            m_histogram.record(clock::now() - t0);
+            ++m_iterations;
+            settle();
+        }
+    }
+
+    void set_counter(const std::string& name, double value) { m_counters[name] = value; }
+
+    std::string fixture_path(const std::string& file) const { return m_fixture_dir + "/" + file; }
+    std::vector<std::string> fixture_lines(const std::string& file) const;
+
+    const LatencyHistogram& histogram() const { return m_histogram; }
+    uint64_t iterations() const { return m_iterations; }
+    const std::map<std::string, double>& counters() const { return m_counters; }
+
+private:
+    std::string m_fixture_dir;
+    std::chrono::duration<double> m_min_time;
+    LatencyHistogram m_histogram;
+    uint64_t m_iterations = 0;
+    std::map<std::string, double> m_counters;
+};
+
+struct Benchmark {
+    const char* name;
+    void (*run)(BenchContext&);
+};
+
+std::vector<Benchmark>& benchmark_registry();
+
+struct BenchRegistrar {
+    BenchRegistrar(const char* name, void (*run)(BenchContext&)) {
+        benchmark_registry().push_back({name, run});
+    }
+};
+
+#define MICROBENCH(name) \
+    static void bench_##name(BenchContext& ctx); \
+    static BenchRegistrar registrar_##name(#name, bench_##name); \
+    static void bench_##name(BenchContext& ctx)
+
+#endif
@@ -0,0 +1,75 @@
+#include "bench_harness.hpp"
+#include "instrument_registry.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Per-instrument state looked up by symbol string (hash and compare on every
+// message) against the interned id indexing a flat array.
+namespace {
+std::vector<std::string> option_names(size_t count) {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back("BTC-27DEC24-" + std::to_string(20000 + i * 500) + "-" + (i & 1 ? "P" : "C"));
+    }
+    return names;
+}
+}
+
+MICROBENCH(instrument_lookup_by_name) {
+    std::vector<std::string> names = option_names(1024);
+    std::unordered_map<std::string, double> state;
+    for (const auto& name : names) state[name] = 1.0;
+    size_t i = 0;
+    double sum = 0;
+    ctx.measure([&]() {
+        sum += state.find(names[i++ & 1023])->second;
+    });
+    do_not_optimize(sum);
+}
+
+MICROBENCH(instrument_lookup_by_id) {
+    std::vector<std::string> names = option_names(1024);
+    std::vector<InstrumentId> ids;
+    for (const auto& name : names) ids.push_back(InstrumentRegistry::instance().intern(name));
+    std::vector<double> state(InstrumentRegistry::instance().size(), 1.0);
+    size_t i = 0;
+    double sum = 0;
+    ctx.measure([&]() {
+        sum += state[ids[i++ & 1023]];
+    });
+    do_not_optimize(sum);
+}
+
+// Resolving a name at the edge: shared lock plus hash lookup
+MICROBENCH(instrument_registry_find) {
+    std::vector<std::string> names = option_names(1024);
+    for (const auto& name : names) InstrumentRegistry::instance().intern(name);
+    size_t i = 0;
+    uint64_t sum = 0;
+    ctx.measure([&]() {
+        sum += InstrumentRegistry::instance().find(names[i++ & 1023]);
+    });
+    do_not_optimize(sum);
+}
+
+// Warm start: decoding a cached snapshot of a few thousand instruments
+MICROBENCH(instrument_cache_restore) {
+    InstrumentRegistry& registry = InstrumentRegistry::instance();
+    nlohmann::json instruments = nlohmann::json::array();
+    for (const auto& name : option_names(4096)) {
+        instruments.push_back({{"instrument_name", name}, {"kind", "option"}, {"base_currency", "BTC"},
+                               {"quote_currency", "BTC"}, {"settlement_currency", "BTC"}, {"option_type", "call"},
+                               {"tick_size", 0.0005}, {"contract_size", 1.0}, {"min_trade_amount", 0.1},
+                               {"strike", 60000.0}, {"expiration_timestamp", 1735286400000ULL}});
+    }
+    registry.load("BTC", "option", instruments);
+    std::string path = "/tmp/deribit_bench_instruments.cache";
+    registry.save(path);
+    bool restored = true;
+    ctx.measure([&]() {
+        restored &= registry.restore(path);
+    });
+    ctx.set_counter("instruments", static_cast<double>(instruments.size()));
+    do_not_optimize(restored);
+}
@@ -0,0 +1,68 @@
+#include "bench_harness.hpp"
+#include "tick_journal.hpp"
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static std::string journal_dir(const char* name) {
+    fs::path dir = fs::temp_directory_path() / (std::string("deribit_") + name + "_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    return dir.string();
+}
+
+// Cost added to the feed thread: timestamp plus enqueue. The payload copy
+// stands in for the buffer the feed thread would otherwise hand over.
+MICROBENCH(journal_append) {
+    TickJournal::Options options;
+    options.directory = journal_dir("journal_append");
+    TickJournal journal(options);
+    journal.start();
+
+    std::string frame = ctx.fixture_lines("book_changes.jsonl").at(0);
+    ctx.measure([&]() {
+        journal.append(TickJournal::now_ns(), std::string(frame));
+    });
+    journal.stop();
+    ctx.set_counter("written", static_cast<double>(journal.frames_written()));
+    ctx.set_counter("dropped", static_cast<double>(journal.dropped()));
+    fs::remove_all(options.directory);
+}
+
+// Sustained writer throughput: each sample enqueues a burst of recorded
+// frames and waits for the writer to frame them into the mapped segment.
+MICROBENCH(journal_write_burst) {
+    TickJournal::Options options;
+    options.directory = journal_dir("journal_burst");
+    options.segment_bytes = 16 << 20;
+    TickJournal journal(options);
+    journal.start();
+
+    auto frames = ctx.fixture_lines("book_changes.jsonl");
+    const size_t burst = 8192;
+    uint64_t target = 0;
+    auto start = std::chrono::steady_clock::now();
+    ctx.measure_each(50, [&]() {
+        for (size_t i = 0; i < burst; ++i) {
+            while (!journal.append(TickJournal::now_ns(), std::string(frames[i % frames.size()]))) {
+                std::this_thread::yield();
+            }
+        }
+        target += burst;
+        while (journal.frames_written() < target) std::this_thread::yield();
+    }, []() {});
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    journal.stop();
+
+    ctx.set_counter("frames_per_s", journal.frames_written() / seconds);
+    ctx.set_counter("mb_per_s", journal.bytes_written() / seconds / (1 << 20));
+    ctx.set_counter("segments", static_cast<double>(journal.segments()));
+
+    size_t read = 0;
+    TickJournalReader reader(options.directory);
+    TickJournalReader::Record record;
+    while (reader.next(record)) ++read;
+    ctx.set_counter("read_back", static_cast<double>(read));
+    fs::remove_all(options.directory);
+}
@@ -0,0 +1,102 @@
+#include "bench_harness.hpp"
+#include "market_data_publisher.hpp"
+#include "thread_affinity.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+static std::string bench_bus_name() {
+    return "/deribit-md-bench-" + std::to_string(::getpid());
+}
+
+static OrderBook recorded_book(BenchContext& ctx) {
+    json snapshot = json::parse(ctx.fixture_lines("book_snapshot.json").at(0))["params"]["data"];
+    OrderBook book(snapshot["instrument_name"].get<std::string>());
+    book.apply(snapshot);
+    return book;
+}
+
+// Writing one book to its slot and the ring, on the feed thread
+MICROBENCH(mdbus_publish) {
+    MarketDataPublisher::Options options;
+    options.name = bench_bus_name();
+    MarketDataPublisher publisher(options);
+    OrderBook book = recorded_book(ctx);
+    ctx.measure([&]() {
+        publisher.publish(book);
+    });
+}
+
+// What a co-located consumer pays per update: the bus reader takes the next
+// ring record and copies the book (the publish is included)...
+MICROBENCH(mdbus_consume_update) {
+    MarketDataPublisher::Options options;
+    options.name = bench_bus_name();
+    MarketDataPublisher publisher(options);
+    MarketDataBusReader reader(options.name);
+    OrderBook book = recorded_book(ctx);
+    mdbus::Update update{};
+    ctx.measure([&]() {
+        publisher.publish(book);
+        reader.poll(update);
+        mdbus::Book copy = reader.book(update.slot);
+        do_not_optimize(copy);
+    });
+    ctx.set_counter("lost", static_cast<double>(reader.lost()));
+}
+
+// ...against a WebSocket subscriber, which parses the JSON frame and applies
+// it to its own book (framing and TCP not included; see fanout_loadgen --bus-readers).
+MICROBENCH(mdbus_websocket_consume_update) {
+    std::string frame = ctx.fixture_lines("book_snapshot.json").at(0);
+    OrderBook book;
+    ctx.measure([&]() {
+        json message = json::parse(frame);
+        book.apply(message["params"]["data"]);
+        do_not_optimize(book);
+    });
+    ctx.set_counter("frame_bytes", static_cast<double>(frame.size()));
+}
+
+// Publish to a reader on another thread, mapped separately as another
+// process would. The reader spins on poll() when it has a core to itself
+// and yields otherwise.
+MICROBENCH(mdbus_delivery) {
+    MarketDataPublisher::Options options;
+    options.name = bench_bus_name();
+    MarketDataPublisher publisher(options);
+    OrderBook book = recorded_book(ctx);
+    bool spin = std::thread::hardware_concurrency() > 1;
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> seen{0};
+    std::thread consumer([&]() {
+        MarketDataBusReader reader(options.name);
+        mdbus::Update update{};
+        while (running.load(std::memory_order_relaxed)) {
+            if (reader.poll(update)) {
+                seen.store(update.sequence + 1, std::memory_order_release);
+            } else if (spin) {
+                ThreadAffinity::cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    uint64_t sequence = 0;
+    ctx.measure_each(10000, [&]() {
+        publisher.publish(book);
+        ++sequence;
+        while (seen.load(std::memory_order_acquire) < sequence) {
+            if (!spin) std::this_thread::yield();
+        }
+    }, []() {});
+    running = false;
+    consumer.join();
+    ctx.set_counter("spinning_reader", spin);
+}
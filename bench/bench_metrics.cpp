@@ -0,0 +1,35 @@
+#include "bench_harness.hpp"
+#include "metrics.hpp"
+#include "performance_tracker.hpp"
+
+MICROBENCH(metrics_counter_inc) {
+    Counter& counter = MetricsRegistry::instance().counter("bench_counter_total", "Microbenchmark counter");
+    ctx.measure([&]() {
+        counter.inc();
+    });
+}
+
+MICROBENCH(metrics_histogram_record) {
+    LatencyHistogram& histogram = MetricsRegistry::instance().histogram("bench_latency_seconds", "Microbenchmark histogram");
+    uint64_t value = 1000;
+    ctx.measure([&]() {
+        histogram.record(value);
+        value = value * 7 % 1000003;
+    });
+}
+
+MICROBENCH(metrics_render) {
+    std::string text;
+    ctx.measure([&]() {
+        text = MetricsRegistry::instance().render();
+        do_not_optimize(text);
+    });
+    ctx.set_counter("bytes", static_cast<double>(text.size()));
+}
+
+MICROBENCH(scoped_timer) {
+    ctx.measure([&]() {
+        PERF_SCOPE("bench.scoped_timer");
+    });
+    ctx.set_counter("drained", static_cast<double>(perf::drain()));
+}
@@ -0,0 +1,58 @@
+#include "bench_harness.hpp"
+#include "order_cache.hpp"
+
+using json = nlohmann::json;
+
+static json bench_order(int i, const std::string& state) {
+    return {
+        {"order_id", "ETH-" + std::to_string(i)},
+        {"label", "bench-" + std::to_string(i % 64)},
+        {"instrument_name", i % 2 ? "ETH-PERPETUAL" : "BTC-PERPETUAL"},
+        {"direction", i % 3 ? "buy" : "sell"},
+        {"order_type", "limit"},
+        {"order_state", state},
+        {"price", 2000.0 + i % 100},
+        {"amount", 10.0},
+        {"filled_amount", 0.0},
+        {"creation_timestamp", uint64_t(1700000000000) + i},
+        {"last_update_timestamp", uint64_t(1700000000000) + i}
+    };
+}
+
+static void fill_cache(OrderCache& cache, int orders) {
+    for (int i = 0; i < orders; ++i) cache.apply_order(bench_order(i, i % 10 == 1 ? "open" : "filled"));
+}
+
+MICROBENCH(order_cache_apply) {
+    std::vector<json> updates;
+    for (int i = 0; i < 10000; ++i) updates.push_back(bench_order(i, "open"));
+    OrderCache cache;
+    size_t i = 0;
+    ctx.measure([&]() {
+        json& update = updates[i++ % updates.size()];
+        update["last_update_timestamp"] = update["last_update_timestamp"].get<uint64_t>() + 1;
+        cache.apply_order(update);
+    });
+}
+
+MICROBENCH(order_cache_find) {
+    OrderCache cache;
+    fill_cache(cache, 10000);
+    int i = 0;
+    ctx.measure([&]() {
+        auto order = cache.find("ETH-" + std::to_string(i++ % 10000));
+        do_not_optimize(order);
+    });
+}
+
+MICROBENCH(order_cache_open_orders) {
+    OrderCache cache;
+    fill_cache(cache, 10000);
+    size_t count = 0;
+    ctx.measure([&]() {
+        auto orders = cache.open_orders("ETH-PERPETUAL");
+        count = orders.size();
+        do_not_optimize(orders);
+    });
+    ctx.set_counter("orders", static_cast<double>(count));
+}
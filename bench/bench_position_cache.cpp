@@ -0,0 +1,57 @@
+#include "bench_harness.hpp"
+#include "position_cache.hpp"
+#include <atomic>
+#include <thread>
+
+using json = nlohmann::json;
+
+static void seed_positions(PositionCache& cache, int count) {
+    json positions = json::array();
+    for (int i = 0; i < count; ++i) {
+        positions.push_back({
+            {"instrument_name", "BTC-" + std::to_string(27000 + i * 500) + "-C"},
+            {"kind", "option"},
+            {"size", 1.0 + i},
+            {"average_price", 0.05},
+            {"mark_price", 0.05},
+            {"floating_profit_loss", 0.0},
+            {"realized_profit_loss", 0.0}
+        });
+    }
+    positions.push_back({
+        {"instrument_name", "BTC-PERPETUAL"}, {"kind", "future"}, {"size", 10000.0},
+        {"average_price", 60000.0}, {"mark_price", 60000.0}, {"floating_profit_loss", 0.0}
+    });
+    cache.seed("BTC", positions);
+}
+
+// Snapshot read while the feed thread revalues the same position.
+MICROBENCH(position_cache_read) {
+    PositionCache cache;
+    seed_positions(cache, 32);
+    std::atomic<bool> running{true};
+    std::thread ticker([&]() {
+        double mark = 60000.0;
+        while (running.load(std::memory_order_relaxed)) {
+            cache.on_mark_price("BTC-PERPETUAL", mark);
+            mark = mark == 60000.0 ? 60000.5 : 60000.0;
+        }
+    });
+    PositionCache::Position position;
+    ctx.measure([&]() {
+        cache.position("BTC-PERPETUAL", position);
+        do_not_optimize(position);
+    });
+    running = false;
+    ticker.join();
+}
+
+MICROBENCH(position_cache_mark_tick) {
+    PositionCache cache;
+    seed_positions(cache, 32);
+    double mark = 60000.0;
+    ctx.measure([&]() {
+        cache.on_mark_price("BTC-PERPETUAL", mark);
+        mark += 0.5;
+    });
+}
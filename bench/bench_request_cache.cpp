@@ -0,0 +1,58 @@
+#include "bench_harness.hpp"
+#include "request_cache.hpp"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Answering a public call from the cache instead of the exchange
+MICROBENCH(rest_cache_hit) {
+    RequestCache<std::string> cache;
+    std::string key = R"({"id":1,"jsonrpc":"2.0","method":"public/get_order_book","params":{"depth":1,"instrument_name":"BTC-PERPETUAL"}})";
+    std::string body = ctx.fixture_lines("rest_responses.jsonl").at(3);
+    ctx.measure([&]() {
+        std::string r = cache.get("public/get_order_book", key, std::chrono::minutes(1), [&]() { return body; });
+        do_not_optimize(r);
+    });
+}
+
+// Eight callers asking for the same book at once, against a 2 ms round
+// trip and no TTL: the burst costs one fetch instead of eight. The fetch is
+// held until the other seven have joined it, so a late caller cannot start a
+// second one, and the benchmark fails unless every burst fetched exactly once.
+MICROBENCH(rest_cache_burst) {
+    constexpr size_t kCallers = 8;
+    constexpr size_t kBursts = 50;
+    RequestCache<std::string> cache;
+    Counter& coalesced = MetricsRegistry::instance().counter("deribit_rest_cache_requests_total", "Cacheable REST lookups by method and result",
+        MetricsRegistry::label("method", "public/get_order_book") + "," + MetricsRegistry::label("result", "coalesced"));
+    std::atomic<uint64_t> joined{0};   // coalesced count once every other caller waits
+    std::atomic<uint64_t> fetches{0};
+    auto fetch = [&]() {
+        fetches.fetch_add(1, std::memory_order_relaxed);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (coalesced.value() < joined.load() && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return std::string("{}");
+    };
+
+    ctx.measure_each(kBursts, [&]() {
+        joined.store(coalesced.value() + kCallers - 1);
+        std::atomic<bool> go{false};
+        std::vector<std::thread> callers;
+        for (size_t i = 0; i < kCallers; ++i) {
+            callers.emplace_back([&]() {
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                do_not_optimize(cache.get("public/get_order_book", "book", std::chrono::milliseconds(0), fetch));
+            });
+        }
+        go.store(true, std::memory_order_release);
+        for (auto& caller : callers) caller.join();
+    }, []() {});
+    ctx.set_counter("callers", kCallers);
+    ctx.set_counter("fetches_per_burst", static_cast<double>(fetches.load()) / kBursts);
+    if (fetches.load() != kBursts) {
+        throw std::runtime_error(std::to_string(fetches.load()) + " fetches for " + std::to_string(kBursts) + " bursts, expected one each");
+    }
+}
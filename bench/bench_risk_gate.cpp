@@ -0,0 +1,62 @@
+#include "bench_harness.hpp"
+#include "risk_gate.hpp"
+#include <string>
+#include <vector>
+
+// Cost added to the order path: one instrument lookup plus the limit checks,
+// with a few hundred instruments in the table.
+MICROBENCH(risk_gate_check) {
+    RiskGate::Limits limits;
+    limits.max_order_amount = 1000;
+    limits.max_notional = 1e8;
+    limits.max_position = 1e6;
+    limits.price_collar = 0.05;
+    RiskGate gate(limits);
+
+    std::vector<std::string> instruments;
+    for (int i = 0; i < 256; ++i) {
+        instruments.push_back("BTC-" + std::to_string(27000 + i * 500) + "-C");
+        gate.update_bbo(instruments.back(), 60000.0, 60000.5);
+    }
+    size_t i = 0;
+    size_t passed = 0;
+    ctx.measure([&]() {
+        const std::string& instrument = instruments[i++ & 255];
+        passed += gate.check(instrument, i & 1, 10, 60000.0) == RiskGate::PASS;
+    });
+    ctx.set_counter("passed", static_cast<double>(passed));
+}
+
+// Same check with the instrument already resolved to its id
+MICROBENCH(risk_gate_check_by_id) {
+    RiskGate::Limits limits;
+    limits.max_order_amount = 1000;
+    limits.max_notional = 1e8;
+    limits.max_position = 1e6;
+    limits.price_collar = 0.05;
+    RiskGate gate(limits);
+
+    std::vector<InstrumentId> instruments;
+    for (int i = 0; i < 256; ++i) {
+        std::string name = "BTC-" + std::to_string(27000 + i * 500) + "-C";
+        gate.update_bbo(name, 60000.0, 60000.5);
+        instruments.push_back(InstrumentRegistry::instance().intern(name));
+    }
+    size_t i = 0;
+    size_t passed = 0;
+    ctx.measure([&]() {
+        InstrumentId instrument = instruments[i++ & 255];
+        passed += gate.check(instrument, i & 1, 10, 60000.0) == RiskGate::PASS;
+    });
+    ctx.set_counter("passed", static_cast<double>(passed));
+}
+
+MICROBENCH(risk_gate_update_bbo) {
+    RiskGate gate(RiskGate::Limits{});
+    std::string instrument = "BTC-PERPETUAL";
+    double price = 60000.0;
+    ctx.measure([&]() {
+        gate.update_bbo(instrument, price, price + 0.5);
+        price += 0.5;
+    });
+}
@@ -0,0 +1,46 @@
+#include "bench_harness.hpp"
+#include "rpc_decoder.hpp"
+
+using json = nlohmann::json;
+
+// Recorded REST responses, one per line: private/buy, private/cancel,
+// private/get_positions, public/get_order_book (20 levels a side) and
+// public/get_instruments (200 options)
+enum RestResponse { ORDER_ACK, CANCEL, POSITIONS, ORDER_BOOK, INSTRUMENTS };
+
+static std::string rest_response(BenchContext& ctx, RestResponse which) {
+    return ctx.fixture_lines("rest_responses.jsonl").at(which);
+}
+
+// Typed decode from the body in place, as the managers now do...
+template<typename Decode>
+static void bench_decode(BenchContext& ctx, RestResponse which, Decode decode) {
+    std::string body = rest_response(ctx, which);
+    ctx.measure([&]() {
+        auto result = decode(body);
+        do_not_optimize(result);
+    });
+    ctx.set_counter("body_bytes", static_cast<double>(body.size()));
+}
+
+// ...against the DOM parse and pretty-printed result they used to return
+static void bench_dom(BenchContext& ctx, RestResponse which) {
+    std::string body = rest_response(ctx, which);
+    ctx.measure([&]() {
+        json j = json::parse(body);
+        std::string rendered = j["result"].dump(4);
+        do_not_optimize(rendered);
+    });
+    ctx.set_counter("body_bytes", static_cast<double>(body.size()));
+}
+
+MICROBENCH(decode_order_ack) { bench_decode(ctx, ORDER_ACK, rpc::decode_order_ack); }
+MICROBENCH(decode_order_ack_dom) { bench_dom(ctx, ORDER_ACK); }
+MICROBENCH(decode_cancel) { bench_decode(ctx, CANCEL, rpc::decode_order); }
+MICROBENCH(decode_cancel_dom) { bench_dom(ctx, CANCEL); }
+MICROBENCH(decode_positions) { bench_decode(ctx, POSITIONS, rpc::decode_positions); }
+MICROBENCH(decode_positions_dom) { bench_dom(ctx, POSITIONS); }
+MICROBENCH(decode_book) { bench_decode(ctx, ORDER_BOOK, rpc::decode_book); }
+MICROBENCH(decode_book_dom) { bench_dom(ctx, ORDER_BOOK); }
+MICROBENCH(decode_instruments) { bench_decode(ctx, INSTRUMENTS, rpc::decode_instruments); }
+MICROBENCH(decode_instruments_dom) { bench_dom(ctx, INSTRUMENTS); }
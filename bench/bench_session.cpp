@@ -0,0 +1,16 @@
+#include "bench_harness.hpp"
+#include "deribit_client.hpp"
+#include <memory>
+
+// What each DeribitClient costs to set up: its websocketpp endpoint, asio
+// context and rate limiter. Managers and the local server used to each
+// build their own copy; they now share the one session.
+MICROBENCH(session_construct) {
+    std::unique_ptr<DeribitClient> client;
+    ctx.measure_each(200, [&]() {
+        client.reset(new DeribitClient());
+    }, [&]() {
+        client.reset();
+    });
+    ctx.set_counter("object_bytes", static_cast<double>(sizeof(DeribitClient)));
+}
@@ -0,0 +1,109 @@
+#include "bench_harness.hpp"
+#include "snapshot_store.hpp"
+#include "tick_journal.hpp"
+#include <filesystem>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+// The recorded snapshot and changes replayed for 64 rounds with shifted
+// change ids and timestamps. The same frames go to a tick journal and, as
+// a top-10 snapshot after every update, to a snapshot store.
+struct StoreFixture {
+    std::string journal_dir;
+    std::string store_dir;
+    uint64_t journal_bytes = 0;
+    uint64_t store_bytes = 0;
+    uint64_t rows = 0;
+
+    explicit StoreFixture(BenchContext& ctx) {
+        std::string base = (fs::temp_directory_path() / ("deribit_store_" + std::to_string(::getpid()))).string();
+        journal_dir = base + "/journal";
+        store_dir = base + "/store";
+        fs::remove_all(base);
+
+        json snapshot = json::parse(ctx.fixture_lines("book_snapshot.json").at(0));
+        std::vector<json> recorded;
+        for (const auto& line : ctx.fixture_lines("book_changes.jsonl")) recorded.push_back(json::parse(line));
+        const json& first = recorded.front()["params"]["data"];
+        const json& last = recorded.back()["params"]["data"];
+        uint64_t id_span = last["change_id"].get<uint64_t>() - first["prev_change_id"].get<uint64_t>();
+        uint64_t time_span = last["timestamp"].get<uint64_t>() - first["timestamp"].get<uint64_t>() + 1;
+
+        TickJournal::Options journal_options;
+        journal_options.directory = journal_dir;
+        TickJournal journal(journal_options);
+        journal.start();
+        SnapshotStoreWriter::Options store_options;
+        store_options.directory = store_dir;
+        SnapshotStoreWriter store(store_options);
+
+        OrderBook book(snapshot["params"]["data"]["instrument_name"].get<std::string>());
+        book.apply(snapshot["params"]["data"]);
+        journal.append(TickJournal::now_ns(), snapshot.dump());
+        store.add_snapshot(book);
+        for (uint64_t round = 0; round < 64; ++round) {
+            for (auto frame : recorded) {
+                json& data = frame["params"]["data"];
+                data["prev_change_id"] = data["prev_change_id"].get<uint64_t>() + round * id_span;
+                data["change_id"] = data["change_id"].get<uint64_t>() + round * id_span;
+                data["timestamp"] = data["timestamp"].get<uint64_t>() + round * time_span;
+                book.apply(data);
+                while (!journal.append(TickJournal::now_ns(), frame.dump())) std::this_thread::yield();
+                store.add_snapshot(book);
+            }
+        }
+        journal.stop();
+        store.close();
+        journal_bytes = journal.bytes_written();
+        store_bytes = store.bytes_written();
+        rows = store.rows_written();
+    }
+
+    ~StoreFixture() {
+        fs::remove_all(fs::path(journal_dir).parent_path());
+    }
+};
+
+MICROBENCH(store_scan_top_of_book) {
+    StoreFixture fixture(ctx);
+    SnapshotStore store(fixture.store_dir);
+    std::string instrument = store.instruments().at(0);
+    std::vector<snapshot_store::Column> columns = {
+        {snapshot_store::BID_PRICE, 0}, {snapshot_store::ASK_PRICE, 0}
+    };
+
+    size_t rows = 0;
+    ctx.measure([&]() {
+        auto result = store.query_snapshots(instrument, 0, UINT64_MAX, columns);
+        rows = result.timestamps.size();
+        do_not_optimize(result);
+    });
+    ctx.set_counter("rows", static_cast<double>(rows));
+    ctx.set_counter("store_bytes", static_cast<double>(fixture.store_bytes));
+    ctx.set_counter("journal_bytes", static_cast<double>(fixture.journal_bytes));
+    ctx.set_counter("compression_ratio", static_cast<double>(fixture.journal_bytes) / fixture.store_bytes);
+}
+
+// Baseline: the same question answered from the raw journal by replaying
+// every frame into a book.
+MICROBENCH(journal_scan_top_of_book) {
+    StoreFixture fixture(ctx);
+    size_t rows = 0;
+    ctx.measure([&]() {
+        TickJournalReader reader(fixture.journal_dir);
+        TickJournalReader::Record record;
+        OrderBook book;
+        rows = 0;
+        double spread = 0.0;
+        while (reader.next(record)) {
+            json frame = json::parse(record.payload);
+            book.apply(frame["params"]["data"]);
+            if (book.best_bid() && book.best_ask()) spread += book.best_ask()->price - book.best_bid()->price;
+            ++rows;
+        }
+        do_not_optimize(spread);
+    });
+    ctx.set_counter("rows", static_cast<double>(rows));
+}
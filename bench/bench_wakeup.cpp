@@ -0,0 +1,49 @@
+#include "bench_harness.hpp"
+#include "thread_affinity.hpp"
+#include <boost/asio/io_service.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+// Wake-up latency of an io loop: time from posting a handler on another
+// thread until it has run, with the loop blocked in epoll (run) and
+// spinning on poll(). The consumer is pinned to the last core. Busy-poll
+// needs a core of its own, so it is skipped on a single-core machine.
+static void run_wakeup(BenchContext& ctx, bool busy_poll) {
+    ThreadAffinity& affinity = ThreadAffinity::instance();
+    unsigned cores = std::thread::hardware_concurrency();
+    ctx.set_counter("cores", cores);
+    if (busy_poll && cores < 2) return;
+    affinity.set_cpus(ThreadAffinity::FEED, cores > 1 ? std::vector<int>{static_cast<int>(cores) - 1} : std::vector<int>{});
+    affinity.set_busy_poll(busy_poll);
+
+    boost::asio::io_service io;
+    std::unique_ptr<boost::asio::io_service::work> work(new boost::asio::io_service::work(io));
+    std::thread loop([&]() {
+        affinity.pin_current_thread(ThreadAffinity::FEED);
+        affinity.run(io);
+    });
+
+    std::atomic<bool> done{false};
+    ctx.measure_each(10000, [&]() {
+        done.store(false, std::memory_order_relaxed);
+        io.post([&]() { done.store(true, std::memory_order_release); });
+        while (!done.load(std::memory_order_acquire)) ThreadAffinity::cpu_relax();
+    }, []() {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    });
+
+    work.reset();
+    io.stop();
+    loop.join();
+    affinity.set_busy_poll(false);
+    affinity.set_cpus(ThreadAffinity::FEED, {});
+}
+
+MICROBENCH(wakeup_io_run) {
+    run_wakeup(ctx, false);
+}
+
+MICROBENCH(wakeup_io_busy_poll) {
+    run_wakeup(ctx, true);
+}
@@ -0,0 +1,91 @@
+#ifndef LOOPBACK_FANOUT_HPP
+#define LOOPBACK_FANOUT_HPP
+
+#include "websocket_manager.hpp"
+#include "instrument_registry.hpp"
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+typedef websocketpp::client<websocketpp::config::asio_client> loopback_client;
+
+// A WebSocketServer on loopback with a number of clients subscribed to one
+// channel. start() returns once every subscription is confirmed; the
+// destructor shuts the clients and the server down.
+class LoopbackFanout {
+public:
+    LoopbackFanout(size_t fanout_workers, size_t queue_capacity)
+        : server(upstream, fanout_workers, queue_capacity) {
+        InstrumentRegistry::instance().intern("BTC-PERPETUAL");
+        clients.clear_access_channels(websocketpp::log::alevel::all);
+        clients.clear_error_channels(websocketpp::log::elevel::all);
+        clients.init_asio();
+        clients.set_open_handler([this](websocketpp::connection_hdl hdl) {
+            clients.send(hdl, R"({"action":"subscribe","symbol":"BTC-PERPETUAL"})", websocketpp::frame::opcode::text);
+        });
+        clients.set_message_handler([this](websocketpp::connection_hdl, loopback_client::message_ptr msg) {
+            if (msg->get_payload().compare(0, 10, "{\"status\":") == 0) {
+                ++confirmed;
+            } else {
+                ++received;
+            }
+        });
+    }
+
+    ~LoopbackFanout() {
+        clients.stop();
+        server.stop();
+        if (client_thread.joinable()) client_thread.join();
+        if (server_thread.joinable()) server_thread.join();
+    }
+
+    void start(size_t subscribers, uint16_t port) {
+        server_thread = std::thread([this, port]() {
+            server.run(port);
+        });
+        while (!server.is_running()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        std::string uri = "ws://127.0.0.1:" + std::to_string(port);
+        for (size_t i = 0; i < subscribers; ++i) {
+            websocketpp::lib::error_code ec;
+            auto con = clients.get_connection(uri, ec);
+            if (ec) throw std::runtime_error("Loopback connect failed: " + ec.message());
+            clients.connect(con);
+        }
+        client_thread = std::thread([this]() {
+            clients.run();
+        });
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (confirmed < subscribers && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (confirmed < subscribers) {
+            throw std::runtime_error(std::to_string(confirmed.load()) + " of " + std::to_string(subscribers) + " subscribers confirmed");
+        }
+    }
+
+    // False if received has not reached expected within timeout
+    bool wait_received(size_t expected, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (received < expected) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    DeribitClient upstream;
+    WebSocketServer server;
+    loopback_client clients;
+    std::thread server_thread;
+    std::thread client_thread;
+    std::atomic<size_t> confirmed{0};
+    std::atomic<size_t> received{0};
+};
+
+#endif
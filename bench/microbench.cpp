@@ -0,0 +1,130 @@
+#include "bench_harness.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+#ifndef BENCH_FIXTURE_DIR
+#define BENCH_FIXTURE_DIR "bench/fixtures"
+#endif
+
+std::vector<Benchmark>& benchmark_registry() {
+    static std::vector<Benchmark> registry;
+    return registry;
+}
+
+std::vector<std::string> BenchContext::fixture_lines(const std::string& file) const {
+    std::ifstream in(fixture_path(file));
+    if (!in) throw std::runtime_error("Missing fixture: " + fixture_path(file));
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) lines.push_back(line);
+    }
+    return lines;
+}
+
+void usage() {
+    std::cout << "Usage: deribit_microbench [--filter SUBSTRING] [--min-time SECONDS] [--fixtures DIR]" << std::endl;
+    std::cout << "                          [--json PATH] [--csv PATH] [--list]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter, json_path, csv_path;
+    std::string fixture_dir = BENCH_FIXTURE_DIR;
+    double min_time = 0.5;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--list") {
+            list = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        if (arg == "--filter") filter = argv[++i];
+        else if (arg == "--min-time") {
+            std::string text = argv[++i];
+            try {
+                size_t used = 0;
+                min_time = std::stod(text, &used);
+                if (used != text.size() || !(min_time > 0) || !std::isfinite(min_time)) throw std::invalid_argument(text);
+            } catch (const std::exception&) {
+                std::cerr << "Invalid value for --min-time: " << text << std::endl;
+                usage();
+                return 1;
+            }
+        }
+        else if (arg == "--fixtures") fixture_dir = argv[++i];
+        else if (arg == "--json") json_path = argv[++i];
+        else if (arg == "--csv") csv_path = argv[++i];
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    // Sorted so output order is stable across builds for diffing.
+    auto benchmarks = benchmark_registry();
+    std::sort(benchmarks.begin(), benchmarks.end(), [](const Benchmark& a, const Benchmark& b) {
+        return std::strcmp(a.name, b.name) < 0;
+    });
+
+    if (list) {
+        for (const auto& benchmark : benchmarks) std::cout << benchmark.name << std::endl;
+        return 0;
+    }
+
+    nlohmann::json results = nlohmann::json::array();
+    std::string csv = std::string(LatencyHistogram::csv_header()) + ",iterations\n";
+    std::vector<std::string> report;
+    size_t failed = 0;
+
+    for (const auto& benchmark : benchmarks) {
+        if (!filter.empty() && std::string(benchmark.name).find(filter) == std::string::npos) continue;
+
+        BenchContext ctx(fixture_dir, min_time);
+        try {
+            benchmark.run(ctx);
+        } catch (const std::exception& e) {
+            std::cerr << benchmark.name << " failed: " << e.what() << std::endl;
+            ++failed;
+            continue;
+        }
+
+        auto s = ctx.histogram().summary();
+        nlohmann::json entry = LatencyHistogram::to_json(s);
+        entry["name"] = benchmark.name;
+        entry["iterations"] = ctx.iterations();
+        entry["counters"] = ctx.counters();
+        results.push_back(entry);
+        csv += LatencyHistogram::to_csv_row(benchmark.name, s) + "," + std::to_string(ctx.iterations()) + "\n";
+
+        std::string line = std::string(benchmark.name) + ": p50=" + std::to_string(s.p50) + "ns p99=" +
+                           std::to_string(s.p99) + "ns max=" + std::to_string(s.max) + "ns";
+        for (const auto& counter : ctx.counters()) {
+            line += " " + counter.first + "=" + std::to_string(counter.second);
+        }
+        report.push_back(line);
+    }
+
+    std::cout << "Microbenchmark results (per operation):" << std::endl;
+    for (const auto& line : report) std::cout << "  " << line << std::endl;
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        out << nlohmann::json{{"benchmarks", results}}.dump(4) << std::endl;
+    }
+    if (!csv_path.empty()) {
+        std::ofstream out(csv_path);
+        out << csv;
+    }
+    return failed ? 1 : 0;
+}
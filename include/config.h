@@ -1,12 +1,34 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <cstdint>
 #include <string>
 
 extern std::string CLIENT_ID;
 extern std::string CLIENT_SECRET;
 extern std::string BASE_URL;
 extern std::string WEB_SOCKET_URL;
+extern uint32_t TRACE_SAMPLE_RATE;
+extern uint16_t METRICS_PORT;
+extern std::string JOURNAL_DIR;
+extern size_t JOURNAL_SEGMENT_MB;
+extern size_t ORDER_WORKERS;
+extern size_t ORDER_QUEUE_CAPACITY;
+extern double RATE_LIMIT_MATCHING_BURST;
+extern double RATE_LIMIT_MATCHING_PER_SEC;
+extern double RATE_LIMIT_NON_MATCHING_BURST;
+extern double RATE_LIMIT_NON_MATCHING_PER_SEC;
+extern std::string RISK_LIMITS_FILE;
+extern std::string INSTRUMENT_CACHE_FILE;
+extern size_t FANOUT_WORKERS;
+extern size_t FANOUT_QUEUE_CAPACITY;
+extern std::string MARKET_DATA_BUS;
+extern std::string MARKET_DATA_BUS_SYMBOLS;
+extern uint32_t HEARTBEAT_INTERVAL;
+extern uint32_t PROBE_INTERVAL_MS;
+extern uint64_t FEED_STALE_MS;
+extern uint64_t FEED_LAG_THRESHOLD_MS;
+extern std::string REST_CACHE_TTL_MS;
 
 void loadConfig();
 
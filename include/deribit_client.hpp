@@ -10,12 +10,28 @@
 #include <nlohmann/json.hpp>
 #include <thread>
 #include "logger.hpp"
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
+class TickJournal;
+class RateLimiter;
+class FeedMonitor;
+template<typename T> class RequestCache;
+
+// The process's one exchange session: a single upstream WebSocket, one
+// token state and a pool of keep-alive HTTP sessions. Managers and the local
+// server hold a reference to it; REST calls are safe from any thread.
 class DeribitClient {
 public:
     DeribitClient();
-    DeribitClient(DeribitClient& other);
+    DeribitClient(const DeribitClient&) = delete;
+    DeribitClient& operator=(const DeribitClient&) = delete;
     ~DeribitClient();
 
     // REST API methods
@@ -23,22 +39,53 @@ public:
     cpr::Response refresh();
     cpr::Response place_buy_order(const std::string& instrument_name, const std::string& side, 
                                  const std::string& type, const std::string& amount, 
-                                 const std::string& price);
+                                 const std::string& price, const std::string& label = "label");
     cpr::Response place_sell_order(const std::string& instrument_name, const std::string& side, 
                                   const std::string& type, const std::string& amount, 
-                                  const std::string& price);
+                                  const std::string& price, const std::string& label = "label");
     cpr::Response get_all_instruments(const std::string& currency, const std::string& kind);
+    cpr::Response get_instrument(const std::string& instrument_name);
     cpr::Response get_positions(const std::string& currency, const std::string& kind);
+    cpr::Response get_open_orders(const std::string& currency);
     cpr::Response get_order_book(const std::string& instrument_name);
     cpr::Response cancel_order(const std::string& order_id);
+    // Result is the number of orders cancelled
+    cpr::Response cancel_all();
+    cpr::Response cancel_all_by_instrument(const std::string& instrument_name);
+    cpr::Response cancel_by_label(const std::string& label);
     cpr::Response edit_order(const std::string& order_id, const std::string& quantity, 
                             const std::string& price);
 
+    // JSON-RPC payload for private/buy and private/sell
+    static nlohmann::json build_order_payload(const std::string& method, const std::string& instrument_name,
+                                              const std::string& type, const std::string& amount,
+                                              const std::string& price, const std::string& label = "label");
+
     // WebSocket methods
+    // Opens the upstream connection; later calls do nothing.
     void connect_websocket();
+    // Stops the io thread and joins it; no listener or callback runs after
+    // this returns. Owners of listener targets call it before they go away.
+    void stop_websocket();
     void subscribe_to_channel(const std::string& channel);
+    // Channel updates for the local server; pass nullptr to detach.
     void set_broadcast_callback(std::function<void(const std::string&, const std::string&)> callback);
-    bool is_websocket_connected() const { return m_ws_hdl.lock() != nullptr; }
+    // Parsed data of channels starting with prefix. Register before connect_websocket.
+    typedef std::function<void(const std::string&, const nlohmann::json&)> ChannelListener;
+    void add_channel_listener(const std::string& prefix, ChannelListener listener);
+    // Subscribes to a channel that needs an authenticated connection. Kept and
+    // re-sent after every WebSocket authentication.
+    void subscribe_private(const std::string& channel);
+    // The same for a public channel, re-sent on every connect; it needs no
+    // credentials.
+    void subscribe_public(const std::string& channel);
+    // Parses and routes one upstream frame (heartbeats, auth replies, channel data)
+    void process_message(const std::string& payload);
+    bool is_websocket_connected() const;
+    // Every upstream frame is appended to the journal once routed. Not owned.
+    void set_journal(TickJournal* journal) { m_journal = journal; }
+    // Round trip, clock offset and lag of the upstream feed
+    const FeedMonitor& feed_monitor() const { return *m_feed_monitor; }
     
     friend std::ostream& operator<<(std::ostream& os, const DeribitClient& client);
     
@@ -47,6 +94,10 @@ private:
     // REST API helpers
     cpr::Response post(const nlohmann::json& payload, bool with_auth = false);
     cpr::Response get(const nlohmann::json& payload);
+    cpr::Response post_public(const nlohmann::json& payload);
+    cpr::Response refresh_locked();
+    std::unique_ptr<cpr::Session> acquire_session();
+    void release_session(std::unique_ptr<cpr::Session> session);
 
     // Common members
     std::string client_id;
@@ -55,20 +106,47 @@ private:
     std::string access_token;
     std::string refresh_token;
     std::chrono::time_point<std::chrono::steady_clock> token_expiry_time;
+    // Guards the tokens so REST calls can run from several threads
+    mutable std::mutex m_token_mutex;
+    std::unique_ptr<RateLimiter> m_rate_limiter;
+    // Idle HTTP sessions; each keeps its connection to the exchange open
+    std::mutex m_http_mutex;
+    std::vector<std::unique_ptr<cpr::Session>> m_http_sessions;
+    // Single-flight cache of public calls, with TTLs by method (REST_CACHE_TTL_MS)
+    std::unique_ptr<RequestCache<cpr::Response>> m_public_cache;
+    std::unordered_map<std::string, std::chrono::milliseconds> m_cache_ttl;
 
     // WebSocket members
     typedef websocketpp::client<websocketpp::config::asio_tls_client> ws_client;
     ws_client m_client;
     websocketpp::connection_hdl m_ws_hdl;
+    mutable std::mutex m_ws_mutex;
     std::string m_ws_uri;
     std::thread m_client_thread;
+    std::atomic<bool> m_ws_started{false};
     std::function<void(const std::string&, const std::string&)> m_broadcast_callback;
+    std::mutex m_broadcast_mutex;
     bool m_ws_enabled;
+    TickJournal* m_journal = nullptr;
+    std::vector<std::pair<std::string, ChannelListener>> m_channel_listeners;
+    std::mutex m_subscriptions_mutex;
+    std::set<std::string> m_public_channels;
+    std::set<std::string> m_private_channels;
+    bool m_ws_open = false;
+    bool m_ws_authenticated = false;
+    std::unique_ptr<FeedMonitor> m_feed_monitor;
+    std::atomic<bool> m_probing{false};
 
     // WebSocket helpers
     void init_websocket();
     void websocket_authenticate();
+    void send_public_subscriptions();
+    void send_private_subscriptions();
     void send_websocket_message(const nlohmann::json& msg);
+    void send_probe();
+    void schedule_probe();
+    bool has_listener(std::string_view channel) const;
+    void broadcast(const std::string& channel, const std::string& payload);
     void on_websocket_message(ws_client::message_ptr msg);
 };
 
@@ -0,0 +1,97 @@
+#ifndef FEED_MONITOR_HPP
+#define FEED_MONITOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "logger.hpp"
+
+// Health of the upstream connection. public/test probes measure the round
+// trip, less the server's own time between usIn and usOut, and give the
+// offset of the exchange clock from ours NTP style. The offset in use is
+// that of the probe with the smallest round trip in the recent window; its
+// error is at most half that round trip. With the offset, the exchange
+// timestamps on channel data give the exchange-side lag (exchange time to
+// our socket read), which separates a late feed from slow local processing
+// (LatencyTrace). The feed is stale when nothing has arrived for
+// stale_after_ms, and lagging when the smoothed lag exceeds
+// lag_threshold_ms.
+//
+// Probes, replies and frames are handled on the upstream io thread; the
+// current values can be read from any thread.
+class FeedMonitor {
+public:
+    struct Options {
+        uint64_t stale_after_ms = 5000;
+        uint64_t lag_threshold_ms = 250;
+        size_t window = 32;
+    };
+
+    // JSON-RPC ids at or above this are probes
+    static constexpr int64_t kProbeIdBase = 1000000;
+
+    FeedMonitor();
+    explicit FeedMonitor(const Options& options);
+
+    // Id to send with the next public/test
+    int64_t begin_probe();
+    // Reply to a probe, with the server's usIn / usOut stamps. Returns false
+    // for an id that is not an outstanding probe.
+    bool on_probe_reply(int64_t id, uint64_t us_in, uint64_t us_out);
+
+    // Every upstream frame; one in kLagSampleEvery is scanned for an
+    // exchange timestamp to sample the lag.
+    void on_frame(const std::string& payload);
+    void on_exchange_timestamp(uint64_t exchange_ms, uint64_t received_us);
+
+    // Re-evaluates the stale and lagging flags; called periodically, since
+    // a dead feed delivers nothing that would.
+    void check();
+
+    int64_t offset_us() const { return m_offset_us.load(std::memory_order_relaxed); }
+    int64_t offset_error_us() const { return m_offset_error_us.load(std::memory_order_relaxed); }
+    int64_t rtt_us() const { return m_rtt_us.load(std::memory_order_relaxed); }
+    int64_t lag_us() const { return m_lag_us.load(std::memory_order_relaxed); }
+    bool stale() const { return m_stale.load(std::memory_order_relaxed); }
+    bool lagging() const { return m_lagging.load(std::memory_order_relaxed); }
+    nlohmann::json to_json() const;
+
+    static uint64_t wall_us();
+
+    Logger logger;
+private:
+    static constexpr uint32_t kLagSampleEvery = 16;
+    static constexpr size_t kOutstanding = 16;
+
+    struct Probe {
+        int64_t id = -1;
+        uint64_t sent_ns = 0;
+        uint64_t sent_us = 0;
+    };
+
+    struct Sample {
+        int64_t rtt_us;
+        int64_t offset_us;
+    };
+
+    Options m_options;
+    Probe m_probes[kOutstanding];
+    int64_t m_next_id = kProbeIdBase;
+    std::vector<Sample> m_window;
+    size_t m_window_next = 0;
+    bool m_synced = false;
+    uint32_t m_frames = 0;
+    int64_t m_lag_ewma_us = 0;
+
+    std::atomic<uint64_t> m_last_frame_ns{0};
+    std::atomic<int64_t> m_offset_us{0};
+    std::atomic<int64_t> m_offset_error_us{0};
+    std::atomic<int64_t> m_rtt_us{0};
+    std::atomic<int64_t> m_lag_us{0};
+    std::atomic<bool> m_stale{false};
+    std::atomic<bool> m_lagging{false};
+};
+
+#endif
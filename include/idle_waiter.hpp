@@ -0,0 +1,42 @@
+#ifndef IDLE_WAITER_HPP
+#define IDLE_WAITER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Parks the consumer of an SPSC queue while there is nothing to do, and lets
+// the producer wake it. notify() after every push costs a fence and a load;
+// the lock is only taken when the consumer is actually parked, which is the
+// empty to non-empty transition.
+class IdleWaiter {
+public:
+    // Blocks until ready() holds. ready() must become true only through
+    // state the waking thread changes before calling notify().
+    template<typename Ready>
+    void wait(Ready ready) {
+        m_parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ready()) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, ready);
+        }
+        m_parked.store(false, std::memory_order_relaxed);
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!m_parked.load(std::memory_order_relaxed)) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_wake.notify_one();
+    }
+
+private:
+    std::atomic<bool> m_parked{false};
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef INSTRUMENT_LOADER_HPP
+#define INSTRUMENT_LOADER_HPP
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "deribit_client.hpp"
+#include "logger.hpp"
+
+// Startup phase that fills the InstrumentRegistry for a set of (currency,
+// kind) lists. All lists are fetched in parallel. With a cache file, a
+// previous snapshot is restored first and the instruments are usable at
+// once; the fetch then runs in the background and rewrites the file.
+class InstrumentLoader {
+public:
+    typedef std::vector<std::pair<std::string, std::string>> Lists;
+
+    struct Report {
+        bool from_cache = false;
+        double ready_ms = 0;       // until the registry could answer
+        double refreshed_ms = 0;   // until every list was fetched
+        size_t instruments = 0;
+        size_t failed = 0;         // lists the exchange did not return
+    };
+
+    // BTC, ETH, USDC and EURR futures, options and spot
+    static Lists default_lists();
+
+    InstrumentLoader(DeribitClient& client, const std::string& cache_path);
+    ~InstrumentLoader();
+
+    // Returns once the registry is ready; see Report for what was done.
+    Report start(const Lists& lists);
+    // Waits for the background refresh and returns the final report. Only
+    // call it from the thread that called start().
+    Report wait();
+    // Queues a new listing for public/get_instrument without blocking the
+    // caller (the feed thread). Names already waiting are coalesced; one
+    // background thread fetches them.
+    void fetch_later(const std::string& name);
+
+    Logger logger;
+private:
+    size_t fetch_all(const Lists& lists);
+    void persist();
+    void fetch_pending();
+
+    DeribitClient& m_client;
+    std::string m_cache_path;
+    std::thread m_refresh;
+    Report m_report;
+    std::mutex m_pending_mutex;
+    std::condition_variable m_pending_ready;
+    std::unordered_set<std::string> m_pending;
+    bool m_stopping = false;
+    std::thread m_fetcher;
+};
+
+#endif
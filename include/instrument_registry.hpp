@@ -0,0 +1,97 @@
+#ifndef INSTRUMENT_REGISTRY_HPP
+#define INSTRUMENT_REGISTRY_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+typedef uint32_t InstrumentId;
+constexpr InstrumentId kNoInstrument = UINT32_MAX;
+
+// Process-wide table of instruments. Every symbol is interned once to a
+// dense id (0, 1, 2, ... in first-seen order, never reused), so hot paths
+// resolve a name once at the edge and then index flat arrays by id.
+// Entries sit in fixed 256-entry chunks that never move: name(id) is a
+// lock-free read, while the mutable metadata is copied out under a shared
+// lock. Metadata comes from public/get_instruments and is kept current from
+// instrument.state.* notifications.
+class InstrumentRegistry {
+public:
+    static constexpr size_t kCapacity = 1 << 16;
+
+    struct Instrument {
+        InstrumentId id = kNoInstrument;
+        std::string name;
+        std::string kind;
+        std::string base_currency;
+        std::string quote_currency;
+        std::string settlement_currency;
+        std::string option_type;
+        double tick_size = 0;
+        double contract_size = 0;
+        double min_trade_amount = 0;
+        double strike = 0;
+        uint64_t creation_timestamp = 0;
+        uint64_t expiration_timestamp = 0;
+        bool is_active = false;
+        bool has_metadata = false;   // false until a get_instruments entry was seen
+    };
+
+    static InstrumentRegistry& instance();
+
+    // Returns the id of name, assigning the next one on first sight.
+    InstrumentId intern(const std::string& name);
+    // kNoInstrument if name was never interned.
+    InstrumentId find(const std::string& name) const;
+    const std::string& name(InstrumentId id) const { return entry(id).name; }
+    Instrument get(InstrumentId id) const;
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+
+    // Merges a public/get_instruments result and caches it as the
+    // (currency, kind) list. Instruments upserted later are added to every
+    // cached list they belong to.
+    void load(const std::string& currency, const std::string& kind, const nlohmann::json& instruments);
+    void load(const std::string& currency, const std::string& kind, const std::vector<Instrument>& instruments);
+    void upsert(const nlohmann::json& instrument);
+    bool loaded(const std::string& currency, const std::string& kind) const;
+    std::vector<Instrument> list(const std::string& currency, const std::string& kind, bool active_only = true) const;
+
+    // Compact binary copy of the cached lists for the next start. save()
+    // replaces the file atomically; restore() returns false when there is no
+    // usable file and throws on a truncated one.
+    void save(const std::string& path) const;
+    bool restore(const std::string& path);
+
+    // Data of an instrument.state.{kind}.{currency} notification. Returns true
+    // for a newly created instrument whose metadata still has to be fetched.
+    bool on_state(const nlohmann::json& data);
+
+private:
+    static constexpr size_t kChunkBits = 8;
+    static constexpr size_t kChunkSize = size_t(1) << kChunkBits;
+
+    InstrumentRegistry();
+
+    Instrument& entry(InstrumentId id) const {
+        return m_chunks[id >> kChunkBits].load(std::memory_order_acquire)[id & (kChunkSize - 1)];
+    }
+    InstrumentId intern_locked(const std::string& name);
+    InstrumentId upsert_locked(const nlohmann::json& instrument);
+    InstrumentId store_locked(const Instrument& fields);
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, InstrumentId> m_ids;
+    std::unique_ptr<std::atomic<Instrument*>[]> m_chunks;
+    std::vector<std::unique_ptr<Instrument[]>> m_owned;
+    std::atomic<size_t> m_size{0};
+    std::map<std::pair<std::string, std::string>, std::vector<InstrumentId>> m_lists;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef INSTRUMENTED_HPP
+#define INSTRUMENTED_HPP
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include "latency_histogram.hpp"
+
+// Wraps any manager and records the latency of each call into a per-function
+// histogram. Calls that throw are not recorded.
+//
+//     Instrumented<OrderManager> orders(order_manager);
+//     orders.call("cancel_order", &OrderManager::cancel_order, order_id);
+template <typename Manager>
+class Instrumented {
+public:
+    explicit Instrumented(Manager& manager) : m_manager(manager) {}
+
+    template <typename Method, typename... Args>
+    auto call(const char* name, Method method, Args&&... args)
+        -> decltype((std::declval<Manager&>().*method)(std::forward<Args>(args)...)) {
+        auto start = std::chrono::steady_clock::now();
+        auto result = (m_manager.*method)(std::forward<Args>(args)...);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (auto* histogram = m_stats.get(name)) histogram->record(elapsed);
+        return result;
+    }
+
+    LatencyHistogram::Summary get_stats(const char* name) const { return m_stats.summary(name); }
+    const HistogramSet& stats() const { return m_stats; }
+    void clear_stats() { m_stats.reset(); }
+
+    Manager& manager() { return m_manager; }
+
+private:
+    Manager& m_manager;
+    HistogramSet m_stats;
+};
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// Constant-memory latency histogram in the spirit of HdrHistogram. Values are
+// nanoseconds, bucketed log-linearly with 128 sub-buckets per power of two
+// (under 1% relative error) up to ~18 minutes. record() is lock-free.
+class LatencyHistogram {
+public:
+    struct Summary {
+        uint64_t count = 0;
+        double mean = 0.0;
+        uint64_t min = 0;
+        uint64_t p50 = 0;
+        uint64_t p90 = 0;
+        uint64_t p99 = 0;
+        uint64_t p999 = 0;
+        uint64_t max = 0;
+    };
+
+    static constexpr int kSubBucketBits = 7;
+    static constexpr uint64_t kSubBucketCount = uint64_t(1) << kSubBucketBits;
+    static constexpr int kMaxMagnitude = 40;
+    static constexpr uint64_t kHighestTrackable = (uint64_t(1) << kMaxMagnitude) - 1;
+    static constexpr size_t kBucketCount = (kMaxMagnitude - kSubBucketBits + 1) * kSubBucketCount;
+
+    LatencyHistogram() { reset(); }
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t nanos) {
+        if (nanos > kHighestTrackable) nanos = kHighestTrackable;
+        m_buckets[bucket_index(nanos)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(nanos, std::memory_order_relaxed);
+
+        uint64_t current = m_min.load(std::memory_order_relaxed);
+        while (nanos < current && !m_min.compare_exchange_weak(current, nanos, std::memory_order_relaxed)) {}
+        current = m_max.load(std::memory_order_relaxed);
+        while (nanos > current && !m_max.compare_exchange_weak(current, nanos, std::memory_order_relaxed)) {}
+    }
+
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> elapsed) {
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        record(nanos < 0 ? uint64_t(0) : uint64_t(nanos));
+    }
+
+    // Adds every sample of other into this histogram.
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            uint64_t n = other.m_buckets[i].load(std::memory_order_relaxed);
+            if (n) m_buckets[i].fetch_add(n, std::memory_order_relaxed);
+        }
+        m_count.fetch_add(other.m_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        uint64_t other_min = other.m_min.load(std::memory_order_relaxed);
+        uint64_t current = m_min.load(std::memory_order_relaxed);
+        while (other_min < current && !m_min.compare_exchange_weak(current, other_min, std::memory_order_relaxed)) {}
+        uint64_t other_max = other.m_max.load(std::memory_order_relaxed);
+        current = m_max.load(std::memory_order_relaxed);
+        while (other_max > current && !m_max.compare_exchange_weak(current, other_max, std::memory_order_relaxed)) {}
+    }
+
+    void reset() {
+        for (auto& bucket : m_buckets) bucket.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_min.store(UINT64_MAX, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+    // Value (ns) at or below which the given percentage of samples fall.
+    uint64_t percentile(double percent) const {
+        uint64_t total = 0;
+        for (const auto& bucket : m_buckets) total += bucket.load(std::memory_order_relaxed);
+        if (total == 0) return 0;
+
+        uint64_t target = static_cast<uint64_t>(percent / 100.0 * total + 0.5);
+        if (target == 0) target = 1;
+        if (target > total) target = total;
+
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                uint64_t value = bucket_upper_bound(i);
+                return value < max ? value : max;
+            }
+        }
+        return max;
+    }
+
+    Summary summary() const {
+        Summary s;
+        s.count = count();
+        if (s.count == 0) return s;
+        s.mean = static_cast<double>(m_sum.load(std::memory_order_relaxed)) / s.count;
+        s.min = m_min.load(std::memory_order_relaxed);
+        s.max = m_max.load(std::memory_order_relaxed);
+        s.p50 = percentile(50.0);
+        s.p90 = percentile(90.0);
+        s.p99 = percentile(99.0);
+        s.p999 = percentile(99.9);
+        return s;
+    }
+
+    static const char* csv_header() {
+        return "name,count,mean_ns,min_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns";
+    }
+
+    static std::string to_csv_row(const std::string& name, const Summary& s) {
+        std::ostringstream os;
+        os << name << ',' << s.count << ',' << static_cast<uint64_t>(s.mean) << ',' << s.min << ','
+           << s.p50 << ',' << s.p90 << ',' << s.p99 << ',' << s.p999 << ',' << s.max;
+        return os.str();
+    }
+
+    static nlohmann::json to_json(const Summary& s) {
+        return {
+            {"count", s.count},
+            {"mean_ns", static_cast<uint64_t>(s.mean)},
+            {"min_ns", s.min},
+            {"p50_ns", s.p50},
+            {"p90_ns", s.p90},
+            {"p99_ns", s.p99},
+            {"p999_ns", s.p999},
+            {"max_ns", s.max}
+        };
+    }
+
+private:
+    static size_t bucket_index(uint64_t value) {
+        if (value < kSubBucketCount) return static_cast<size_t>(value);
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - kSubBucketBits;
+        return static_cast<size_t>((shift + 1) * kSubBucketCount + (value >> shift) - kSubBucketCount);
+    }
+
+    static uint64_t bucket_upper_bound(size_t index) {
+        if (index < kSubBucketCount) return index;
+        int shift = static_cast<int>(index / kSubBucketCount) - 1;
+        uint64_t sub = index % kSubBucketCount + kSubBucketCount;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> m_buckets;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_min;
+    std::atomic<uint64_t> m_max;
+};
+
+// Fixed set of named histograms. Names are registered on first use with a
+// CAS on the slot, so lookups and recording never take a lock. Names must be
+// string literals (or otherwise outlive the set).
+class HistogramSet {
+public:
+    static constexpr size_t kMaxHistograms = 64;
+
+    HistogramSet() = default;
+    HistogramSet(const HistogramSet&) = delete;
+    HistogramSet& operator=(const HistogramSet&) = delete;
+
+    ~HistogramSet() {
+        for (auto& slot : m_slots) delete slot.histogram.load(std::memory_order_relaxed);
+    }
+
+    // Returns the histogram registered under name, creating it if needed.
+    // Returns nullptr only when all slots are taken.
+    LatencyHistogram* get(const char* name) {
+        for (auto& slot : m_slots) {
+            const char* current = slot.name.load(std::memory_order_acquire);
+            if (current == nullptr) {
+                if (slot.name.compare_exchange_strong(current, name, std::memory_order_acq_rel)) {
+                    auto* histogram = new LatencyHistogram();
+                    slot.histogram.store(histogram, std::memory_order_release);
+                    return histogram;
+                }
+            }
+            if (current == name || std::strcmp(current, name) == 0) {
+                LatencyHistogram* histogram;
+                while ((histogram = slot.histogram.load(std::memory_order_acquire)) == nullptr) {}
+                return histogram;
+            }
+        }
+        return nullptr;
+    }
+
+    // Returns the histogram registered under name without creating it.
+    const LatencyHistogram* find(const char* name) const {
+        for (const auto& slot : m_slots) {
+            const char* current = slot.name.load(std::memory_order_acquire);
+            if (current == nullptr) return nullptr;
+            if (current == name || std::strcmp(current, name) == 0) {
+                return slot.histogram.load(std::memory_order_acquire);
+            }
+        }
+        return nullptr;
+    }
+
+    void record(const char* name, uint64_t nanos) {
+        if (auto* histogram = get(name)) histogram->record(nanos);
+    }
+
+    LatencyHistogram::Summary summary(const char* name) const {
+        auto* histogram = find(name);
+        return histogram ? histogram->summary() : LatencyHistogram::Summary{};
+    }
+
+    template <typename Func>
+    void for_each(Func&& func) const {
+        for (const auto& slot : m_slots) {
+            const char* name = slot.name.load(std::memory_order_acquire);
+            if (name == nullptr) return;
+            if (auto* histogram = slot.histogram.load(std::memory_order_acquire)) {
+                func(name, *histogram);
+            }
+        }
+    }
+
+    void reset() {
+        for (auto& slot : m_slots) {
+            if (auto* histogram = slot.histogram.load(std::memory_order_acquire)) histogram->reset();
+        }
+    }
+
+    std::string to_csv() const {
+        std::ostringstream os;
+        os << LatencyHistogram::csv_header() << '\n';
+        for_each([&](const char* name, const LatencyHistogram& histogram) {
+            os << LatencyHistogram::to_csv_row(name, histogram.summary()) << '\n';
+        });
+        return os.str();
+    }
+
+    nlohmann::json to_json() const {
+        nlohmann::json j = nlohmann::json::object();
+        for_each([&](const char* name, const LatencyHistogram& histogram) {
+            j[name] = LatencyHistogram::to_json(histogram.summary());
+        });
+        return j;
+    }
+
+private:
+    struct Slot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<LatencyHistogram*> histogram{nullptr};
+    };
+    std::array<Slot, kMaxHistograms> m_slots;
+};
+
+#endif
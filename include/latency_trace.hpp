@@ -0,0 +1,100 @@
+#ifndef LATENCY_TRACE_HPP
+#define LATENCY_TRACE_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "latency_histogram.hpp"
+
+// Stage-by-stage latency of the feed path, from the upstream frame being read
+// off the socket to the update being queued for each local subscriber. Only
+// one in sample_rate frames is traced; untraced frames pay a thread-local
+// check per stage. The active trace is kept in thread-local state; when a
+// frame is queued to a fan-out worker the trace is handed off with it.
+class LatencyTrace {
+public:
+    enum Stage {
+        EXCHANGE_TO_RECEIVE, // exchange timestamp -> local receive (wall clock, ms precision)
+        PARSE,               // socket read -> JSON parsed
+        DISPATCH,            // parsed -> fan-out entry
+        QUEUE_WAIT,          // queued on the io thread -> picked up by a fan-out worker
+        LOCK_ACQUIRE,        // fan-out entry -> subscriber lock held
+        SEND_ENQUEUE,        // one subscriber send queued (per client)
+        TICK_TO_WIRE,        // socket read -> last subscriber send queued
+        STAGE_COUNT
+    };
+
+    static LatencyTrace& instance();
+
+    // 0 disables tracing, 1 traces every frame.
+    void set_sample_rate(uint32_t one_in_n) { m_sample_rate.store(one_in_n, std::memory_order_relaxed); }
+    uint32_t sample_rate() const { return m_sample_rate.load(std::memory_order_relaxed); }
+
+    // Called when a frame is read; decides whether it is sampled.
+    void begin_frame();
+    // Closes the frame's trace and records the end-to-end stage.
+    void end_frame();
+    bool active() const { return t_state.active; }
+
+    // Moves the current frame's trace to another thread: handoff() ends it
+    // here without recording, resume() continues it on the consumer.
+    struct Handoff {
+        bool active = false;
+        uint64_t begin = 0;
+        uint64_t last = 0;
+    };
+    Handoff handoff();
+    void resume(const Handoff& handoff);
+
+    // Records the time since the previous mark under stage.
+    void mark(Stage stage) {
+        if (!t_state.active) return;
+        uint64_t now = now_ns();
+        m_stages[stage].record(now - t_state.last);
+        t_state.last = now;
+        if (stage == LOCK_ACQUIRE) t_state.dispatched = true;
+    }
+
+    // Start/finish pair for stages measured around one call (per-client send).
+    uint64_t start() const { return t_state.active ? now_ns() : 0; }
+    void finish(Stage stage, uint64_t started) {
+        if (!t_state.active) return;
+        uint64_t now = now_ns();
+        m_stages[stage].record(now - started);
+        t_state.last = now;
+    }
+
+    void record_exchange_timestamp(uint64_t exchange_ms);
+
+    const LatencyHistogram& histogram(Stage stage) const { return m_stages[stage]; }
+    uint64_t sampled_frames() const { return m_sampled.load(std::memory_order_relaxed); }
+    nlohmann::json to_json() const;
+    void reset();
+
+    static const char* stage_name(Stage stage);
+
+    static uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    LatencyTrace() = default;
+
+    struct ThreadState {
+        bool active = false;
+        bool dispatched = false;
+        uint32_t counter = 0;
+        uint64_t begin = 0;
+        uint64_t last = 0;
+    };
+    static thread_local ThreadState t_state;
+
+    std::array<LatencyHistogram, STAGE_COUNT> m_stages;
+    std::atomic<uint32_t> m_sample_rate{64};
+    std::atomic<uint64_t> m_sampled{0};
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef MARKET_DATA_BUS_HPP
+#define MARKET_DATA_BUS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "seqlock.hpp"
+
+// Shared-memory layout of the market data bus. One POSIX shared memory
+// object holds a Header, a table of BookSlots (one seqlock-protected top of
+// book per instrument, assigned on first publication and never reused) and
+// a broadcast ring of Updates. The publisher is the only writer; any number
+// of processes map the object read-only. Times are CLOCK_MONOTONIC
+// nanoseconds, which all processes on the host share.
+namespace mdbus {
+
+constexpr uint32_t kMagic = 0x3142444d;   // "MDB1"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kDepth = 10;
+constexpr size_t kNameSize = 64;
+constexpr const char* kDefaultName = "/deribit-md";
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The bus needs address-free 64-bit atomics");
+
+struct Level {
+    double price;
+    double amount;
+};
+
+// valid is 0 while the publisher's book is stale after a change_id gap,
+// until the next snapshot.
+struct Book {
+    uint64_t change_id;
+    uint64_t timestamp_ms;    // exchange time
+    uint64_t published_ns;
+    uint32_t bid_levels;
+    uint32_t ask_levels;
+    uint32_t valid;
+    uint32_t reserved;
+    Level bids[kDepth];
+    Level asks[kDepth];
+};
+
+// Written to the ring for every book publication. sequence is the record's
+// position in the stream, which lets a reader detect that it was lapped.
+struct Update {
+    uint64_t sequence;
+    uint32_t slot;
+    uint32_t valid;
+    uint64_t change_id;
+    uint64_t timestamp_ms;
+    uint64_t published_ns;
+    Level best_bid;
+    Level best_ask;
+};
+
+struct alignas(64) BookSlot {
+    char instrument[kNameSize];
+    Seqlock<Book> book;
+};
+
+struct RingSlot {
+    Seqlock<Update> update;
+};
+
+struct Header {
+    std::atomic<uint32_t> magic;   // released last, once the rest is initialized
+    uint32_t version;
+    uint32_t book_slots;
+    uint32_t depth;
+    uint64_t ring_capacity;   // power of two
+    uint64_t books_offset;
+    uint64_t ring_offset;
+    alignas(64) std::atomic<uint32_t> books_used;   // slots with a name, released after it is written
+    alignas(64) std::atomic<uint64_t> ring_head;    // sequence of the next record
+};
+
+inline size_t books_offset() { return (sizeof(Header) + 63) & ~size_t(63); }
+inline size_t ring_offset(size_t book_slots) { return books_offset() + book_slots * sizeof(BookSlot); }
+inline size_t mapping_size(size_t book_slots, size_t ring_capacity) {
+    return ring_offset(book_slots) + ring_capacity * sizeof(RingSlot);
+}
+
+}
+
+// Reader side of the bus, for strategy processes on the same host. Needs
+// nothing beyond this header and the deribit_mdbus library. A reader maps
+// the bus as it is when opened; if the publisher restarts, open a new one.
+class MarketDataBusReader {
+public:
+    // Throws std::runtime_error if the bus does not exist or has another layout version.
+    explicit MarketDataBusReader(const std::string& name = mdbus::kDefaultName);
+    ~MarketDataBusReader();
+    MarketDataBusReader(const MarketDataBusReader&) = delete;
+    MarketDataBusReader& operator=(const MarketDataBusReader&) = delete;
+
+    // Slot of an instrument, or -1 if it has not been published yet
+    int find(const std::string& instrument);
+    size_t instruments() const;
+    std::string instrument(size_t slot) const;
+    // Consistent copy of a slot's book; never blocks the publisher.
+    mdbus::Book book(size_t slot) const;
+
+    // Next update on the broadcast ring, false if none is waiting. Starts
+    // at the updates published after the reader was opened. A reader that
+    // falls more than the ring capacity behind skips ahead to the oldest
+    // update still held and counts the rest in lost().
+    bool poll(mdbus::Update& update);
+    uint64_t lost() const { return m_lost; }
+
+private:
+    void* m_map = nullptr;
+    size_t m_size = 0;
+    const mdbus::Header* m_header = nullptr;
+    const mdbus::BookSlot* m_books = nullptr;
+    const mdbus::RingSlot* m_ring = nullptr;
+    uint64_t m_mask = 0;
+    uint64_t m_next = 0;
+    uint64_t m_lost = 0;
+    size_t m_indexed = 0;
+    std::unordered_map<std::string, int> m_slots;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef MARKET_DATA_PUBLISHER_HPP
+#define MARKET_DATA_PUBLISHER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "idle_waiter.hpp"
+#include "instrument_registry.hpp"
+#include "logger.hpp"
+#include "market_data_bus.hpp"
+#include "order_book.hpp"
+#include "spsc_queue.hpp"
+
+// Writer side of the market data bus. Keeps a local book per instrument
+// from the upstream book.* notifications and publishes each one to its
+// seqlock slot and the broadcast ring. The feed thread only copies a
+// notification into a bounded queue; the publisher thread parses, applies
+// and publishes it, and is the single writer once started.
+class MarketDataPublisher {
+public:
+    struct Options {
+        std::string name = mdbus::kDefaultName;
+        size_t book_slots = 1024;
+        size_t ring_capacity = 1 << 16;
+        size_t queue_capacity = 4096;
+    };
+
+    // Replaces any bus of the same name; readers of the old one keep their
+    // mapping but see no further updates.
+    explicit MarketDataPublisher(const Options& options);
+    ~MarketDataPublisher();
+    MarketDataPublisher(const MarketDataPublisher&) = delete;
+    MarketDataPublisher& operator=(const MarketDataPublisher&) = delete;
+
+    // Assigns the instrument a bus slot, or returns -1 if there is none left.
+    // Call before start().
+    int add_instrument(const std::string& instrument);
+    void start();
+    void stop();
+    // Queues a book.* notification for a slot from add_instrument; called
+    // from one thread only. A full queue drops it and counts the drop.
+    bool enqueue(int slot, const std::string& payload);
+    // Publishes on the calling thread, for use without start()
+    void publish(const OrderBook& book);
+
+    uint64_t published() const { return m_published; }
+    const std::string& name() const { return m_options.name; }
+
+    Logger logger;
+private:
+    // Slots are reused, so the payload buffer only grows for frames larger
+    // than any seen in that slot before.
+    struct Pending {
+        Pending() { payload.reserve(1024); }
+        int slot = -1;
+        std::string payload;
+    };
+    void publish_loop();
+    void apply(const Pending& pending);
+    void publish(int slot, const OrderBook& book);
+
+    Options m_options;
+    void* m_map = nullptr;
+    size_t m_size = 0;
+    mdbus::Header* m_header = nullptr;
+    mdbus::BookSlot* m_books = nullptr;
+    mdbus::RingSlot* m_ring = nullptr;
+    std::vector<int> m_slots;           // by InstrumentId, -1 until assigned
+    std::vector<OrderBook> m_local;     // by slot
+    uint64_t m_published = 0;
+    bool m_full_logged = false;
+    SpscQueue<Pending> m_queue;
+    IdleWaiter m_waiter;
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+};
+
+#endif
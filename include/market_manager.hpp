@@ -2,14 +2,18 @@
 #define MARKET_MANAGER_HPP
 #include "logger.hpp"
 #include "deribit_client.hpp"
+#include "rpc_decoder.hpp"
 
 class MarketManager {
     public:
-        MarketManager(DeribitClient client);
+        MarketManager(DeribitClient& client);
         ~MarketManager();
         std::string view_all_instruments(const std::string& currency, const std::string& kind);
+        // public/get_instruments, decoded without a DOM and merged into the
+        // registry. Transport failures and malformed bodies throw.
+        rpc::Result<std::vector<rpc::Instrument>> instruments(const std::string& currency, const std::string& kind);
     private:
-        DeribitClient client;
+        DeribitClient& client;
         Logger logger;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "latency_histogram.hpp"
+
+// Always-on process metrics, rendered in the Prometheus text exposition
+// format. Series are registered once (under a lock) and the returned
+// references are cached by the caller; recording is a relaxed atomic
+// operation on the cached series.
+
+class alignas(64) Counter {
+public:
+    void inc(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+class alignas(64) Gauge {
+public:
+    void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(int64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    void sub(int64_t n = 1) { m_value.fetch_sub(n, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+private:
+    std::atomic<int64_t> m_value{0};
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    // labels is a rendered label set such as label("method", "private/buy").
+    // Registering an existing name and label set returns the same series.
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    // Latency series in nanoseconds, exported as a summary in seconds.
+    LatencyHistogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    std::string render() const;
+
+    static std::string label(const std::string& name, const std::string& value);
+
+private:
+    MetricsRegistry() = default;
+
+    enum class Type { COUNTER, GAUGE, SUMMARY };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::map<std::string, std::unique_ptr<Counter>> counters;
+        std::map<std::string, std::unique_ptr<Gauge>> gauges;
+        std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms;
+    };
+
+    Family& family(const std::string& name, const std::string& help, Type type);
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, Family> m_families;
+};
+
+#endif
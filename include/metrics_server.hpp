@@ -0,0 +1,28 @@
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+#include <thread>
+#include "logger.hpp"
+
+// Serves MetricsRegistry on GET /metrics over plain HTTP from its own thread.
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    void start(uint16_t port);
+    void stop();
+
+    Logger logger;
+private:
+    typedef websocketpp::server<websocketpp::config::asio> http_server;
+
+    void on_http(websocketpp::connection_hdl hdl);
+
+    http_server m_server;
+    std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef ORDER_BOOK_HPP
+#define ORDER_BOOK_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Local copy of one instrument's book, maintained from Deribit book.*
+// notifications. Levels are kept in flat sorted vectors (bids descending,
+// asks ascending) since books are shallow and mostly touched near the top.
+class OrderBook {
+public:
+    struct Level {
+        double price;
+        double amount;
+    };
+
+    explicit OrderBook(std::string instrument_name = "");
+
+    // Applies the "data" object of a book notification. Handles both the
+    // incremental format (type snapshot/change with [action, price, amount]
+    // entries) and the grouped format ([price, amount] full snapshots).
+    // Returns false if a change does not follow the last change_id, in which
+    // case the book is stale until the next snapshot.
+    bool apply(const nlohmann::json& data);
+    void apply_level(bool bid, double price, double amount);
+    void clear();
+
+    const Level* best_bid() const { return m_bids.empty() ? nullptr : &m_bids.front(); }
+    const Level* best_ask() const { return m_asks.empty() ? nullptr : &m_asks.front(); }
+    const std::vector<Level>& bids() const { return m_bids; }
+    const std::vector<Level>& asks() const { return m_asks; }
+
+    const std::string& instrument_name() const { return m_instrument_name; }
+    uint64_t change_id() const { return m_change_id; }
+    uint64_t timestamp() const { return m_timestamp; }
+    bool is_valid() const { return m_valid; }
+
+private:
+    void apply_side(bool bid, const nlohmann::json& entries);
+
+    std::string m_instrument_name;
+    std::vector<Level> m_bids;
+    std::vector<Level> m_asks;
+    uint64_t m_change_id = 0;
+    uint64_t m_timestamp = 0;
+    bool m_valid = false;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef ORDER_CACHE_HPP
+#define ORDER_CACHE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace rpc { struct OrderAck; }
+
+// In-memory view of our orders, fed by the user.orders.* and user.trades.*
+// channels and by the acknowledgements of REST order calls. Orders are
+// indexed by id, label and (while open) instrument. Fills are kept by
+// order id, so trades that arrive before their order are matched once the
+// order shows up. Updates older than the cached state are ignored. Only
+// the most recent max_closed orders that are no longer open are kept, with
+// their fills, and trade ids are remembered for duplicate detection up to
+// max_trade_ids; older ones are evicted first.
+class OrderCache {
+public:
+    struct Fill {
+        std::string trade_id;
+        double price = 0.0;
+        double amount = 0.0;
+        double fee = 0.0;
+        uint64_t timestamp = 0;
+    };
+
+    struct Order {
+        std::string order_id;
+        std::string label;
+        std::string instrument_name;
+        std::string direction;
+        std::string order_type;
+        std::string order_state;
+        double price = 0.0;
+        double amount = 0.0;
+        double filled_amount = 0.0;
+        double average_price = 0.0;
+        uint64_t creation_timestamp = 0;
+        uint64_t last_update_timestamp = 0;
+        std::vector<Fill> fills;
+
+        bool is_open() const { return order_state == "open" || order_state == "untriggered"; }
+    };
+
+    // Differences found by reconcile(); the REST view has been adopted.
+    struct Reconciliation {
+        std::vector<std::string> missing;      // open on the exchange, unknown locally
+        std::vector<std::string> stale;        // open locally, not open on the exchange
+        std::vector<std::string> mismatched;   // open on both with different state
+        bool consistent() const { return missing.empty() && stale.empty() && mismatched.empty(); }
+    };
+
+    explicit OrderCache(size_t max_closed = 10000, size_t max_trade_ids = 100000);
+
+    void apply_order(const nlohmann::json& order);
+    void apply_trade(const nlohmann::json& trade);
+    // Result of private/buy, sell or edit ({"order": ..., "trades": [...]}) or
+    // of private/cancel (the order itself).
+    void apply_ack(const nlohmann::json& result);
+    // The same, decoded (rpc_decoder.hpp)
+    void apply_ack(const rpc::OrderAck& ack);
+    void apply_order(const Order& order);
+    // Data of a user.orders.* or user.trades.* notification (object or array).
+    void on_channel(const std::string& channel, const nlohmann::json& data);
+
+    std::optional<Order> find(const std::string& order_id) const;
+    std::vector<Order> by_label(const std::string& label) const;
+    // All open orders, or those of one instrument.
+    std::vector<Order> open_orders(const std::string& instrument_name = "") const;
+    // Unfilled amount of the open buy or sell orders of one instrument.
+    double open_amount(const std::string& instrument_name, bool buy) const;
+    // Called with the change in an instrument's open buy or sell amount
+    // whenever an order opens, fills, is edited or closes, under the cache's
+    // lock. Setting it first reports every order already open.
+    typedef std::function<void(const std::string& instrument, bool buy, double delta)> OpenListener;
+    void set_open_listener(OpenListener listener);
+    std::vector<Fill> fills(const std::string& order_id) const;
+    size_t size() const;
+
+    // Compares open orders with a private/get_open_orders_by_currency result.
+    // Local open orders are only checked for instruments settled in that
+    // currency.
+    Reconciliation reconcile(const nlohmann::json& open_orders, const std::string& currency);
+
+    static nlohmann::json to_json(const Order& order);
+
+private:
+    void apply_order_locked(const nlohmann::json& order);
+    void apply_trade_locked(const nlohmann::json& trade);
+    void store_order_locked(Order incoming);
+    void store_fill_locked(const std::string& order_id, Fill fill);
+    void index_open(const Order& order, bool open);
+    void erase_locked(std::unordered_map<std::string, Order>::iterator it);
+    void evict_locked();
+    Order with_fills(const Order& order) const;
+    static Order parse_order(const nlohmann::json& order);
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, Order> m_orders;
+    std::unordered_map<std::string, std::unordered_set<std::string>> m_by_label;
+    std::unordered_map<std::string, std::unordered_set<std::string>> m_open_by_instrument;
+    std::unordered_map<std::string, std::vector<Fill>> m_fills;
+    std::unordered_set<std::string> m_trade_ids;
+    std::deque<std::pair<std::string, std::string>> m_trade_order;   // (trade id, order id), oldest first
+    std::deque<std::string> m_closed;   // order ids in the order they closed
+    size_t m_max_closed;
+    size_t m_max_trade_ids;
+    OpenListener m_open_listener;
+};
+
+#endif
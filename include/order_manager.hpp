@@ -1,24 +1,97 @@
 #ifndef ORDER_MANAGER
 #define ORDER_MANAGER
 
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include "logger.hpp"
 #include "deribit_client.hpp"
+#include "rpc_decoder.hpp"
+#include "risk_gate.hpp"
+
+class OrderCache;
+class ThreadPool;
+class PositionCache;
 
 class OrderManager {
     public:
-        OrderManager(DeribitClient client);
+        OrderManager(DeribitClient& client);
         ~OrderManager();
         std::string view_current_positions(const std::string& currency, const std::string& kind);
         std::string get_orderbook(const std::string& instrument_name);
         std::string place_order(const std::string& symbol, const std::string& side, const std::string& type, const std::string& quantity, const std::string& price);
         std::string cancel_order(const std::string& order_id);
         std::string modify_order(const std::string& order_id, const std::string& quantity, const std::string& price);
+        // Answered from the local order cache; "any" lists every instrument.
+        std::string view_open_orders(const std::string& instrument_name);
+
+        struct OrderRequest {
+            std::string symbol;
+            std::string side;
+            std::string type;
+            std::string quantity;
+            std::string price;
+            std::string label = "label";
+            // Resolved from symbol by place() when left unset
+            InstrumentId instrument = kNoInstrument;
+        };
+        // Places every order on the worker pool and waits for all of them;
+        // called from a worker (an async callback), it places them one by one
+        // on that thread instead. Returns {"placed": n, "failed": m, "orders": [...]}, one entry per
+        // request in request order.
+        std::string place_orders(const std::vector<OrderRequest>& orders);
+        // Mass cancel through private/cancel_all*; the result is the number of
+        // orders cancelled.
+        std::string cancel_all();
+        std::string cancel_by_instrument(const std::string& instrument_name);
+        std::string cancel_by_label(const std::string& label);
+
+        // Typed results, decoded from the response body without a DOM; the
+        // string methods above render them for the CLI. Transport failures
+        // and malformed bodies throw.
+        rpc::Result<rpc::OrderAck> place(const OrderRequest& order);
+        rpc::Result<rpc::Order> cancel(const std::string& order_id);
+        rpc::Result<rpc::OrderAck> modify(const std::string& order_id, const std::string& quantity, const std::string& price);
+        rpc::Result<std::vector<rpc::Position>> positions(const std::string& currency, const std::string& kind);
+        rpc::Result<rpc::BookSnapshot> order_book(const std::string& instrument_name);
+
+        // Non-blocking variants, run on a bounded pool of ORDER_WORKERS threads so
+        // several orders can be in flight at once. The future yields what the
+        // blocking call returns; callbacks run on the worker thread, and what
+        // they throw is logged.
+        typedef std::function<void(const std::string&)> Completion;
+        std::future<std::string> place_order_async(const std::string& symbol, const std::string& side, const std::string& type, const std::string& quantity, const std::string& price);
+        std::future<std::string> cancel_order_async(const std::string& order_id);
+        std::future<std::string> modify_order_async(const std::string& order_id, const std::string& quantity, const std::string& price);
+        void place_order_async(const std::string& symbol, const std::string& side, const std::string& type, const std::string& quantity, const std::string& price, Completion on_done);
+        void cancel_order_async(const std::string& order_id, Completion on_done);
+        // Acknowledgements of order calls are applied to the cache. Not owned.
+        void set_order_cache(OrderCache* cache) { m_order_cache = cache; }
+        // Orders failing a pre-trade check are answered locally with a
+        // risk_rejected error and never sent. Not owned.
+        void set_risk_gate(RiskGate* gate) { m_risk_gate = gate; }
+        // view_current_positions answers from the cache for seeded currencies
+        // instead of calling private/get_positions. Not owned.
+        void set_position_cache(PositionCache* cache) { m_position_cache = cache; }
     private:
-        DeribitClient client;
+        nlohmann::json submit_order(const OrderRequest& order);
+        static std::string mass_cancel_result(cpr::Response r);
+        void complete(const Completion& on_done, const std::string& result);
+        // Empty when the order passes, and its amount is then held in the gate
+        // until hold goes; otherwise a risk_rejected error
+        std::optional<rpc::Error> risk_check(InstrumentId instrument, const std::string& side, const std::string& quantity, const std::string& price, RiskGate::Hold& hold, double replaces = 0);
+
+        DeribitClient& client;
         Logger logger;
+        OrderCache* m_order_cache = nullptr;
+        RiskGate* m_risk_gate = nullptr;
+        PositionCache* m_position_cache = nullptr;
+        // Declared last so queued calls finish before the client goes away
+        std::unique_ptr<ThreadPool> m_pool;
 };
 
 #endif
\ No newline at end of file
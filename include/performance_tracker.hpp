@@ -1,38 +1,103 @@
 #ifndef PERFORMANCE_TRACKER_HPP
 #define PERFORMANCE_TRACKER_HPP
 
+#include <cstdint>
+
+// Scoped timers for hot code. A timer site is a string literal interned once
+// per call site (PERF_SITE); a running timer is a site id and a start tick, and
+// stopping it pushes one sample into the calling thread's ring buffer with no
+// allocation, locking or I/O. perf::drain() moves the samples into the
+// "deribit_scope_seconds" metric, labelled by site; a background thread
+// calls it every 100 ms, and a scrape calls it too.
+//
+// Building with DERIBIT_SCOPED_TIMERS=0 turns PerformanceTracker into an empty
+// type and PERF_SITE into a constant, so the timers compile away.
+
+#ifndef DERIBIT_SCOPED_TIMERS
+#define DERIBIT_SCOPED_TIMERS 1
+#endif
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+
+#if DERIBIT_SCOPED_TIMERS
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
 #include <chrono>
-#include <string>
-#include <iostream>
+#endif
+
+namespace perf {
+
+// TSC ticks on x86 (converted to ns when drained), steady_clock ns elsewhere.
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+class TimerSite {
+public:
+    explicit TimerSite(const char* name);
+    uint32_t id() const { return m_id; }
+    const char* name() const { return m_name; }
+private:
+    const char* m_name;
+    uint32_t m_id;
+};
+
+// Queues one sample on the calling thread's buffer; drops it if the buffer is full.
+void submit(uint32_t site, uint64_t elapsed_ticks);
+
+// Drains every thread's buffer into the metrics registry. Returns samples drained.
+uint64_t drain();
+// Samples lost to full buffers since startup.
+uint64_t dropped();
+
+}
 
 class PerformanceTracker {
 public:
-    PerformanceTracker(const std::string& name): m_name(name) {
-        start();
+    explicit PerformanceTracker(const perf::TimerSite& site) : m_site(site.id()), m_start(perf::ticks()) {}
+    ~PerformanceTracker() {
+        if (m_start != 0) stop();
     }
 
-
-    ~PerformanceTracker(){
-    if (m_end_time == std::chrono::high_resolution_clock::time_point{}) {
-        stop();
+    void stop() {
+        perf::submit(m_site, perf::ticks() - m_start);
+        m_start = 0;
     }
-}
-    void start(){
-    m_start_time = std::chrono::high_resolution_clock::now();
-}
-    void stop(){
-    m_end_time = std::chrono::high_resolution_clock::now();
-    std::cout << "Function " << m_name << " took "  << elapsed_time() << "ms" << std::endl;
-}
-    double elapsed_time() const{
-    auto end = (m_end_time == std::chrono::high_resolution_clock::time_point{}) 
-        ? std::chrono::high_resolution_clock::now() 
-        : m_end_time;
-    return std::chrono::duration<double, std::milli>(end - m_start_time).count();
-}
+
 private:
-    std::string m_name;
-    std::chrono::time_point<std::chrono::high_resolution_clock> m_start_time;
-    std::chrono::time_point<std::chrono::high_resolution_clock> m_end_time;
+    uint32_t m_site;
+    uint64_t m_start;
 };
+
+// Each expansion is its own lambda, so each call site gets its own static.
+#define PERF_SITE(name) ([]() -> const perf::TimerSite& { static const perf::TimerSite site(name); return site; }())
+
+#else
+
+namespace perf {
+struct TimerSite {};
+inline uint64_t drain() { return 0; }
+inline uint64_t dropped() { return 0; }
+}
+
+class PerformanceTracker {
+public:
+    explicit PerformanceTracker(perf::TimerSite) {}
+    void stop() {}
+};
+
+#define PERF_SITE(name) perf::TimerSite{}
+
+#endif
+
+#define PERF_SCOPE(name) PerformanceTracker PERF_CONCAT(perf_scope_, __LINE__)(PERF_SITE(name))
+
 #endif
@@ -0,0 +1,105 @@
+#ifndef POSITION_CACHE_HPP
+#define POSITION_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "seqlock.hpp"
+
+// Positions and margin kept current from the user.changes.* and
+// user.portfolio.* channels, seeded from REST at startup. Floating PnL is
+// revalued locally on every ticker.* / markprice.options.* mark price, as a
+// delta from the last exchange-reported (mark, PnL) pair: inverse futures
+// as size * (1/old - 1/new), everything else linear.
+//
+// Entries live in fixed tables that never move and are published with a
+// release store of the count, and each value sits behind a seqlock, so
+// reads take no lock. Updates arrive on the feed thread; the write mutex
+// only serializes them against the startup seed.
+class PositionCache {
+public:
+    struct Position {
+        double size = 0;
+        double average_price = 0;
+        double mark_price = 0;
+        double floating_pnl = 0;
+        double realized_pnl = 0;
+        uint64_t updated_ms = 0;
+        // Last exchange-reported values, the base of local revaluation
+        double reported_mark = 0;
+        double reported_floating_pnl = 0;
+    };
+
+    struct Portfolio {
+        double equity = 0;
+        double balance = 0;
+        double margin_balance = 0;
+        double initial_margin = 0;
+        double maintenance_margin = 0;
+        double available_funds = 0;
+        double total_pl = 0;
+        double session_upl = 0;
+        uint64_t updated_ms = 0;
+    };
+
+    explicit PositionCache(size_t capacity = 1024);
+
+    // Result of private/get_positions for one currency. Until a currency is
+    // seeded, readers should fall back to REST for it.
+    void seed(const std::string& currency, const nlohmann::json& positions);
+    bool seeded(const std::string& currency) const;
+
+    void apply_position(const nlohmann::json& position);
+    void apply_portfolio(const nlohmann::json& portfolio);
+    void on_mark_price(const std::string& instrument, double mark_price);
+    // Data of user.changes.*, user.portfolio.*, ticker.* and markprice.options.*
+    void on_channel(const std::string& channel, const nlohmann::json& data);
+
+    // Called (on the updating thread) the first time an instrument is seen,
+    // e.g. to subscribe to its mark price.
+    void set_instrument_callback(std::function<void(const std::string&)> callback) { m_on_instrument = callback; }
+
+    bool position(const std::string& instrument, Position& out) const;
+    // Open positions of a settlement currency ("" for all) and kind ("any" for all)
+    nlohmann::json positions(const std::string& currency = "", const std::string& kind = "any") const;
+    bool portfolio(const std::string& currency, Portfolio& out) const;
+
+private:
+    struct Entry {
+        std::string instrument;
+        std::string kind;
+        std::string currency;
+        bool inverse = false;
+        Seqlock<Position> state;
+    };
+
+    struct Account {
+        std::string currency;
+        std::atomic<bool> seeded{false};
+        Seqlock<Portfolio> state;
+    };
+
+    static const size_t kMaxCurrencies = 16;
+
+    Entry* find(const std::string& instrument) const;
+    Entry* find_or_add(const std::string& instrument, const std::string& kind);
+    Account* account(const std::string& currency);
+    const Account* find_account(const std::string& currency) const;
+    void apply_position_locked(const nlohmann::json& position);
+
+    size_t m_capacity;
+    std::unique_ptr<Entry[]> m_entries;
+    std::atomic<size_t> m_count{0};
+    Account m_accounts[kMaxCurrencies];
+    std::atomic<size_t> m_account_count{0};
+    std::mutex m_write_mutex;
+    std::function<void(const std::string&)> m_on_instrument;
+};
+
+#endif
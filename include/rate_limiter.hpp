@@ -0,0 +1,68 @@
+#ifndef RATE_LIMITER_HPP
+#define RATE_LIMITER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+
+class Counter;
+class Gauge;
+class LatencyHistogram;
+
+// Client-side model of Deribit's credit limits: one token bucket for
+// matching-engine requests (buy, sell, edit, cancel*) and one for the rest.
+// Each request costs one token; burst and refill rate are in requests, so
+// credits = requests * per-request cost. Waiting requests are served by lane,
+// then in arrival order, so a cancel never queues behind a new order in the
+// same bucket and orders never queue behind queries.
+class RateLimiter {
+public:
+    enum Pool { MATCHING = 0, NON_MATCHING = 1 };
+    enum Lane { CANCEL = 0, ORDER = 1, QUERY = 2 };
+
+    struct Limit {
+        double burst = 0;        // bucket size; also the starting balance
+        double per_second = 0;   // refill rate; 0 disables the bucket
+    };
+
+    // Throws std::invalid_argument for a negative rate, or for a burst
+    // below one request on an enabled bucket, which could never grant one.
+    RateLimiter(const Limit& matching, const Limit& non_matching);
+    static bool valid(const Limit& limit);
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Blocks until a token of the pool is granted to this request.
+    void acquire(Pool pool, Lane lane);
+    // The exchange answered too_many_requests: empty the bucket so the
+    // following requests back off for a full token interval.
+    void on_rejected(Pool pool);
+
+    static Pool pool_of(const std::string& method);
+    static Lane lane_of(const std::string& method);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Bucket {
+        Limit limit;
+        double tokens = 0;
+        Clock::time_point updated;
+        uint64_t next_ticket = 0;
+        std::deque<uint64_t> waiting[3];
+        std::condition_variable ready;
+    };
+
+    void refill(Bucket& bucket, Clock::time_point now);
+
+    std::mutex m_mutex;
+    Bucket m_buckets[2];
+    Gauge* m_queued[3];
+    LatencyHistogram* m_wait[3];
+    Counter* m_rejects;
+};
+
+#endif
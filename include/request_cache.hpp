@@ -0,0 +1,115 @@
+#ifndef REQUEST_CACHE_HPP
+#define REQUEST_CACHE_HPP
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "metrics.hpp"
+
+// Single-flight cache for idempotent calls. Concurrent callers with the same
+// key share one in-flight fetch, and its result is served until the TTL
+// runs out; a zero TTL only coalesces. Results the keep predicate rejects
+// (errors) and fetches that throw go to everyone already waiting, but are
+// not kept. Lookups are counted in deribit_rest_cache_requests_total by
+// method and result: hit, coalesced or miss.
+template<typename T>
+class RequestCache {
+public:
+    typedef std::function<T()> Fetch;
+    typedef std::function<bool(const T&)> Keep;
+
+    explicit RequestCache(Keep keep = [](const T&) { return true; }) : m_keep(std::move(keep)) {}
+    RequestCache(const RequestCache&) = delete;
+    RequestCache& operator=(const RequestCache&) = delete;
+
+    T get(const std::string& method, const std::string& key, std::chrono::milliseconds ttl, const Fetch& fetch) {
+        std::promise<T> promise;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            Counters& counters = counters_locked(method);
+            auto now = std::chrono::steady_clock::now();
+            auto it = m_entries.find(key);
+            if (it != m_entries.end()) {
+                if (!it->second.done || now < it->second.expires) {
+                    std::shared_future<T> shared = it->second.result;
+                    (it->second.done ? counters.hit : counters.coalesced)->inc();
+                    lock.unlock();
+                    return shared.get();
+                }
+                m_entries.erase(it);
+            }
+            if (m_entries.size() >= kSweepAt) sweep(now);
+            m_entries[key].result = promise.get_future().share();
+            counters.miss->inc();
+        }
+
+        try {
+            T value = fetch();
+            promise.set_value(value);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_entries.find(key);
+            if (ttl.count() > 0 && m_keep(value)) {
+                it->second.done = true;
+                it->second.expires = std::chrono::steady_clock::now() + ttl;
+            } else {
+                m_entries.erase(it);
+            }
+            return value;
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.erase(key);
+            throw;
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            it = it->second.done ? m_entries.erase(it) : std::next(it);
+        }
+    }
+
+private:
+    static constexpr size_t kSweepAt = 1024;
+
+    struct Entry {
+        std::shared_future<T> result;
+        bool done = false;      // false while the fetch is in flight
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // Drops expired entries; called with m_mutex held
+    void sweep(std::chrono::steady_clock::time_point now) {
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            it = it->second.done && now >= it->second.expires ? m_entries.erase(it) : std::next(it);
+        }
+    }
+
+    struct Counters {
+        Counter* hit;
+        Counter* coalesced;
+        Counter* miss;
+    };
+
+    Counters& counters_locked(const std::string& method) {
+        auto it = m_counters.find(method);
+        if (it != m_counters.end()) return it->second;
+        auto series = [&](const char* result) {
+            return &MetricsRegistry::instance().counter("deribit_rest_cache_requests_total", "Cacheable REST lookups by method and result",
+                MetricsRegistry::label("method", method) + "," + MetricsRegistry::label("result", result));
+        };
+        return m_counters.emplace(method, Counters{series("hit"), series("coalesced"), series("miss")}).first->second;
+    }
+
+    Keep m_keep;
+    std::mutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::unordered_map<std::string, Counters> m_counters;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef RISK_GATE_HPP
+#define RISK_GATE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "instrument_registry.hpp"
+
+class Counter;
+class OrderCache;
+
+// Pre-trade checks run in-process before an order is sent: order size,
+// notional (amount * price), resulting position and a price collar around
+// the local best bid/offer. Per-instrument state lives in a fixed table of
+// entries that never move, indexed by InstrumentId, so BBO and fill updates
+// from the feed thread are plain atomic stores while checks run on the
+// order threads. A limit of 0 is not checked. Limits are set at startup,
+// before orders flow. The position limit also counts working orders on the
+// order's side: open orders, whose amounts the order cache keeps current in
+// each entry as they change, and orders that reserve() passed and that are
+// still waiting for their acknowledgement.
+class RiskGate {
+public:
+    enum Result {
+        PASS,
+        ORDER_SIZE,
+        NOTIONAL,
+        POSITION,
+        PRICE_COLLAR,
+        NO_REFERENCE_PRICE,
+        TOO_MANY_INSTRUMENTS
+    };
+
+    struct Limits {
+        double max_order_amount = 0;
+        double max_notional = 0;
+        double max_position = 0;      // absolute position once working orders and this one fill
+        double price_collar = 0;      // fraction of the opposite best price, e.g. 0.05
+    };
+
+    explicit RiskGate(const Limits& defaults, size_t capacity = 1024);
+    ~RiskGate();
+
+    // {"default": {limits}, "instruments": {"BTC-PERPETUAL": {limits}}}
+    static std::unique_ptr<RiskGate> from_json(const nlohmann::json& config);
+
+    // Gives back what reserve() held when it goes out of scope
+    struct Hold {
+        RiskGate* gate = nullptr;
+        InstrumentId instrument = kNoInstrument;
+        bool buy = false;
+        double amount = 0;
+
+        Hold() = default;
+        Hold(const Hold&) = delete;
+        Hold& operator=(const Hold&) = delete;
+        ~Hold() { if (gate) gate->release(instrument, buy, amount); }
+    };
+
+    void set_limits(const std::string& instrument, const Limits& limits);
+    // Open orders count toward max_position. Not owned; must outlive the
+    // gate or be detached with set_order_cache(nullptr).
+    void set_order_cache(OrderCache* cache);
+    // price 0 is a market order, checked against the opposite best price.
+    Result check(const std::string& instrument, bool buy, double amount, double price);
+    Result check(InstrumentId instrument, bool buy, double amount, double price);
+    // check() for an order about to be sent: on PASS the amount is held as
+    // in flight until hold is destroyed, which should be after the
+    // acknowledgement is in the order cache. replaces is the open amount of
+    // an order being edited.
+    Result reserve(InstrumentId instrument, bool buy, double amount, double price, Hold& hold, double replaces = 0);
+    void release(InstrumentId instrument, bool buy, double amount);
+
+    void update_bbo(const std::string& instrument, double bid, double ask);
+    void update_bbo(InstrumentId instrument, double bid, double ask);
+    void on_fill(const std::string& instrument, double signed_amount);
+    void set_position(const std::string& instrument, double size);
+    double position(const std::string& instrument);
+
+    // Data of quote.* and user.trades.* notifications.
+    void on_channel(const std::string& channel, const nlohmann::json& data);
+
+    static const char* reason(Result result);
+
+private:
+    struct Entry {
+        Limits limits;
+        std::atomic<double> best_bid{0.0};
+        std::atomic<double> best_ask{0.0};
+        std::atomic<double> position{0.0};
+        std::atomic<double> in_flight_buy{0.0};
+        std::atomic<double> in_flight_sell{0.0};
+        std::atomic<double> open_buy{0.0};
+        std::atomic<double> open_sell{0.0};
+    };
+
+    Entry* entry(const std::string& instrument);
+    Entry* entry(InstrumentId id);
+    Result evaluate(InstrumentId instrument, bool buy, double amount, double price, double replaces, bool hold);
+    Result reject(Result result);
+
+    Limits m_defaults;
+    size_t m_capacity;
+    std::unique_ptr<Entry[]> m_entries;
+    size_t m_size = 0;
+    std::mutex m_mutex;
+    std::unique_ptr<std::atomic<Entry*>[]> m_by_id;
+    Counter* m_rejects[TOO_MANY_INSTRUMENTS + 1] = {};
+    OrderCache* m_order_cache = nullptr;
+};
+
+#endif
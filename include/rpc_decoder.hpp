@@ -0,0 +1,136 @@
+#ifndef RPC_DECODER_HPP
+#define RPC_DECODER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "instrument_registry.hpp"
+#include "order_book.hpp"
+#include "order_cache.hpp"
+
+// Typed results of the REST calls, decoded straight from the response body
+// with simdjson's on-demand parser: fields are read as the parser walks the
+// buffer, with no DOM in between, and fields not listed here are skipped.
+// The nlohmann rendering (to_json, render) is only for the CLI, which shows
+// the exchange's full answer when the caller kept the body.
+namespace rpc {
+
+struct Error {
+    int64_t code = 0;
+    std::string message;
+    std::string data;   // raw JSON, empty when absent
+};
+
+// value is empty when the exchange answered with an error
+template<typename T>
+struct Result {
+    std::optional<T> value;
+    Error error;
+    std::string body;   // the response, moved in after decoding; empty if none
+    bool ok() const { return value.has_value(); }
+};
+
+typedef OrderCache::Order Order;
+typedef InstrumentRegistry::Instrument Instrument;
+
+struct Trade {
+    std::string trade_id;
+    std::string order_id;
+    std::string instrument_name;
+    std::string direction;
+    double price = 0;
+    double amount = 0;
+    double fee = 0;
+    uint64_t timestamp = 0;
+};
+
+// Result of private/buy, sell and edit
+struct OrderAck {
+    Order order;
+    std::vector<Trade> trades;
+};
+
+struct Position {
+    std::string instrument_name;
+    std::string kind;
+    std::string direction;
+    double size = 0;
+    double average_price = 0;
+    double mark_price = 0;
+    double index_price = 0;
+    double floating_profit_loss = 0;
+    double realized_profit_loss = 0;
+    double total_profit_loss = 0;
+    double delta = 0;
+    double initial_margin = 0;
+    double maintenance_margin = 0;
+    double estimated_liquidation_price = 0;
+    double leverage = 0;
+};
+
+// Result of public/get_order_book
+struct BookSnapshot {
+    std::string instrument_name;
+    std::string state;
+    uint64_t change_id = 0;
+    uint64_t timestamp = 0;
+    double best_bid_price = 0;
+    double best_bid_amount = 0;
+    double best_ask_price = 0;
+    double best_ask_amount = 0;
+    double mark_price = 0;
+    double index_price = 0;
+    double last_price = 0;
+    double open_interest = 0;
+    std::vector<OrderBook::Level> bids;
+    std::vector<OrderBook::Level> asks;
+};
+
+// The body's capacity is grown in place if it is short of the padding the
+// parser reads past the end. Malformed bodies throw.
+Result<OrderAck> decode_order_ack(std::string& body);
+// private/cancel returns the order alone
+Result<Order> decode_order(std::string& body);
+Result<std::vector<Position>> decode_positions(std::string& body);
+Result<BookSnapshot> decode_book(std::string& body);
+Result<std::vector<Instrument>> decode_instruments(std::string& body);
+// Mass cancels: the number of orders cancelled
+Result<uint64_t> decode_count(std::string& body);
+
+nlohmann::json to_json(const Error& error);
+nlohmann::json to_json(const Order& order);
+nlohmann::json to_json(const Trade& trade);
+nlohmann::json to_json(const OrderAck& ack);
+nlohmann::json to_json(const Position& position);
+nlohmann::json to_json(const BookSnapshot& book);
+inline nlohmann::json to_json(uint64_t count) { return count; }
+
+template<typename T>
+nlohmann::json to_json(const std::vector<T>& values) {
+    nlohmann::json out = nlohmann::json::array();
+    for (const auto& value : values) out.push_back(to_json(value));
+    return out;
+}
+
+// "result" or "error" of a response body exactly as sent, or null if it
+// has neither or does not parse
+nlohmann::json raw_member(const std::string& body, const char* member);
+
+// What the managers' string methods return: the error object, or the
+// result pretty-printed. Taken from the body when there is one, so fields
+// the typed structs skip are still shown.
+template<typename T>
+std::string render(const Result<T>& result) {
+    if (!result.body.empty()) {
+        nlohmann::json raw = raw_member(result.body, result.ok() ? "result" : "error");
+        if (!raw.is_null()) return result.ok() ? raw.dump(4) : raw.dump();
+    }
+    if (!result.ok()) return to_json(result.error).dump();
+    return to_json(*result.value).dump(4);
+}
+
+}
+
+#endif
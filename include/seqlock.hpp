@@ -0,0 +1,58 @@
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock around a small trivially copyable value.
+// Readers never block the writer: they copy the value and retry if the
+// sequence moved (or was odd, i.e. a write was in progress) meanwhile. The
+// value is held as relaxed atomic words so the racing copy is well defined.
+// Concurrent writers must be serialized by the caller.
+template<typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock needs a trivially copyable type");
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    Seqlock() { store(T()); }
+    explicit Seqlock(const T& value) { store(value); }
+    Seqlock(const Seqlock&) = delete;
+    Seqlock& operator=(const Seqlock&) = delete;
+
+    void store(const T& value) {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+
+        uint64_t seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) m_words[i].store(words[i], std::memory_order_relaxed);
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        uint64_t words[kWords];
+        for (;;) {
+            uint64_t before = m_seq.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            for (size_t i = 0; i < kWords; ++i) words[i] = m_words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_seq.load(std::memory_order_relaxed) == before) break;
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    // Bumped by two on every store
+    uint64_t version() const { return m_seq.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint64_t> m_seq{0};
+    std::atomic<uint64_t> m_words[kWords];
+};
+
+#endif
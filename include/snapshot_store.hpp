@@ -0,0 +1,158 @@
+#ifndef SNAPSHOT_STORE_HPP
+#define SNAPSHOT_STORE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "order_book.hpp"
+
+// Columnar on-disk store for periodic top-N book snapshots and trades.
+//
+// A store is a directory of store-NNNNNN.dcs files. Each file holds blocks of
+// up to block_rows rows for one instrument and one record kind, laid out
+// column by column. Prices and amounts are fixed point (value * scale) and
+// every column is delta encoded against the previous row and written as a
+// zigzag varint. Instrument names are dictionary encoded. The file footer
+// holds the dictionary and an index of blocks (instrument, kind, time range,
+// column offsets), so a query maps the file but only touches the columns of
+// the blocks overlapping the requested time range.
+namespace snapshot_store {
+
+constexpr uint32_t kMagic = 0x31534344; // "DCS1"
+constexpr uint32_t kVersion = 1;
+
+enum Kind : uint8_t {
+    SNAPSHOT = 0,
+    TRADE = 1
+};
+
+enum Field : uint8_t {
+    BID_PRICE,
+    BID_AMOUNT,
+    ASK_PRICE,
+    ASK_AMOUNT,
+    CHANGE_ID,
+    TRADE_PRICE,
+    TRADE_AMOUNT,
+    TRADE_DIRECTION   // 1 buy, 0 sell
+};
+
+struct Column {
+    Field field;
+    uint32_t level = 0;   // book level for the bid/ask fields
+};
+
+}
+
+class SnapshotStoreWriter {
+public:
+    struct Options {
+        std::string directory;
+        uint32_t depth = 10;
+        uint32_t block_rows = 4096;
+        double price_scale = 1e4;
+        double amount_scale = 1e4;
+    };
+
+    explicit SnapshotStoreWriter(const Options& options);
+    ~SnapshotStoreWriter();
+
+    // Records the top `depth` levels of the book at its last update time.
+    void add_snapshot(const OrderBook& book);
+    void add_trade(const std::string& instrument, uint64_t timestamp_ms, double price, double amount, bool buy);
+
+    // Flushes open blocks and writes the footer. Called by the destructor.
+    void close();
+
+    uint64_t rows_written() const { return m_rows; }
+    uint64_t bytes_written() const { return m_offset; }
+    const std::string& path() const { return m_path; }
+
+private:
+    struct Block {
+        uint32_t instrument;
+        snapshot_store::Kind kind;
+        std::vector<std::vector<int64_t>> columns;   // column 0 is the timestamp
+        size_t rows() const { return columns.empty() ? 0 : columns[0].size(); }
+    };
+
+    struct IndexEntry {
+        uint32_t instrument;
+        uint8_t kind;
+        uint32_t rows;
+        uint64_t first_ms;
+        uint64_t last_ms;
+        std::vector<std::pair<uint64_t, uint64_t>> columns;   // offset, length
+    };
+
+    uint32_t instrument_id(const std::string& name);
+    Block& open_block(uint32_t instrument, snapshot_store::Kind kind, size_t columns);
+    void flush_block(Block& block);
+    void write(const void* data, size_t size);
+
+    Options m_options;
+    std::string m_path;
+    std::FILE* m_file = nullptr;
+    uint64_t m_offset = 0;
+    uint64_t m_rows = 0;
+    std::unordered_map<std::string, uint32_t> m_instrument_ids;
+    std::vector<std::string> m_instruments;
+    std::map<std::pair<uint32_t, uint8_t>, Block> m_open;
+    std::vector<IndexEntry> m_index;
+};
+
+class SnapshotStore {
+public:
+    // Rows in time order; columns[i] holds the values of the i-th requested column.
+    struct Result {
+        std::vector<uint64_t> timestamps;
+        std::vector<std::vector<double>> columns;
+    };
+
+    explicit SnapshotStore(const std::string& directory);
+    ~SnapshotStore();
+    SnapshotStore(const SnapshotStore&) = delete;
+    SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+    std::vector<std::string> instruments() const;
+
+    // Inclusive time range in exchange milliseconds.
+    Result query_snapshots(const std::string& instrument, uint64_t from_ms, uint64_t to_ms,
+                           const std::vector<snapshot_store::Column>& columns) const;
+    Result query_trades(const std::string& instrument, uint64_t from_ms, uint64_t to_ms,
+                        const std::vector<snapshot_store::Column>& columns) const;
+
+    // Encoded column bytes decoded by queries so far.
+    uint64_t bytes_scanned() const { return m_bytes_scanned; }
+
+private:
+    struct BlockRef {
+        uint8_t kind;
+        uint32_t rows;
+        uint64_t first_ms;
+        uint64_t last_ms;
+        std::vector<std::pair<uint64_t, uint64_t>> columns;
+    };
+
+    struct File {
+        const char* map = nullptr;
+        size_t size = 0;
+        uint32_t depth = 0;
+        double price_scale = 1.0;
+        double amount_scale = 1.0;
+        // Blocks per instrument name, in file order
+        std::unordered_map<std::string, std::vector<BlockRef>> blocks;
+    };
+
+    void open_file(const std::string& path);
+    Result query(const std::string& instrument, snapshot_store::Kind kind, uint64_t from_ms, uint64_t to_ms,
+                 const std::vector<snapshot_store::Column>& columns) const;
+
+    std::vector<File> m_files;
+    mutable uint64_t m_bytes_scanned = 0;
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded single-producer/single-consumer ring. Capacity is rounded up to a
+// power of two. Each side caches the other's index so the shared cache line
+// is only read when the cached view says the ring is full or empty.
+template<typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        m_buffer.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side
+    template<typename U>
+    bool try_push(U&& value) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head_cache == m_buffer.size()) {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+            if (tail - m_head_cache == m_buffer.size()) return false;
+        }
+        m_buffer[tail & m_mask] = std::forward<U>(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool try_pop(T& out) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail_cache) {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tail_cache) return false;
+        }
+        out = std::move(m_buffer[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // In-place variants: fill writes into the slot and consume reads it where
+    // it lies, so a slot's buffers (e.g. string capacity) are reused instead
+    // of being moved out and reallocated on the next push.
+    template<typename Fill>
+    bool try_push_with(Fill&& fill) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head_cache == m_buffer.size()) {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+            if (tail - m_head_cache == m_buffer.size()) return false;
+        }
+        fill(m_buffer[tail & m_mask]);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    template<typename Consume>
+    bool try_pop_with(Consume&& consume) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail_cache) {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tail_cache) return false;
+        }
+        consume(m_buffer[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size_approx() const {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size_approx() == 0; }
+    size_t capacity() const { return m_buffer.size(); }
+
+private:
+    std::vector<T> m_buffer;
+    size_t m_mask = 0;
+
+    alignas(64) std::atomic<size_t> m_head{0};
+    size_t m_tail_cache = 0;
+
+    alignas(64) std::atomic<size_t> m_tail{0};
+    size_t m_head_cache = 0;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef THREAD_AFFINITY_HPP
+#define THREAD_AFFINITY_HPP
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "logger.hpp"
+
+// Placement of the latency-critical threads. Each role has a list of cores
+// and its threads take them round robin as they start; a role without cores
+// stays unpinned. Memory is placed by first touch, so threads pin themselves
+// before allocating their buffers to keep them on the core's NUMA node.
+// With busy-poll the io loops spin on poll() instead of sleeping in epoll,
+// trading a core each for the wake-up latency.
+class ThreadAffinity {
+public:
+    enum Role { FEED, FANOUT, ORDER, SERVER, ROLE_COUNT };
+
+    static ThreadAffinity& instance();
+
+    // "2,3,8-11" into cpus. False, leaving cpus empty, if an entry is not a
+    // number or range, or names a CPU outside 0 to CPU_SETSIZE - 1.
+    static bool parse_cpu_list(const std::string& list, std::vector<int>& cpus);
+    void set_cpus(Role role, const std::vector<int>& cpus);
+    void set_busy_poll(bool enabled) { m_busy_poll.store(enabled, std::memory_order_relaxed); }
+    bool busy_poll() const { return m_busy_poll.load(std::memory_order_relaxed); }
+
+    // Pins the calling thread to the role's next core and names it after the
+    // role. Returns the core, or -1 if the role is unpinned or pinning failed.
+    int pin_current_thread(Role role);
+
+    // Runs an asio-based websocketpp endpoint until it stops.
+    template<typename Endpoint>
+    void run(Endpoint& endpoint) const {
+        if (!busy_poll()) {
+            endpoint.run();
+            return;
+        }
+        while (!endpoint.stopped()) {
+            if (endpoint.poll() == 0) cpu_relax();
+        }
+    }
+
+    static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    static const char* role_name(Role role);
+
+    Logger logger;
+private:
+    ThreadAffinity() = default;
+
+    std::mutex m_mutex;
+    std::vector<int> m_cpus[ROLE_COUNT];
+    size_t m_next[ROLE_COUNT] = {};
+    std::atomic<bool> m_busy_poll{false};
+};
+
+#endif
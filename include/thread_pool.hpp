@@ -0,0 +1,55 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of workers draining a bounded FIFO. submit() blocks while the
+// queue is full, so a burst of requests applies back-pressure to the caller
+// instead of growing without limit. A task that submits to its own pool and
+// waits for the result can therefore deadlock; check on_worker_thread() and
+// run such work inline. The destructor runs what is queued and joins the
+// workers. thread_init, if set, runs first on every worker.
+class ThreadPool {
+public:
+    ThreadPool(size_t workers, size_t queue_capacity, std::function<void()> thread_init = nullptr);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    auto submit(F&& task) -> std::future<typename std::invoke_result<F>::type> {
+        typedef typename std::invoke_result<F>::type Result;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        post([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    size_t workers() const { return m_workers.size(); }
+    // True when called from one of this pool's workers
+    bool on_worker_thread() const;
+    size_t queued() const;
+
+private:
+    void post(std::function<void()> task);
+    void run();
+
+    size_t m_capacity;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::deque<std::function<void()>> m_tasks;
+    bool m_stopping = false;
+    std::vector<std::thread> m_workers;
+};
+
+#endif
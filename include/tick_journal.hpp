@@ -0,0 +1,146 @@
+#ifndef TICK_JOURNAL_HPP
+#define TICK_JOURNAL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "logger.hpp"
+#include "spsc_queue.hpp"
+
+// On-disk layout. A journal is a directory of journal-NNNNNN.dtj segments,
+// each a SegmentHeader followed by 8-byte aligned records. A zero length
+// marks the end of the written part of a segment. Channel names are written
+// once per segment as CHANNEL records and frames refer to them by id (0 for
+// frames without a channel: heartbeats, RPC replies).
+namespace journal {
+
+constexpr uint32_t kSegmentMagic = 0x314a5444; // "DTJ1"
+constexpr uint32_t kVersion = 1;
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t index;
+    uint64_t created_ns;
+    uint64_t reserved;
+};
+
+enum RecordType : uint16_t {
+    FRAME = 1,
+    CHANNEL = 2
+};
+
+struct RecordHeader {
+    uint32_t length;       // payload bytes, excluding header and padding
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t channel_id;
+    uint32_t reserved2;
+    uint64_t received_ns;  // wall clock at socket read
+};
+
+inline size_t padded(size_t bytes) { return (bytes + 7) & ~size_t(7); }
+
+}
+
+// Append-only journal of upstream frames. The feed thread only timestamps
+// the frame and moves it into a lock-free queue; a writer thread frames it
+// into pre-allocated memory-mapped segments and rolls to a new segment when
+// the current one is full.
+class TickJournal {
+public:
+    struct Options {
+        std::string directory;
+        size_t segment_bytes = 64 << 20;
+        size_t queue_capacity = 1 << 16;
+    };
+
+    explicit TickJournal(const Options& options);
+    ~TickJournal();
+
+    void start();
+    // Drains the queue, then closes the current segment.
+    void stop();
+
+    // Feed thread only (single producer). Returns false if the queue was full
+    // and the frame dropped.
+    bool append(uint64_t received_ns, std::string&& payload);
+    bool append(uint64_t received_ns, const std::string& payload) { return append(received_ns, std::string(payload)); }
+
+    uint64_t frames_written() const { return m_frames.load(std::memory_order_relaxed); }
+    uint64_t bytes_written() const { return m_bytes.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t segments() const { return m_segment_count.load(std::memory_order_relaxed); }
+    size_t queue_depth() const { return m_queue.size_approx(); }
+
+    static uint64_t now_ns();
+
+    Logger logger;
+private:
+    struct Entry {
+        uint64_t received_ns = 0;
+        std::string payload;
+    };
+
+    void writer_loop();
+    void write_frame(const Entry& entry);
+    void write_record(journal::RecordType type, uint32_t channel_id, uint64_t received_ns, std::string_view payload);
+    uint32_t channel_id(std::string_view channel);
+    void open_segment();
+    void close_segment();
+
+    Options m_options;
+    SpscQueue<Entry> m_queue;
+    std::thread m_writer;
+    std::atomic<bool> m_running{false};
+
+    // Writer thread state
+    int m_fd = -1;
+    char* m_map = nullptr;
+    size_t m_offset = 0;
+    uint64_t m_next_index = 0;
+    std::unordered_map<std::string, uint32_t> m_channel_ids;
+    std::vector<std::string> m_channel_names;
+    std::vector<bool> m_defined;
+
+    std::atomic<uint64_t> m_frames{0};
+    std::atomic<uint64_t> m_bytes{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_segment_count{0};
+};
+
+// Sequential scan over every segment of a journal directory, oldest first.
+// Views in a Record stay valid until the reader moves to the next segment.
+class TickJournalReader {
+public:
+    struct Record {
+        uint64_t received_ns;
+        uint32_t channel_id;
+        std::string_view channel;
+        std::string_view payload;
+    };
+
+    explicit TickJournalReader(const std::string& directory);
+    ~TickJournalReader();
+
+    bool next(Record& out);
+    uint64_t segment_index() const { return m_segment; }
+
+private:
+    bool open_next_segment();
+    void close_segment();
+
+    std::vector<std::string> m_paths;
+    size_t m_next_path = 0;
+    const char* m_map = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+    uint64_t m_segment = 0;
+    std::unordered_map<uint32_t, std::string> m_channels;
+};
+
+#endif
@@ -3,12 +3,24 @@
 
 #include <websocketpp/config/asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
+#include <atomic>
+#include <future>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <string>
 #include <mutex>
+#include <thread>
+#include <nlohmann/json.hpp>
 #include "logger.hpp"
 #include "deribit_client.hpp"
+#include "idle_waiter.hpp"
+#include "metrics.hpp"
+#include "instrument_registry.hpp"
+#include "latency_trace.hpp"
+#include "market_data_publisher.hpp"
+#include "spsc_queue.hpp"
 
 typedef websocketpp::server<websocketpp::config::asio> server;
 typedef websocketpp::connection_hdl connection_hdl;
@@ -28,25 +40,91 @@ struct connection_equal {
 
 class WebSocketServer {
 public:
-    WebSocketServer(DeribitClient& m_deribit_client);
+    // Updates are handed to fanout_workers threads over bounded SPSC queues,
+    // so a slow subscriber never holds up the upstream reader. With 0
+    // workers publish() broadcasts inline.
+    WebSocketServer(DeribitClient& m_deribit_client, size_t fanout_workers = 1, size_t queue_capacity = 4096);
+    ~WebSocketServer();
 
     void run(uint16_t port);
     void stop();
     bool is_running() const;
+    // Fans an upstream channel update out to local subscribers. Called from
+    // one thread only (the upstream io thread); an update that finds its
+    // worker's queue full is dropped and counted. The channel is resolved to
+    // its instrument on first sight and the id is carried from there on.
+    void publish(const std::string& channel, const std::string& data);
+    // Also writes these symbols' books to a shared-memory bus. Their slots
+    // are resolved here and publish() only queues the frame to the bus
+    // publisher's own thread, which this starts. Call before run().
+    void set_market_data_publisher(MarketDataPublisher* publisher, const std::vector<std::string>& symbols);
     Logger logger;
 private:
     void on_message(connection_hdl hdl, server::message_ptr msg);
-    void broadcast_orderbook(const std::string& symbol, const std::string& orderbook_update);
+    InstrumentId channel_instrument(const std::string& channel);
+    void broadcast_orderbook(InstrumentId instrument, const std::string& orderbook_update);
     void handle_subscription(connection_hdl hdl, const std::string& symbol);
     void send_subscription_confirmation(connection_hdl hdl, const std::string& symbol);
+    void send_latency_report(connection_hdl hdl, const nlohmann::json& request);
+
+    // Per-channel series, resolved once so the broadcast path skips the registry lock
+    struct ChannelMetrics {
+        Gauge* subscribers;
+        Gauge* queued_bytes;
+        Counter* sent;
+    };
+    typedef std::unordered_set<connection_hdl, connection_hash, connection_equal> connection_set;
+
+    // Local subscribers of one instrument's book channel, indexed by InstrumentId
+    struct Subscribers {
+        std::string channel;
+        connection_set connections;
+        ChannelMetrics metrics{};
+    };
+    Subscribers& subscribers(InstrumentId id, const std::string& channel);
+
+    // Slots are reused, so their buffers only grow for frames larger than
+    // any seen in that slot before.
+    struct Update {
+        Update() {
+            data.reserve(1024);
+        }
+        InstrumentId instrument = kNoInstrument;
+        std::string data;
+        uint64_t enqueued_ns = 0;
+        LatencyTrace::Handoff trace;
+    };
+    // An instrument always maps to the same worker, so its updates stay in order.
+    // The queue is allocated by the worker after it is pinned. Unless
+    // busy-polling, an idle worker is parked and publish() wakes it.
+    struct FanoutWorker {
+        std::unique_ptr<SpscQueue<Update>> queue;
+        IdleWaiter waiter;
+        std::thread thread;
+        Gauge* depth = nullptr;
+    };
+    void fanout_loop(FanoutWorker& worker, size_t queue_capacity, std::promise<void>& ready);
+    server::message_ptr outbound_message(const std::string& payload);
+
+    // Messages still queued to slow clients are not reused, so the pool is
+    // capped and further updates are allocated on their own
+    static constexpr size_t kMessagePoolSize = 64;
 
     server m_server;
-    DeribitClient m_deribit_client;
+    DeribitClient& m_deribit_client;
     std::mutex m_mutex;
-    std::unordered_set<connection_hdl, connection_hash, connection_equal> m_connections;
-    std::unordered_map<std::string, 
-        std::unordered_set<connection_hdl, connection_hash, connection_equal>> m_subscriptions;
+    connection_set m_connections;
+    std::vector<Subscribers> m_subscriptions;
+    std::vector<server::message_ptr> m_message_pool;
+    size_t m_message_pool_next = 0;
     bool m_running;
+    std::atomic<bool> m_fanout_running{false};
+    std::vector<std::unique_ptr<FanoutWorker>> m_workers;
+    MarketDataPublisher* m_publisher = nullptr;
+    std::vector<int> m_bus_slots;   // by InstrumentId, -1 if not on the bus; fixed before run()
+    // Upstream channel -> the instrument whose book it carries, or
+    // kNoInstrument. Only touched by the publishing thread.
+    std::unordered_map<std::string, InstrumentId> m_channel_ids;
 };
 
 #endif
\ No newline at end of file
@@ -1,166 +1,166 @@
 #include "order_manager.hpp"
-#include "performance_tracker.hpp"
+#include "instrumented.hpp"
 #include "config.h"
 #include "market_manager.hpp"
-#include <unordered_map>
+#include "instrument_loader.hpp"
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
 #include <vector>
-#include <numeric>
 
-class PerformanceOrderManager {
-public:
-    PerformanceOrderManager(OrderManager& manager) : manager(manager) {}
-
-    // Method to get performance statistics for a specific function
-    struct PerformanceStats {
-        double avg_time = 0.0;
-        double min_time = std::numeric_limits<double>::max();
-        double max_time = std::numeric_limits<double>::min();
-        size_t call_count = 0;
-    };
-
-    // Get stats for a specific function
-    PerformanceStats get_stats(const std::string& function_name) const {
-        if (performance_data.find(function_name) != performance_data.end()) {
-            return calculate_stats(performance_data.at(function_name));
+void print_stats(const std::string& title, const HistogramSet& stats) {
+    std::cout << title << std::endl;
+    stats.for_each([](const char* name, const LatencyHistogram& histogram) {
+        auto s = histogram.summary();
+        auto ms = [](uint64_t nanos) { return nanos / 1e6; };
+        std::cout << "  " << name << ": count=" << s.count
+                  << " avg=" << s.mean / 1e6 << "ms"
+                  << " p50=" << ms(s.p50) << "ms"
+                  << " p90=" << ms(s.p90) << "ms"
+                  << " p99=" << ms(s.p99) << "ms"
+                  << " p99.9=" << ms(s.p999) << "ms"
+                  << " max=" << ms(s.max) << "ms" << std::endl;
+    });
+}
+
+// Sends the same burst of limit orders one after another and then through
+// the async API, and reports wall time and throughput for both.
+nlohmann::json run_concurrency_test(OrderManager& order_manager, size_t orders) {
+    auto run = [&](const char* name, bool async) {
+        std::vector<std::future<std::string>> pending;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < orders; ++i) {
+            const char* symbol = i % 2 ? "ETH-PERPETUAL" : "BTC-PERPETUAL";
+            if (async) pending.push_back(order_manager.place_order_async(symbol, "buy", "limit", "1", "10000"));
+            else order_manager.place_order(symbol, "buy", "limit", "1", "10000");
         }
-        return PerformanceStats{};
-    }
-
-    // Clear performance data
-    void clear_stats() {
-        performance_data.clear();
-    }
-
-    // Wrapped methods with performance tracking
-    std::string view_current_positions(const std::string& currency, const std::string& kind) {
-        return performance_wrapper("view_current_positions", [&]() {
-            return manager.view_current_positions(currency, kind);
-        });
-    }
-
-    std::string get_orderbook(const std::string& order_id) {
-        return performance_wrapper("get_orderbook", [&]() {
-            return manager.get_orderbook(order_id);
-        });
-    }
-
-    std::string place_order(const std::string& symbol, const std::string& side, 
-                           const std::string& type, const std::string& quantity, 
-                           const std::string& price) {
-        return performance_wrapper("place_order", [&]() {
-            return manager.place_order(symbol, side, type, quantity, price);
-        });
-    }
-
-    std::string cancel_order(const std::string& order_id) {
-        return performance_wrapper("cancel_order", [&]() {
-            return manager.cancel_order(order_id);
-        });
-    }
-
-    std::string modify_order(const std::string& order_id, const std::string& quantity, 
-                            const std::string& price) {
-        return performance_wrapper("modify_order", [&]() {
-            return manager.modify_order(order_id, quantity, price);
-        });
-    }
-
-private:
-    OrderManager& manager;
-    std::unordered_map<std::string, std::vector<double>> performance_data;
-
-    template<typename Func>
-    std::string performance_wrapper(const std::string& funcName, Func&& func) {
-        PerformanceTracker tracker(funcName);
-        auto result = std::forward<Func>(func)();
-        double elapsed = tracker.elapsed_time();
-        
-        // Store timing data
-        if (performance_data.find(funcName) == performance_data.end()) {
-            performance_data[funcName] = std::vector<double>();
-        }
-        performance_data[funcName].push_back(elapsed);
-        
-        return result;
-    }
-
-    PerformanceStats calculate_stats(const std::vector<double>& times) const {
-        PerformanceStats stats;
-        if (times.empty()) return stats;
-
-        stats.call_count = times.size();
-        stats.min_time = *std::min_element(times.begin(), times.end());
-        stats.max_time = *std::max_element(times.begin(), times.end());
-        stats.avg_time = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
-
-        return stats;
+        for (auto& result : pending) result.get();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << name << ": orders=" << orders << " wall=" << seconds * 1e3 << "ms"
+                  << " throughput=" << orders / seconds << " orders/s" << std::endl;
+        return nlohmann::json{{"orders", orders}, {"wall_ms", seconds * 1e3}, {"orders_per_second", orders / seconds}};
+    };
+    std::cout << "Concurrent Order Throughput (" << ORDER_WORKERS << " workers):" << std::endl;
+    nlohmann::json sequential = run("sequential", false);
+    nlohmann::json concurrent = run("concurrent", true);
+    return {{"workers", ORDER_WORKERS}, {"sequential", sequential}, {"concurrent", concurrent}};
+}
+
+// Puts up a ladder of `levels` bids and pulls it again, first with one call
+// per order and then with place_orders plus a single cancel_by_label.
+nlohmann::json run_requote_test(OrderManager& order_manager, size_t levels) {
+    std::vector<OrderManager::OrderRequest> ladder;
+    for (size_t i = 0; i < levels; ++i) {
+        ladder.push_back({"BTC-PERPETUAL", "buy", "limit", "10", std::to_string(10000 - 10 * static_cast<int>(i)), "requote"});
     }
-};
-
-class PerformanceMarketManager {
-public:
-    PerformanceMarketManager(MarketManager& manager) : manager(manager) {}
-
-    // Method to get performance statistics for a specific function
-    struct PerformanceStats {
-        double avg_time = 0.0;
-        double min_time = std::numeric_limits<double>::max();
-        double max_time = std::numeric_limits<double>::min();
-        size_t call_count = 0;
+    auto elapsed_ms = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     };
 
-    // Get stats for a specific function
-    PerformanceStats get_stats(const std::string& function_name) const {
-        if (performance_data.find(function_name) != performance_data.end()) {
-            return calculate_stats(performance_data.at(function_name));
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> order_ids;
+    for (const auto& order : ladder) {
+        try {
+            auto ack = order_manager.place(order);
+            if (ack.ok()) order_ids.push_back(ack.value->order.order_id);
+        } catch (const std::exception& e) {
         }
-        return PerformanceStats{};
     }
-
-    // Clear performance data
-    void clear_stats() {
-        performance_data.clear();
+    for (const auto& order_id : order_ids) {
+        try {
+            order_manager.cancel(order_id);
+        } catch (const std::exception& e) {
+        }
     }
-
-    // Wrapped methods with performance tracking
-    std::string get_market_data(const std::string& currency, const std::string& kind) {
-        return performance_wrapper("get_market_data", [&]() {
-            return manager.view_all_instruments(currency, kind);
-        });
+    double loop_ms = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    nlohmann::json batch = nlohmann::json::parse(order_manager.place_orders(ladder));
+    order_manager.cancel_by_label("requote");
+    double batch_ms = elapsed_ms(start);
+
+    std::cout << "Requote (" << levels << " levels):" << std::endl;
+    std::cout << "  loop: wall=" << loop_ms << "ms placed=" << order_ids.size() << std::endl;
+    std::cout << "  batch: wall=" << batch_ms << "ms placed=" << batch["placed"] << std::endl;
+    return {{"levels", levels}, {"loop_ms", loop_ms}, {"batch_ms", batch_ms}};
+}
+
+// Time until the instrument lists are usable: one request after another,
+// then in parallel with no cache file, then restored from that file.
+nlohmann::json run_warm_start_test(DeribitClient& client) {
+    InstrumentLoader::Lists lists = InstrumentLoader::default_lists();
+    std::string cache_path = INSTRUMENT_CACHE_FILE.empty() ? "instruments.cache" : INSTRUMENT_CACHE_FILE;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& list : lists) client.get_all_instruments(list.first, list.second);
+    double sequential_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::remove(cache_path.c_str());
+    InstrumentLoader cold_loader(client, cache_path);
+    cold_loader.start(lists);
+    InstrumentLoader::Report cold = cold_loader.wait();
+    InstrumentLoader warm_loader(client, cache_path);
+    warm_loader.start(lists);
+    InstrumentLoader::Report warm = warm_loader.wait();
+
+    std::cout << "Instrument Warm Start (" << lists.size() << " lists, " << cold.instruments << " instruments):" << std::endl;
+    std::cout << "  sequential: ready=" << sequential_ms << "ms" << std::endl;
+    std::cout << "  cold cache: ready=" << cold.ready_ms << "ms failed=" << cold.failed << std::endl;
+    std::cout << "  warm cache: ready=" << warm.ready_ms << "ms refreshed=" << warm.refreshed_ms << "ms" << std::endl;
+    return {{"lists", lists.size()}, {"instruments", cold.instruments}, {"sequential_ms", sequential_ms},
+            {"cold_ready_ms", cold.ready_ms}, {"warm_ready_ms", warm.ready_ms}, {"warm_refreshed_ms", warm.refreshed_ms}};
+}
+
+void usage() {
+    std::cout << "Usage: deribit_benchmark [--csv PATH] [--json PATH] [--concurrency N] [--requote N] [--warm-start]" << std::endl;
+}
+
+// Whole non-negative numbers only; false for anything else
+bool parse_count(const std::string& text, size_t& value) {
+    if (text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+    try {
+        size_t used = 0;
+        value = std::stoul(text, &used);
+        return used == text.size();
+    } catch (const std::exception&) {
+        return false;
     }
-private:
-    MarketManager& manager;
-    std::unordered_map<std::string, std::vector<double>> performance_data;
-
-    template<typename Func>
-    std::string performance_wrapper(const std::string& funcName, Func&& func) {
-        PerformanceTracker tracker(funcName);
-        auto result = std::forward<Func>(func)();
-        double elapsed = tracker.elapsed_time();
-        
-        // Store timing data
-        if (performance_data.find(funcName) == performance_data.end()) {
-            performance_data[funcName] = std::vector<double>();
+}
+
+int main(int argc, char* argv[]) {
+    std::string csv_path, json_path;
+    size_t concurrent_orders = 0;
+    size_t requote_levels = 0;
+    bool warm_start = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--warm-start") {
+            warm_start = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--csv") csv_path = value;
+        else if (arg == "--json") json_path = value;
+        else if (arg == "--concurrency" || arg == "--requote") {
+            size_t& count = arg == "--concurrency" ? concurrent_orders : requote_levels;
+            if (!parse_count(value, count)) {
+                std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+                usage();
+                return 1;
+            }
+        } else {
+            usage();
+            return 1;
         }
-        performance_data[funcName].push_back(elapsed);
-        
-        return result;
-    }
-
-    PerformanceStats calculate_stats(const std::vector<double>& times) const {
-        PerformanceStats stats;
-        if (times.empty()) return stats;
-
-        stats.call_count = times.size();
-        stats.min_time = *std::min_element(times.begin(), times.end());
-        stats.max_time = *std::max_element(times.begin(), times.end());
-        stats.avg_time = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
-
-        return stats;
     }
-};
 
-int main (){
     // tests for bench marking requests
     loadConfig();
     DeribitClient deribit_client;
@@ -168,8 +168,8 @@ int main (){
     OrderManager order_manager_instance(deribit_client);
     MarketManager market_manager_instance(deribit_client);
 
-    PerformanceOrderManager order_manager(order_manager_instance);
-    PerformanceMarketManager market_manager(market_manager_instance);
+    Instrumented<OrderManager> order_manager(order_manager_instance);
+    Instrumented<MarketManager> market_manager(market_manager_instance);
 
     //tests
     std::vector<std::vector<std::string>> order_tests = {
@@ -210,15 +210,15 @@ int main (){
         try {
 
         if (test[0] == "place_order") {
-            order_manager.place_order(test[1], test[2], test[3], test[4], test[5]);
+            order_manager.call("place_order", &OrderManager::place_order, test[1], test[2], test[3], test[4], test[5]);
         } else if (test[0] == "cancel_order") {
-            order_manager.cancel_order(test[1]);
+            order_manager.call("cancel_order", &OrderManager::cancel_order, test[1]);
         } else if (test[0] == "modify_order") {
-            order_manager.modify_order(test[1], test[2], test[3]);
+            order_manager.call("modify_order", &OrderManager::modify_order, test[1], test[2], test[3]);
         } else if (test[0] == "view_current_positions") {
-            order_manager.view_current_positions(test[1], test[2]);
+            order_manager.call("view_current_positions", &OrderManager::view_current_positions, test[1], test[2]);
         } else if (test[0] == "get_orderbook") {
-            order_manager.get_orderbook(test[1]);
+            order_manager.call("get_orderbook", &OrderManager::get_orderbook, test[1]);
         }
         }
         catch (const std::exception& e) {
@@ -229,7 +229,7 @@ int main (){
     for (const auto& test : market_tests) {
         try {
             if (test[0] == "get_market_data") {
-                market_manager.get_market_data(test[1], test[2]);
+                market_manager.call("get_market_data", &MarketManager::view_all_instruments, test[1], test[2]);
             }
         }
         catch (const std::exception& e) {
@@ -237,34 +237,37 @@ int main (){
         }
     }
 
-    std::cout << "Order Manager Performance Stats:" << std::endl;
-    std::cout << "place_order: ";
-    std::cout << "AverageTime" << order_manager.get_stats("place_order").avg_time << "ms" << std::endl;
-    std::cout << "MaxTime" << order_manager.get_stats("place_order").max_time << "ms" << std::endl;
-    std::cout << "MinTime" << order_manager.get_stats("place_order").min_time << "ms" << std::endl;
-    std::cout << "cancel_order: ";
-    std::cout << "AverageTime" << order_manager.get_stats("cancel_order").avg_time << "ms" << std::endl;
-    std::cout << "MaxTime" << order_manager.get_stats("cancel_order").max_time << "ms" << std::endl;
-    std::cout << "MinTime" << order_manager.get_stats("cancel_order").min_time << "ms" << std::endl;
-    std::cout << "modify_order: ";
-    std::cout << "AverageTime" << order_manager.get_stats("modify_order").avg_time << "ms" << std::endl;
-    std::cout << "MaxTime" << order_manager.get_stats("modify_order").max_time << "ms" << std::endl;
-    std::cout << "MinTime" << order_manager.get_stats("modify_order").min_time << "ms" << std::endl;
-    std::cout << "view_current_positions: ";
-    std::cout << "AverageTime" << order_manager.get_stats("view_current_positions").avg_time << "ms" << std::endl;
-    std::cout << "MaxTime" << order_manager.get_stats("view_current_positions").max_time << "ms" << std::endl;
-    std::cout << "MinTime" << order_manager.get_stats("view_current_positions").min_time << "ms" << std::endl;
-    std::cout << "get_orderbook: ";
-    std::cout << "AverageTime" << order_manager.get_stats("get_orderbook").avg_time << "ms" << std::endl;
-    std::cout << "MaxTime" << order_manager.get_stats("get_orderbook").max_time << "ms" << std::endl;
-    std::cout << "MinTime" << order_manager.get_stats("get_orderbook").min_time << "ms" << std::endl;
-
-
+    print_stats("Order Manager Performance Stats:", order_manager.stats());
+    print_stats("Market Manager Performance Stats:", market_manager.stats());
 
-    std::cout << "Market Manager Performance Stats:" << std::endl;
-    std::cout << "get_market_data: ";
-    std::cout << "AverageTime" << market_manager.get_stats("get_market_data").avg_time << "ms" << std::endl;
-    std::cout << "MaxTime" << market_manager.get_stats("get_market_data").max_time << "ms" << std::endl;
-    std::cout << "MinTime" << market_manager.get_stats("get_market_data").min_time << "ms" << std::endl;
+    nlohmann::json concurrency;
+    if (concurrent_orders > 0) {
+        concurrency = run_concurrency_test(order_manager_instance, concurrent_orders);
+    }
+    nlohmann::json requote;
+    if (requote_levels > 0) {
+        requote = run_requote_test(order_manager_instance, requote_levels);
+    }
+    nlohmann::json startup;
+    if (warm_start) {
+        startup = run_warm_start_test(deribit_client);
+    }
 
-}
\ No newline at end of file
+    if (!csv_path.empty()) {
+        std::ofstream csv(csv_path);
+        csv << order_manager.stats().to_csv();
+        std::string market_csv = market_manager.stats().to_csv();
+        csv << market_csv.substr(market_csv.find('\n') + 1);
+    }
+    if (!json_path.empty()) {
+        std::ofstream json_file(json_path);
+        nlohmann::json results = {
+            {"order_manager", order_manager.stats().to_json()},
+            {"market_manager", market_manager.stats().to_json()}
+        };
+        if (!concurrency.is_null()) results["concurrency"] = concurrency;
+        if (!requote.is_null()) results["requote"] = requote;
+        if (!startup.is_null()) results["warm_start"] = startup;
+        json_file << results.dump(4) << std::endl;
+    }
+}
@@ -1,12 +1,54 @@
 #include "config.h"
 #include "dotenv.h"
+#include "rate_limiter.hpp"
+#include "thread_affinity.hpp"
+#include <algorithm>
 #include <iostream>
+#include <sched.h>
 
 std::string CLIENT_ID;
 std::string CLIENT_SECRET;
 std::string BASE_URL;
 std::string WEB_SOCKET_URL;
+uint32_t TRACE_SAMPLE_RATE = 64;
+uint16_t METRICS_PORT = 9100;
+std::string JOURNAL_DIR;
+size_t JOURNAL_SEGMENT_MB = 64;
+size_t ORDER_WORKERS = 4;
+size_t ORDER_QUEUE_CAPACITY = 256;
+double RATE_LIMIT_MATCHING_BURST = 20;
+double RATE_LIMIT_MATCHING_PER_SEC = 5;
+double RATE_LIMIT_NON_MATCHING_BURST = 100;
+double RATE_LIMIT_NON_MATCHING_PER_SEC = 20;
+std::string RISK_LIMITS_FILE;
+std::string INSTRUMENT_CACHE_FILE = "instruments.cache";
+size_t FANOUT_WORKERS = 1;
+size_t FANOUT_QUEUE_CAPACITY = 4096;
+std::string MARKET_DATA_BUS;
+std::string MARKET_DATA_BUS_SYMBOLS = "BTC-PERPETUAL,ETH-PERPETUAL";
+uint32_t HEARTBEAT_INTERVAL = 100;
+uint32_t PROBE_INTERVAL_MS = 1000;
+uint64_t FEED_STALE_MS = 5000;
+uint64_t FEED_LAG_THRESHOLD_MS = 250;
+std::string REST_CACHE_TTL_MS = "public/get_order_book=100,public/get_instruments=60000,public/get_instrument=60000";
 
+static void check_rate_limit(const std::string& name, double burst, double per_second) {
+    if (RateLimiter::valid(RateLimiter::Limit{burst, per_second})) return;
+    std::cerr << "Invalid rate limit: RATE_LIMIT_" << name << "_PER_SEC must be 0 or more, and RATE_LIMIT_" << name
+              << "_BURST at least 1 unless the rate is 0" << std::endl;
+    exit(1);
+}
+
+static void set_cpus(ThreadAffinity::Role role, const std::string& name) {
+    std::string list = dotenv::get(name, "");
+    std::vector<int> cpus;
+    if (!ThreadAffinity::parse_cpu_list(list, cpus)) {
+        std::cerr << "Invalid CPU list: " << name << "=" << list << " (expected e.g. 2,3,8-11 with CPUs below "
+                  << CPU_SETSIZE << ")" << std::endl;
+        exit(1);
+    }
+    ThreadAffinity::instance().set_cpus(role, cpus);
+}
 
 void loadConfig() {
     if (!dotenv::load("../.env")) {
@@ -18,4 +60,34 @@ void loadConfig() {
     CLIENT_SECRET = dotenv::get("CLIENT_SECRET");
     BASE_URL = dotenv::get("BASE_URL");
     WEB_SOCKET_URL = dotenv::get("WEB_SOCKET_URL");
+    TRACE_SAMPLE_RATE = std::stoul(dotenv::get("TRACE_SAMPLE_RATE", "64"));
+    METRICS_PORT = static_cast<uint16_t>(std::stoul(dotenv::get("METRICS_PORT", "9100")));
+    JOURNAL_DIR = dotenv::get("JOURNAL_DIR", "");
+    JOURNAL_SEGMENT_MB = std::stoul(dotenv::get("JOURNAL_SEGMENT_MB", "64"));
+    ORDER_WORKERS = std::stoul(dotenv::get("ORDER_WORKERS", "4"));
+    ORDER_QUEUE_CAPACITY = std::stoul(dotenv::get("ORDER_QUEUE_CAPACITY", "256"));
+    RATE_LIMIT_MATCHING_BURST = std::stod(dotenv::get("RATE_LIMIT_MATCHING_BURST", "20"));
+    RATE_LIMIT_MATCHING_PER_SEC = std::stod(dotenv::get("RATE_LIMIT_MATCHING_PER_SEC", "5"));
+    RATE_LIMIT_NON_MATCHING_BURST = std::stod(dotenv::get("RATE_LIMIT_NON_MATCHING_BURST", "100"));
+    RATE_LIMIT_NON_MATCHING_PER_SEC = std::stod(dotenv::get("RATE_LIMIT_NON_MATCHING_PER_SEC", "20"));
+    check_rate_limit("MATCHING", RATE_LIMIT_MATCHING_BURST, RATE_LIMIT_MATCHING_PER_SEC);
+    check_rate_limit("NON_MATCHING", RATE_LIMIT_NON_MATCHING_BURST, RATE_LIMIT_NON_MATCHING_PER_SEC);
+    RISK_LIMITS_FILE = dotenv::get("RISK_LIMITS_FILE", "");
+    INSTRUMENT_CACHE_FILE = dotenv::get("INSTRUMENT_CACHE_FILE", "instruments.cache");
+    FANOUT_WORKERS = std::stoul(dotenv::get("FANOUT_WORKERS", "1"));
+    FANOUT_QUEUE_CAPACITY = std::stoul(dotenv::get("FANOUT_QUEUE_CAPACITY", "4096"));
+    MARKET_DATA_BUS = dotenv::get("MARKET_DATA_BUS", "");
+    MARKET_DATA_BUS_SYMBOLS = dotenv::get("MARKET_DATA_BUS_SYMBOLS", "BTC-PERPETUAL,ETH-PERPETUAL");
+    // Deribit accepts heartbeat intervals of 10 s and up
+    HEARTBEAT_INTERVAL = std::max<uint32_t>(10, std::stoul(dotenv::get("HEARTBEAT_INTERVAL", "100")));
+    PROBE_INTERVAL_MS = std::stoul(dotenv::get("PROBE_INTERVAL_MS", "1000"));
+    FEED_STALE_MS = std::stoull(dotenv::get("FEED_STALE_MS", "5000"));
+    FEED_LAG_THRESHOLD_MS = std::stoull(dotenv::get("FEED_LAG_THRESHOLD_MS", "250"));
+    REST_CACHE_TTL_MS = dotenv::get("REST_CACHE_TTL_MS", "public/get_order_book=100,public/get_instruments=60000,public/get_instrument=60000");
+
+    set_cpus(ThreadAffinity::FEED, "FEED_CPUS");
+    set_cpus(ThreadAffinity::FANOUT, "FANOUT_CPUS");
+    set_cpus(ThreadAffinity::ORDER, "ORDER_CPUS");
+    set_cpus(ThreadAffinity::SERVER, "SERVER_CPUS");
+    ThreadAffinity::instance().set_busy_poll(dotenv::get("BUSY_POLL", "0") == "1");
 }
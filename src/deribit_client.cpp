@@ -1,5 +1,25 @@
 #include "deribit_client.hpp"
 #include "config.h"
+#include "feed_monitor.hpp"
+#include "thread_affinity.hpp"
+#include "latency_trace.hpp"
+#include "metrics.hpp"
+#include "rate_limiter.hpp"
+#include "request_cache.hpp"
+#include "tick_journal.hpp"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+MetricsRegistry& metrics = MetricsRegistry::instance();
+Counter& upstream_messages = metrics.counter("deribit_upstream_messages_total", "WebSocket frames received from Deribit");
+Counter& upstream_bytes = metrics.counter("deribit_upstream_bytes_total", "WebSocket payload bytes received from Deribit");
+Counter& parse_failures = metrics.counter("deribit_upstream_parse_failures_total", "Upstream frames that failed to parse");
+Counter& token_refreshes = metrics.counter("deribit_token_refreshes_total", "Access token refreshes", MetricsRegistry::label("result", "ok"));
+Counter& token_refresh_failures = metrics.counter("deribit_token_refreshes_total", "Access token refreshes", MetricsRegistry::label("result", "error"));
+}
 
 DeribitClient::DeribitClient() : m_ws_enabled(true) {
     this->client_id = CLIENT_ID;
@@ -7,25 +27,43 @@ DeribitClient::DeribitClient() : m_ws_enabled(true) {
     this->base_url = BASE_URL;
     this->m_ws_uri = WEB_SOCKET_URL;
     this->logger = Logger();
-    if (m_ws_enabled) {
-        init_websocket();
+    this->m_rate_limiter = std::make_unique<RateLimiter>(
+        RateLimiter::Limit{RATE_LIMIT_MATCHING_BURST, RATE_LIMIT_MATCHING_PER_SEC},
+        RateLimiter::Limit{RATE_LIMIT_NON_MATCHING_BURST, RATE_LIMIT_NON_MATCHING_PER_SEC});
+    FeedMonitor::Options monitor;
+    monitor.stale_after_ms = FEED_STALE_MS;
+    monitor.lag_threshold_ms = FEED_LAG_THRESHOLD_MS;
+    this->m_feed_monitor = std::make_unique<FeedMonitor>(monitor);
+    this->m_public_cache = std::make_unique<RequestCache<cpr::Response>>([](const cpr::Response& r) {
+        return r.status_code == 200 && r.text.find("\"error\":") == std::string::npos;
+    });
+    // "method=ttl_ms,..."; a malformed entry is reported and skipped, which
+    // leaves that method uncached
+    std::stringstream ttls(REST_CACHE_TTL_MS);
+    std::string entry;
+    while (std::getline(ttls, entry, ',')) {
+        if (entry.empty()) continue;
+        size_t eq = entry.find('=');
+        std::string ttl = eq == std::string::npos ? "" : entry.substr(eq + 1);
+        char* end = nullptr;
+        errno = 0;
+        unsigned long long ms = ttl.empty() || !std::isdigit(static_cast<unsigned char>(ttl[0])) ? 0 : std::strtoull(ttl.c_str(), &end, 10);
+        if (eq == 0 || !end || *end != '\0' || errno == ERANGE) {
+            logger.log(Logger::LogLevel::WARNING, "Ignoring REST_CACHE_TTL_MS entry \"" + entry + "\": expected method=milliseconds");
+            continue;
+        }
+        m_cache_ttl[entry.substr(0, eq)] = std::chrono::milliseconds(ms);
     }
-}
-
-DeribitClient::DeribitClient(DeribitClient& other) {
-    this->client_id = other.client_id;
-    this->client_secret = other.client_secret;
-    this->access_token = other.access_token;
-    this->refresh_token = other.refresh_token;
-    this->base_url = other.base_url;
-    this->m_ws_uri = other.m_ws_uri;
-    this->m_ws_enabled = other.m_ws_enabled;
     if (m_ws_enabled) {
         init_websocket();
     }
 }
 
 DeribitClient::~DeribitClient() {
+    stop_websocket();
+}
+
+void DeribitClient::stop_websocket() {
     if (m_ws_enabled && m_client_thread.joinable()) {
         m_client.stop();
         m_client_thread.join();
@@ -45,8 +83,12 @@ void DeribitClient::init_websocket() {
     });
 
     m_client.set_open_handler([this](websocketpp::connection_hdl hdl) {
-        m_ws_hdl = hdl;
+        {
+            std::lock_guard<std::mutex> lock(m_ws_mutex);
+            m_ws_hdl = hdl;
+        }
         logger.log(Logger::LogLevel::INFO, "WebSocket connection established");
+        send_public_subscriptions();
         websocket_authenticate();
     });
 
@@ -56,28 +98,41 @@ void DeribitClient::init_websocket() {
     });
 
     m_client.set_close_handler([this](websocketpp::connection_hdl) {
+        {
+            std::lock_guard<std::mutex> lock(m_subscriptions_mutex);
+            m_ws_open = false;
+            m_ws_authenticated = false;
+        }
         logger.log(Logger::LogLevel::INFO, "WebSocket connection closed");
     });
 }
 
 void DeribitClient::connect_websocket() {
+    if (m_ws_started.exchange(true)) return;
     websocketpp::lib::error_code ec;
     auto conn = m_client.get_connection(m_ws_uri, ec);
     if (ec) {
         logger.log(Logger::LogLevel::ERROR, "Error connecting to WebSocket: " + ec.message());
+        m_ws_started = false;
         return;
     }
 
     m_client.connect(conn);
     m_client_thread = std::thread([this]() {
         try {
-            m_client.run();
+            ThreadAffinity::instance().pin_current_thread(ThreadAffinity::FEED);
+            ThreadAffinity::instance().run(m_client);
         } catch (const std::exception& e) {
             logger.log(Logger::LogLevel::ERROR, "Error running WebSocket client: " + std::string(e.what()));
         }
     });
 }
 
+bool DeribitClient::is_websocket_connected() const {
+    std::lock_guard<std::mutex> lock(m_ws_mutex);
+    return m_ws_hdl.lock() != nullptr;
+}
+
 void DeribitClient::subscribe_to_channel(const std::string& channel) {
     if (!m_ws_enabled) return;
     
@@ -92,10 +147,89 @@ void DeribitClient::subscribe_to_channel(const std::string& channel) {
     send_websocket_message(subscribe_msg);
 }
 
+void DeribitClient::subscribe_public(const std::string& channel) {
+    bool send_now;
+    {
+        std::lock_guard<std::mutex> lock(m_subscriptions_mutex);
+        if (!m_public_channels.insert(channel).second) return;
+        send_now = m_ws_open;
+    }
+    if (send_now) subscribe_to_channel(channel);
+}
+
+void DeribitClient::subscribe_private(const std::string& channel) {
+    bool send_now;
+    {
+        std::lock_guard<std::mutex> lock(m_subscriptions_mutex);
+        if (!m_private_channels.insert(channel).second) return;
+        send_now = m_ws_authenticated;
+    }
+    if (send_now) {
+        nlohmann::json subscribe_msg = {
+            {"jsonrpc", "2.0"},
+            {"id", 43},
+            {"method", "private/subscribe"},
+            {"params", {
+                {"channels", {channel}}
+            }}
+        };
+        send_websocket_message(subscribe_msg);
+    }
+}
+
+void DeribitClient::send_public_subscriptions() {
+    nlohmann::json channels = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(m_subscriptions_mutex);
+        m_ws_open = true;
+        for (const auto& channel : m_public_channels) channels.push_back(channel);
+    }
+    if (channels.empty()) return;
+
+    nlohmann::json subscribe_msg = {
+        {"jsonrpc", "2.0"},
+        {"id", 42},
+        {"method", "public/subscribe"},
+        {"params", {
+            {"channels", channels}
+        }}
+    };
+    send_websocket_message(subscribe_msg);
+}
+
+void DeribitClient::send_private_subscriptions() {
+    nlohmann::json channels = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(m_subscriptions_mutex);
+        m_ws_authenticated = true;
+        for (const auto& channel : m_private_channels) channels.push_back(channel);
+    }
+    if (channels.empty()) return;
+
+    nlohmann::json subscribe_msg = {
+        {"jsonrpc", "2.0"},
+        {"id", 43},
+        {"method", "private/subscribe"},
+        {"params", {
+            {"channels", channels}
+        }}
+    };
+    send_websocket_message(subscribe_msg);
+}
+
+void DeribitClient::add_channel_listener(const std::string& prefix, ChannelListener listener) {
+    m_channel_listeners.emplace_back(prefix, std::move(listener));
+}
+
 void DeribitClient::send_websocket_message(const nlohmann::json& msg) {
     if (!m_ws_enabled) return;
 
-    if (auto hdl = m_ws_hdl.lock()) {
+    websocketpp::connection_hdl weak;
+    {
+        std::lock_guard<std::mutex> lock(m_ws_mutex);
+        weak = m_ws_hdl;
+    }
+    if (auto hdl = weak.lock()) {
         try {
             m_client.send(hdl, msg.dump(), websocketpp::frame::opcode::text);
         } catch (const std::exception& e) {
@@ -118,45 +252,136 @@ void DeribitClient::websocket_authenticate() {
     send_websocket_message(auth_msg);
 }
 
+// public/test with an id the monitor recognises in the reply
+void DeribitClient::send_probe() {
+    nlohmann::json probe = {
+        {"jsonrpc", "2.0"},
+        {"id", m_feed_monitor->begin_probe()},
+        {"method", "public/test"}
+    };
+    send_websocket_message(probe);
+}
+
+// Runs on the io thread for the life of the client, across reconnects.
+void DeribitClient::schedule_probe() {
+    m_client.set_timer(PROBE_INTERVAL_MS, [this](const websocketpp::lib::error_code& ec) {
+        if (ec) return;
+        m_feed_monitor->check();
+        if (is_websocket_connected()) send_probe();
+        schedule_probe();
+    });
+}
+
 void DeribitClient::on_websocket_message(ws_client::message_ptr msg) {
+    LatencyTrace& trace = LatencyTrace::instance();
+    trace.begin_frame();
+    uint64_t received = m_journal ? TickJournal::now_ns() : 0;
+    upstream_messages.inc();
+    upstream_bytes.inc(msg->get_payload().size());
+    m_feed_monitor->on_frame(msg->get_payload());
+    process_message(msg->get_payload());
+    trace.end_frame();
+    // The payload is not needed after routing, so it is moved rather than copied.
+    if (m_journal) m_journal->append(received, std::move(msg->get_raw_payload()));
+}
+
+// Channel of a subscription notification, found without parsing the frame.
+static std::string_view subscription_channel(const std::string& payload) {
+    static const char kMethod[] = "\"method\":\"subscription\"";
+    static const char kChannel[] = "\"channel\":\"";
+    if (payload.find(kMethod) == std::string::npos) return {};
+    size_t start = payload.find(kChannel);
+    if (start == std::string::npos) return {};
+    start += sizeof(kChannel) - 1;
+    size_t end = payload.find('"', start);
+    if (end == std::string::npos) return {};
+    return std::string_view(payload).substr(start, end - start);
+}
+
+bool DeribitClient::has_listener(std::string_view channel) const {
+    for (const auto& listener : m_channel_listeners) {
+        if (channel.compare(0, listener.first.size(), listener.first) == 0) return true;
+    }
+    return false;
+}
+
+void DeribitClient::process_message(const std::string& payload) {
+    // Market data nobody here listens to is only forwarded, so it skips the
+    // JSON DOM. The channel goes through a per-thread buffer that keeps its
+    // capacity, which keeps this path free of heap allocations. Sampled
+    // frames take the full path so their stages are traced.
+    std::string_view fast_channel = subscription_channel(payload);
+    if (!fast_channel.empty() && !LatencyTrace::instance().active() && !has_listener(fast_channel)) {
+        static thread_local std::string channel;
+        channel.assign(fast_channel.data(), fast_channel.size());
+        broadcast(channel, payload);
+        return;
+    }
+
     try {
-        std::string payload = msg->get_payload();
         nlohmann::json response = nlohmann::json::parse(payload);
+        LatencyTrace& trace = LatencyTrace::instance();
+        trace.mark(LatencyTrace::PARSE);
         
+        // The reply to a test_request doubles as a probe
         if (response.contains("method") && response["method"] == "heartbeat") {
-            nlohmann::json heartbeat_response = {
-                {"jsonrpc", "2.0"},
-                {"method", "public/test"}
-            };
-            send_websocket_message(heartbeat_response);
+            send_probe();
         }
 
         if (response.contains("id")) {
-            int id = response["id"].get<int>();
+            int64_t id = response["id"].get<int64_t>();
+            if (id >= FeedMonitor::kProbeIdBase) {
+                if (response.contains("usIn") && response.contains("usOut")) {
+                    m_feed_monitor->on_probe_reply(id, response["usIn"].get<uint64_t>(), response["usOut"].get<uint64_t>());
+                }
+                return;
+            }
             if (id == 9929 && response.contains("result")) {
                 logger.log(Logger::LogLevel::SUCCESS, "WebSocket authentication successful");
                 nlohmann::json heartbeat_msg = {
                     {"jsonrpc", "2.0"},
                     {"id", 9098},
                     {"method", "public/set_heartbeat"},
-                    {"params", {{"interval", 100}}}
+                    {"params", {{"interval", HEARTBEAT_INTERVAL}}}
                 };
                 send_websocket_message(heartbeat_msg);
+                send_private_subscriptions();
+                send_probe();
+                if (PROBE_INTERVAL_MS > 0 && !m_probing.exchange(true)) schedule_probe();
             }
         }
 
         if (response.contains("params") && response["params"].contains("channel")) {
             std::string channel = response["params"]["channel"];
-            if (m_broadcast_callback) {
-                m_broadcast_callback(channel, payload);
+            if (trace.active() && response["params"].contains("data") && response["params"]["data"].is_object()) {
+                const auto& data = response["params"]["data"];
+                if (data.contains("timestamp")) trace.record_exchange_timestamp(data["timestamp"].get<uint64_t>());
+            }
+            for (const auto& listener : m_channel_listeners) {
+                if (channel.compare(0, listener.first.size(), listener.first) != 0) continue;
+                try {
+                    listener.second(channel, response["params"]["data"]);
+                } catch (const std::exception& e) {
+                    logger.log(Logger::LogLevel::ERROR, "Channel listener failed for " + channel + ": " + e.what());
+                }
             }
+            broadcast(channel, payload);
         }
     } catch (const nlohmann::json::exception& e) {
+        parse_failures.inc();
         logger.log(Logger::LogLevel::ERROR, "Failed to parse WebSocket message: " + std::string(e.what()));
     }
 }
 
+// The lock is only contended while the callback is being replaced, so a
+// server can detach from the shared session before it is destroyed.
+void DeribitClient::broadcast(const std::string& channel, const std::string& payload) {
+    std::lock_guard<std::mutex> lock(m_broadcast_mutex);
+    if (m_broadcast_callback) m_broadcast_callback(channel, payload);
+}
+
 void DeribitClient::set_broadcast_callback(std::function<void(const std::string&, const std::string&)> callback) {
+    std::lock_guard<std::mutex> lock(m_broadcast_mutex);
     m_broadcast_callback = callback;
 }
 
@@ -174,6 +399,7 @@ cpr::Response DeribitClient::authenticate() {
     cpr::Response r = post(payload);
     if (r.status_code == 200) {
         nlohmann::json response = nlohmann::json::parse(r.text);
+        std::lock_guard<std::mutex> lock(m_token_mutex);
         this->access_token = response["result"]["access_token"];
         this->refresh_token = response["result"]["refresh_token"];
         int expires_in = response["result"]["expires_in"];
@@ -186,6 +412,11 @@ cpr::Response DeribitClient::authenticate() {
 }
 
 cpr::Response DeribitClient::refresh() {
+    std::lock_guard<std::mutex> lock(m_token_mutex);
+    return refresh_locked();
+}
+
+cpr::Response DeribitClient::refresh_locked() {
     nlohmann::json payload = {
             {"jsonrpc", "2.0"},
             {"method", "public/auth"},
@@ -202,9 +433,11 @@ cpr::Response DeribitClient::refresh() {
         this->refresh_token = response["result"]["refresh_token"];
         int expires_in = response["result"]["expires_in"];
         token_expiry_time = std::chrono::steady_clock::now() + std::chrono::seconds(expires_in);
+        token_refreshes.inc();
         logger.log(Logger::LogLevel::SUCCESS, "Token refresh successful");
         return r;
     }
+    token_refresh_failures.inc();
     logger.log(Logger::LogLevel::ERROR, "Token refresh failed");
     throw std::runtime_error("Token refresh failed.");
 }
@@ -219,38 +452,42 @@ cpr::Response DeribitClient::get_all_instruments(const std::string& currency, co
             }},
             {"id", 1}
     };
-    return post(payload);
+    return post_public(payload);
 }
 
-cpr::Response DeribitClient::place_buy_order(const std::string& instrument_name, const std::string& side, const std::string& type, const std::string& amount, const std::string& price) {
+cpr::Response DeribitClient::get_instrument(const std::string& instrument_name) {
     nlohmann::json payload = {
             {"jsonrpc", "2.0"},
-            {"method", "private/buy"},
+            {"method", "public/get_instrument"},
             {"params", {
-                {"instrument_name", instrument_name},
-                {"amount", amount},
-                {"type", type},
-                {"price", price},
-                {"label", "label"}
+                {"instrument_name", instrument_name}
             }},
             {"id", 1}
     };
-    return post(payload, true);
+    return post_public(payload);
 }
-cpr::Response DeribitClient::place_sell_order(const std::string& instrument_name, const std::string& side, const std::string& type, const std::string& amount, const std::string& price) {
-    nlohmann::json payload = {
+
+nlohmann::json DeribitClient::build_order_payload(const std::string& method, const std::string& instrument_name, const std::string& type, const std::string& amount, const std::string& price, const std::string& label) {
+    return {
             {"jsonrpc", "2.0"},
-            {"method", "private/sell"},
+            {"method", method},
             {"params", {
                 {"instrument_name", instrument_name},
                 {"amount", amount},
                 {"type", type},
                 {"price", price},
-                {"label", "label"}
+                {"label", label}
             }},
             {"id", 1}
     };
-    return post(payload, true);
+}
+
+cpr::Response DeribitClient::place_buy_order(const std::string& instrument_name, const std::string& side, const std::string& type, const std::string& amount, const std::string& price, const std::string& label) {
+    return post(build_order_payload("private/buy", instrument_name, type, amount, price, label), true);
+}
+
+cpr::Response DeribitClient::place_sell_order(const std::string& instrument_name, const std::string& side, const std::string& type, const std::string& amount, const std::string& price, const std::string& label) {
+    return post(build_order_payload("private/sell", instrument_name, type, amount, price, label), true);
 }
 
 cpr::Response DeribitClient::get_positions(const std::string& currency, const std::string& kind) {
@@ -266,6 +503,18 @@ cpr::Response DeribitClient::get_positions(const std::string& currency, const st
     return post(payload, true);
 }
 
+cpr::Response DeribitClient::get_open_orders(const std::string& currency) {
+    nlohmann::json payload = {
+            {"jsonrpc", "2.0"},
+            {"method", "private/get_open_orders_by_currency"},
+            {"params", {
+                {"currency", currency}
+            }},
+            {"id", 1}
+    };
+    return post(payload, true);
+}
+
 cpr::Response DeribitClient::get_order_book(const std::string& instrument_name) {
     nlohmann::json payload = {
             {"jsonrpc", "2.0"},
@@ -276,7 +525,7 @@ cpr::Response DeribitClient::get_order_book(const std::string& instrument_name)
             }},
             {"id", 1}
     };
-    return post(payload);
+    return post_public(payload);
 }
 
 
@@ -292,6 +541,40 @@ cpr::Response DeribitClient::cancel_order(const std::string& order_id) {
     return post(payload, true);
 }
 
+cpr::Response DeribitClient::cancel_all() {
+    nlohmann::json payload = {
+            {"jsonrpc", "2.0"},
+            {"method", "private/cancel_all"},
+            {"params", nlohmann::json::object()},
+            {"id", 1}
+    };
+    return post(payload, true);
+}
+
+cpr::Response DeribitClient::cancel_all_by_instrument(const std::string& instrument_name) {
+    nlohmann::json payload = {
+            {"jsonrpc", "2.0"},
+            {"method", "private/cancel_all_by_instrument"},
+            {"params", {
+                {"instrument_name", instrument_name}
+            }},
+            {"id", 1}
+    };
+    return post(payload, true);
+}
+
+cpr::Response DeribitClient::cancel_by_label(const std::string& label) {
+    nlohmann::json payload = {
+            {"jsonrpc", "2.0"},
+            {"method", "private/cancel_by_label"},
+            {"params", {
+                {"label", label}
+            }},
+            {"id", 1}
+    };
+    return post(payload, true);
+}
+
 cpr::Response DeribitClient::edit_order(const std::string& order_id, const std::string& quantity, const std::string& price) {
     nlohmann::json payload = {
             {"jsonrpc", "2.0"},
@@ -307,26 +590,80 @@ cpr::Response DeribitClient::edit_order(const std::string& order_id, const std::
 }
 
 cpr::Response DeribitClient::post(const nlohmann::json& payload, bool with_auth) {
+    std::string token;
     if (with_auth) {
+        // Concurrent callers wait for the one refresh instead of each sending their own.
+        std::lock_guard<std::mutex> lock(m_token_mutex);
         if (std::chrono::steady_clock::now() >= token_expiry_time) {
-            refresh();
+            refresh_locked();
         }
-        return cpr::Post(cpr::Url{BASE_URL},
-                        cpr::Body{payload.dump()},
-                        cpr::Header{{"Authorization", "Bearer " + this->access_token}}
-        );
-    } else {
-        return cpr::Post(cpr::Url{BASE_URL},
-                        cpr::Body{payload.dump()}
-        );
+        token = this->access_token;
     }
+
+    // Series lookup takes the registry lock; negligible next to the HTTP round trip.
+    std::string method = payload.value("method", "unknown");
+    std::string labels = MetricsRegistry::label("method", method);
+    RateLimiter::Pool pool = RateLimiter::pool_of(method);
+    m_rate_limiter->acquire(pool, RateLimiter::lane_of(method));
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<cpr::Session> session = acquire_session();
+    session->SetBody(cpr::Body{payload.dump()});
+    session->SetHeader(with_auth ? cpr::Header{{"Authorization", "Bearer " + token}} : cpr::Header{});
+    cpr::Response r = session->Post();
+    release_session(std::move(session));
+    metrics.histogram("deribit_rest_request_seconds", "REST round trip by JSON-RPC method", labels)
+        .record(std::chrono::steady_clock::now() - start);
+    if (r.status_code != 200) {
+        metrics.counter("deribit_rest_errors_total", "REST responses with a non-200 status", labels).inc();
+    }
+    if (r.text.find("\"code\":10028") != std::string::npos) {
+        m_rate_limiter->on_rejected(pool);
+    }
+    return r;
+}
+
+// Identical concurrent calls share one round trip, and successful answers
+// are reused for the method's TTL without spending rate-limit credit.
+cpr::Response DeribitClient::post_public(const nlohmann::json& payload) {
+    std::string method = payload.value("method", "unknown");
+    auto ttl = m_cache_ttl.find(method);
+    return m_public_cache->get(method, payload.dump(), ttl == m_cache_ttl.end() ? std::chrono::milliseconds(0) : ttl->second,
+                               [&]() { return post(payload); });
 }
 
 cpr::Response DeribitClient::get(const nlohmann::json& payload) {
-    return cpr::Get(cpr::Url{BASE_URL},
-                    cpr::Body{payload.dump()},
-                    cpr::Header{{"Authorization", "Bearer " + this->access_token}}
-    );
+    std::string token;
+    {
+        std::lock_guard<std::mutex> lock(m_token_mutex);
+        token = this->access_token;
+    }
+    std::unique_ptr<cpr::Session> session = acquire_session();
+    session->SetBody(cpr::Body{payload.dump()});
+    session->SetHeader(cpr::Header{{"Authorization", "Bearer " + token}});
+    cpr::Response r = session->Get();
+    release_session(std::move(session));
+    return r;
+}
+
+// A new session only when every pooled one is in use; concurrent calls are
+// bounded by the worker pools, so the pool stays small.
+std::unique_ptr<cpr::Session> DeribitClient::acquire_session() {
+    {
+        std::lock_guard<std::mutex> lock(m_http_mutex);
+        if (!m_http_sessions.empty()) {
+            std::unique_ptr<cpr::Session> session = std::move(m_http_sessions.back());
+            m_http_sessions.pop_back();
+            return session;
+        }
+    }
+    std::unique_ptr<cpr::Session> session(new cpr::Session());
+    session->SetUrl(cpr::Url{BASE_URL});
+    return session;
+}
+
+void DeribitClient::release_session(std::unique_ptr<cpr::Session> session) {
+    std::lock_guard<std::mutex> lock(m_http_mutex);
+    m_http_sessions.push_back(std::move(session));
 }
 
 std::ostream& operator<<(std::ostream& os, const DeribitClient& client) {
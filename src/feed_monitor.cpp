@@ -0,0 +1,142 @@
+#include "feed_monitor.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+MetricsRegistry& metrics = MetricsRegistry::instance();
+LatencyHistogram& upstream_rtt = metrics.histogram("deribit_upstream_rtt_seconds", "Round trip of public/test probes, less the exchange's own processing time");
+LatencyHistogram& exchange_lag = metrics.histogram("deribit_feed_exchange_lag_seconds", "Exchange timestamp to socket read, corrected for clock offset");
+Gauge& clock_offset = metrics.gauge("deribit_clock_offset_microseconds", "Exchange clock minus local clock");
+Gauge& clock_offset_error = metrics.gauge("deribit_clock_offset_error_microseconds", "Bound on the clock offset error (half the best recent round trip)");
+Gauge& feed_stale = metrics.gauge("deribit_feed_stale", "1 while no upstream frame has arrived within FEED_STALE_MS");
+Gauge& feed_lagging = metrics.gauge("deribit_feed_lagging", "1 while the exchange-side lag exceeds FEED_LAG_THRESHOLD_MS");
+
+uint64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Value of the first "timestamp" field, or 0
+uint64_t scan_timestamp(const std::string& payload) {
+    static const char kTimestamp[] = "\"timestamp\":";
+    size_t pos = payload.find(kTimestamp);
+    if (pos == std::string::npos) return 0;
+    uint64_t value = 0;
+    for (pos += sizeof(kTimestamp) - 1; pos < payload.size() && payload[pos] >= '0' && payload[pos] <= '9'; ++pos) {
+        value = value * 10 + static_cast<uint64_t>(payload[pos] - '0');
+    }
+    return value;
+}
+}
+
+FeedMonitor::FeedMonitor() : FeedMonitor(Options()) {}
+
+FeedMonitor::FeedMonitor(const Options& options) : m_options(options) {
+    m_window.reserve(std::max<size_t>(m_options.window, 1));
+    m_last_frame_ns = monotonic_ns();
+}
+
+uint64_t FeedMonitor::wall_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t FeedMonitor::begin_probe() {
+    int64_t id = m_next_id++;
+    Probe& probe = m_probes[id % kOutstanding];
+    probe.id = id;
+    probe.sent_ns = monotonic_ns();
+    probe.sent_us = wall_us();
+    return id;
+}
+
+bool FeedMonitor::on_probe_reply(int64_t id, uint64_t us_in, uint64_t us_out) {
+    Probe& probe = m_probes[id % kOutstanding];
+    if (id < kProbeIdBase || probe.id != id) return false;
+    probe.id = -1;
+
+    int64_t elapsed_us = static_cast<int64_t>((monotonic_ns() - probe.sent_ns) / 1000);
+    int64_t server_us = us_out >= us_in ? static_cast<int64_t>(us_out - us_in) : 0;
+    int64_t rtt_us = std::max<int64_t>(elapsed_us - server_us, 0);
+    // Exchange clock minus ours, assuming the two legs take equally long
+    int64_t sent_us = static_cast<int64_t>(probe.sent_us);
+    int64_t offset_us = ((static_cast<int64_t>(us_in) - sent_us) +
+                         (static_cast<int64_t>(us_out) - (sent_us + elapsed_us))) / 2;
+
+    upstream_rtt.record(std::chrono::microseconds(rtt_us));
+    m_rtt_us.store(rtt_us, std::memory_order_relaxed);
+
+    Sample sample{rtt_us, offset_us};
+    if (m_window.size() < std::max<size_t>(m_options.window, 1)) {
+        m_window.push_back(sample);
+    } else {
+        m_window[m_window_next] = sample;
+        m_window_next = (m_window_next + 1) % m_window.size();
+    }
+    const Sample& best = *std::min_element(m_window.begin(), m_window.end(),
+        [](const Sample& a, const Sample& b) { return a.rtt_us < b.rtt_us; });
+    m_offset_us.store(best.offset_us, std::memory_order_relaxed);
+    m_offset_error_us.store(best.rtt_us / 2, std::memory_order_relaxed);
+    clock_offset.set(best.offset_us);
+    clock_offset_error.set(best.rtt_us / 2);
+    if (!m_synced) {
+        m_synced = true;
+        logger.log(Logger::LogLevel::INFO, "Exchange clock offset " + std::to_string(best.offset_us) +
+            " us (+/- " + std::to_string(best.rtt_us / 2) + " us)");
+    }
+    return true;
+}
+
+void FeedMonitor::on_frame(const std::string& payload) {
+    m_last_frame_ns.store(monotonic_ns(), std::memory_order_relaxed);
+    if (++m_frames % kLagSampleEvery != 0) return;
+    uint64_t exchange_ms = scan_timestamp(payload);
+    if (exchange_ms) on_exchange_timestamp(exchange_ms, wall_us());
+}
+
+void FeedMonitor::on_exchange_timestamp(uint64_t exchange_ms, uint64_t received_us) {
+    // Without an offset the lag would include the clock difference
+    if (!m_synced) return;
+    int64_t lag_us = static_cast<int64_t>(received_us) + m_offset_us.load(std::memory_order_relaxed) -
+                     static_cast<int64_t>(exchange_ms * 1000);
+    lag_us = std::max<int64_t>(lag_us, 0);
+    exchange_lag.record(std::chrono::microseconds(lag_us));
+    m_lag_ewma_us += (lag_us - m_lag_ewma_us) / 8;
+    m_lag_us.store(m_lag_ewma_us, std::memory_order_relaxed);
+}
+
+void FeedMonitor::check() {
+    uint64_t idle_ns = monotonic_ns() - m_last_frame_ns.load(std::memory_order_relaxed);
+    bool stale = idle_ns > m_options.stale_after_ms * 1000000;
+    if (stale != m_stale.exchange(stale, std::memory_order_relaxed)) {
+        feed_stale.set(stale);
+        if (stale) {
+            logger.log(Logger::LogLevel::WARNING, "Upstream feed stale: no frame for " + std::to_string(idle_ns / 1000000) + " ms");
+        } else {
+            logger.log(Logger::LogLevel::INFO, "Upstream feed resumed");
+        }
+    }
+
+    int64_t lag_us = m_lag_us.load(std::memory_order_relaxed);
+    bool lagging = lag_us > static_cast<int64_t>(m_options.lag_threshold_ms * 1000);
+    if (lagging != m_lagging.exchange(lagging, std::memory_order_relaxed)) {
+        feed_lagging.set(lagging);
+        if (lagging) {
+            logger.log(Logger::LogLevel::WARNING, "Upstream feed lagging: exchange-side lag " + std::to_string(lag_us / 1000) + " ms");
+        } else {
+            logger.log(Logger::LogLevel::INFO, "Upstream feed caught up");
+        }
+    }
+}
+
+nlohmann::json FeedMonitor::to_json() const {
+    return {
+        {"rtt_us", rtt_us()},
+        {"clock_offset_us", offset_us()},
+        {"clock_offset_error_us", offset_error_us()},
+        {"exchange_lag_us", lag_us()},
+        {"stale", stale()},
+        {"lagging", lagging()}
+    };
+}
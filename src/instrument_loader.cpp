@@ -0,0 +1,147 @@
+#include "instrument_loader.hpp"
+#include "instrument_registry.hpp"
+#include "rpc_decoder.hpp"
+#include "thread_pool.hpp"
+#include <chrono>
+#include <future>
+
+namespace {
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
+InstrumentLoader::Lists InstrumentLoader::default_lists() {
+    Lists lists;
+    for (const char* currency : {"BTC", "ETH", "USDC", "EURR"}) {
+        for (const char* kind : {"future", "option", "spot"}) {
+            lists.emplace_back(currency, kind);
+        }
+    }
+    return lists;
+}
+
+InstrumentLoader::InstrumentLoader(DeribitClient& client, const std::string& cache_path)
+    : m_client(client), m_cache_path(cache_path) {
+    logger = Logger();
+}
+
+InstrumentLoader::~InstrumentLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_pending_mutex);
+        m_stopping = true;
+    }
+    m_pending_ready.notify_one();
+    if (m_fetcher.joinable()) m_fetcher.join();
+    if (m_refresh.joinable()) m_refresh.join();
+}
+
+InstrumentLoader::Report InstrumentLoader::start(const Lists& lists) {
+    auto started = std::chrono::steady_clock::now();
+    InstrumentRegistry& registry = InstrumentRegistry::instance();
+
+    if (!m_cache_path.empty()) {
+        try {
+            m_report.from_cache = registry.restore(m_cache_path);
+        } catch (const std::exception& e) {
+            logger.log(Logger::LogLevel::WARNING, "Ignoring instrument cache: " + std::string(e.what()));
+        }
+    }
+    if (m_report.from_cache) {
+        m_report.ready_ms = elapsed_ms(started);
+        m_report.instruments = registry.size();
+        logger.log(Logger::LogLevel::SUCCESS, "Instruments restored from " + m_cache_path + " in " +
+                   std::to_string(m_report.ready_ms) + "ms, refreshing in the background");
+        // Copied before the refresh thread starts writing m_report
+        Report ready = m_report;
+        m_refresh = std::thread([this, lists, started]() {
+            m_report.failed = fetch_all(lists);
+            m_report.refreshed_ms = elapsed_ms(started);
+            m_report.instruments = InstrumentRegistry::instance().size();
+            persist();
+        });
+        return ready;
+    }
+
+    m_report.failed = fetch_all(lists);
+    m_report.ready_ms = m_report.refreshed_ms = elapsed_ms(started);
+    m_report.instruments = registry.size();
+    logger.log(Logger::LogLevel::SUCCESS, "Fetched " + std::to_string(lists.size()) + " instrument lists in " +
+               std::to_string(m_report.ready_ms) + "ms");
+    persist();
+    return m_report;
+}
+
+InstrumentLoader::Report InstrumentLoader::wait() {
+    if (m_refresh.joinable()) m_refresh.join();
+    return m_report;
+}
+
+void InstrumentLoader::fetch_later(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(m_pending_mutex);
+        if (m_stopping || !m_pending.insert(name).second) return;
+        if (!m_fetcher.joinable()) {
+            m_fetcher = std::thread([this]() {
+                fetch_pending();
+            });
+        }
+    }
+    m_pending_ready.notify_one();
+}
+
+void InstrumentLoader::fetch_pending() {
+    std::unordered_set<std::string> batch;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_pending_mutex);
+            m_pending_ready.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+            if (m_stopping) return;
+            batch.swap(m_pending);
+        }
+        for (const auto& name : batch) {
+            try {
+                nlohmann::json j = nlohmann::json::parse(m_client.get_instrument(name).text);
+                if (j.contains("result")) InstrumentRegistry::instance().upsert(j["result"]);
+            } catch (const std::exception& e) {
+                logger.log(Logger::LogLevel::WARNING, "Failed to fetch new instrument " + name + ": " + e.what());
+            }
+        }
+        batch.clear();
+    }
+}
+
+size_t InstrumentLoader::fetch_all(const Lists& lists) {
+    if (lists.empty()) return 0;
+    ThreadPool pool(lists.size(), lists.size());
+    std::vector<std::future<bool>> pending;
+    for (const auto& list : lists) {
+        pending.push_back(pool.submit([this, list]() {
+            cpr::Response r = m_client.get_all_instruments(list.first, list.second);
+            auto instruments = rpc::decode_instruments(r.text);
+            if (!instruments.ok()) return false;
+            InstrumentRegistry::instance().load(list.first, list.second, *instruments.value);
+            return true;
+        }));
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        try {
+            if (pending[i].get()) continue;
+        } catch (const std::exception& e) {
+        }
+        ++failed;
+        logger.log(Logger::LogLevel::WARNING, "Failed to fetch " + lists[i].first + " " + lists[i].second + " instruments");
+    }
+    return failed;
+}
+
+void InstrumentLoader::persist() {
+    if (m_cache_path.empty()) return;
+    try {
+        InstrumentRegistry::instance().save(m_cache_path);
+    } catch (const std::exception& e) {
+        logger.log(Logger::LogLevel::WARNING, "Failed to save instrument cache: " + std::string(e.what()));
+    }
+}
@@ -0,0 +1,316 @@
+#include "instrument_registry.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr uint32_t kCacheMagic = 0x31434944;   // "DIC1"
+constexpr uint32_t kCacheVersion = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t instruments;
+    uint32_t lists;
+};
+
+template<typename T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void put_string(std::string& out, const std::string& value) {
+    put(out, static_cast<uint16_t>(value.size()));
+    out += value;
+}
+
+// Smallest encodings: six empty strings, six 8-byte numbers and the active
+// flag; two empty strings and a position count
+constexpr size_t kMinCachedInstrument = 6 * sizeof(uint16_t) + 6 * 8 + 1;
+constexpr size_t kMinCachedList = 2 * sizeof(uint16_t) + sizeof(uint32_t);
+
+struct CacheReader {
+    const char* in;
+    const char* end;
+
+    template<typename T>
+    T get() {
+        if (static_cast<size_t>(end - in) < sizeof(T)) throw std::runtime_error("Truncated instrument cache");
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+
+    // Throws unless count records of at least record_size bytes each could
+    // still follow, so a damaged count never sizes a huge allocation
+    void expect(uint64_t count, size_t record_size) const {
+        if (count > static_cast<size_t>(end - in) / record_size) throw std::runtime_error("Truncated instrument cache");
+    }
+
+    std::string get_string() {
+        uint16_t size = get<uint16_t>();
+        if (static_cast<size_t>(end - in) < size) throw std::runtime_error("Truncated instrument cache");
+        std::string value(in, size);
+        in += size;
+        return value;
+    }
+};
+
+}
+
+InstrumentRegistry& InstrumentRegistry::instance() {
+    static InstrumentRegistry registry;
+    return registry;
+}
+
+InstrumentRegistry::InstrumentRegistry() : m_chunks(new std::atomic<Instrument*>[kCapacity / kChunkSize]) {
+    for (size_t i = 0; i < kCapacity / kChunkSize; ++i) m_chunks[i].store(nullptr, std::memory_order_relaxed);
+    m_ids.reserve(4096);
+}
+
+InstrumentId InstrumentRegistry::find(const std::string& name) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_ids.find(name);
+    return it == m_ids.end() ? kNoInstrument : it->second;
+}
+
+InstrumentId InstrumentRegistry::intern(const std::string& name) {
+    InstrumentId id = find(name);
+    if (id != kNoInstrument) return id;
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    return intern_locked(name);
+}
+
+InstrumentId InstrumentRegistry::intern_locked(const std::string& name) {
+    auto it = m_ids.find(name);
+    if (it != m_ids.end()) return it->second;
+
+    size_t id = m_size.load(std::memory_order_relaxed);
+    if (id == kCapacity) throw std::length_error("InstrumentRegistry is full");
+    if ((id & (kChunkSize - 1)) == 0) {
+        m_owned.emplace_back(new Instrument[kChunkSize]);
+        m_chunks[id >> kChunkBits].store(m_owned.back().get(), std::memory_order_release);
+    }
+    Instrument& created = entry(static_cast<InstrumentId>(id));
+    created.id = static_cast<InstrumentId>(id);
+    created.name = name;
+    m_ids.emplace(name, created.id);
+    m_size.store(id + 1, std::memory_order_release);
+    return created.id;
+}
+
+InstrumentRegistry::Instrument InstrumentRegistry::get(InstrumentId id) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    if (id >= m_size.load(std::memory_order_relaxed)) return Instrument();
+    return entry(id);
+}
+
+void InstrumentRegistry::upsert(const json& instrument) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    upsert_locked(instrument);
+}
+
+InstrumentId InstrumentRegistry::upsert_locked(const json& instrument) {
+    Instrument fields;
+    fields.name = instrument.at("instrument_name").get<std::string>();
+    fields.kind = instrument.value("kind", "");
+    fields.base_currency = instrument.value("base_currency", "");
+    fields.quote_currency = instrument.value("quote_currency", "");
+    fields.settlement_currency = instrument.value("settlement_currency", "");
+    fields.option_type = instrument.value("option_type", "");
+    fields.tick_size = instrument.value("tick_size", 0.0);
+    fields.contract_size = instrument.value("contract_size", 0.0);
+    fields.min_trade_amount = instrument.value("min_trade_amount", 0.0);
+    fields.strike = instrument.value("strike", 0.0);
+    fields.creation_timestamp = instrument.value("creation_timestamp", uint64_t(0));
+    fields.expiration_timestamp = instrument.value("expiration_timestamp", uint64_t(0));
+    fields.is_active = instrument.value("is_active", true);
+    return store_locked(fields);
+}
+
+InstrumentId InstrumentRegistry::store_locked(const Instrument& fields) {
+    Instrument& e = entry(intern_locked(fields.name));
+    bool added = !e.has_metadata;
+    InstrumentId id = e.id;
+    // Everything but the name, which name(id) reads without the lock
+    e.kind = fields.kind;
+    e.base_currency = fields.base_currency;
+    e.quote_currency = fields.quote_currency;
+    e.settlement_currency = fields.settlement_currency;
+    e.option_type = fields.option_type;
+    e.tick_size = fields.tick_size;
+    e.contract_size = fields.contract_size;
+    e.min_trade_amount = fields.min_trade_amount;
+    e.strike = fields.strike;
+    e.creation_timestamp = fields.creation_timestamp;
+    e.expiration_timestamp = fields.expiration_timestamp;
+    e.is_active = fields.is_active;
+    e.has_metadata = true;
+    if (!added) return id;
+
+    for (auto& cached : m_lists) {
+        const std::string& currency = cached.first.first;
+        const std::string& kind = cached.first.second;
+        bool currency_matches = currency == "any" || currency == e.base_currency ||
+                                currency == e.quote_currency || currency == e.settlement_currency;
+        if (currency_matches && (kind == "any" || kind == e.kind)) cached.second.push_back(id);
+    }
+    return id;
+}
+
+void InstrumentRegistry::load(const std::string& currency, const std::string& kind, const json& instruments) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    std::vector<InstrumentId> ids;
+    ids.reserve(instruments.size());
+    for (const auto& instrument : instruments) ids.push_back(upsert_locked(instrument));
+    m_lists[{currency, kind}] = std::move(ids);
+}
+
+void InstrumentRegistry::load(const std::string& currency, const std::string& kind, const std::vector<Instrument>& instruments) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    std::vector<InstrumentId> ids;
+    ids.reserve(instruments.size());
+    for (const auto& instrument : instruments) ids.push_back(store_locked(instrument));
+    m_lists[{currency, kind}] = std::move(ids);
+}
+
+bool InstrumentRegistry::loaded(const std::string& currency, const std::string& kind) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_lists.count({currency, kind}) > 0;
+}
+
+std::vector<InstrumentRegistry::Instrument> InstrumentRegistry::list(const std::string& currency, const std::string& kind,
+                                                                     bool active_only) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    std::vector<Instrument> result;
+    auto cached = m_lists.find({currency, kind});
+    if (cached == m_lists.end()) return result;
+    for (InstrumentId id : cached->second) {
+        const Instrument& e = entry(id);
+        if (active_only && !e.is_active) continue;
+        result.push_back(e);
+    }
+    return result;
+}
+
+bool InstrumentRegistry::on_state(const json& data) {
+    std::string state = data.value("state", "");
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    Instrument& e = entry(intern_locked(data.at("instrument_name").get<std::string>()));
+    if (state == "created" || state == "started") {
+        e.is_active = true;
+        return !e.has_metadata;
+    }
+    // settled, closed, deactivated, terminated
+    e.is_active = false;
+    return false;
+}
+
+void InstrumentRegistry::save(const std::string& path) const {
+    std::string out;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        // Instruments are written once and referenced from the lists by position
+        std::unordered_map<InstrumentId, uint32_t> positions;
+        std::vector<InstrumentId> order;
+        for (const auto& cached : m_lists) {
+            for (InstrumentId id : cached.second) {
+                if (positions.emplace(id, static_cast<uint32_t>(order.size())).second) order.push_back(id);
+            }
+        }
+
+        put(out, CacheHeader{kCacheMagic, kCacheVersion, static_cast<uint32_t>(order.size()),
+                             static_cast<uint32_t>(m_lists.size())});
+        for (InstrumentId id : order) {
+            const Instrument& e = entry(id);
+            put_string(out, e.name);
+            put_string(out, e.kind);
+            put_string(out, e.base_currency);
+            put_string(out, e.quote_currency);
+            put_string(out, e.settlement_currency);
+            put_string(out, e.option_type);
+            put(out, e.tick_size);
+            put(out, e.contract_size);
+            put(out, e.min_trade_amount);
+            put(out, e.strike);
+            put(out, e.creation_timestamp);
+            put(out, e.expiration_timestamp);
+            put(out, static_cast<uint8_t>(e.is_active));
+        }
+        for (const auto& cached : m_lists) {
+            put_string(out, cached.first.first);
+            put_string(out, cached.first.second);
+            put(out, static_cast<uint32_t>(cached.second.size()));
+            for (InstrumentId id : cached.second) put(out, positions[id]);
+        }
+    }
+
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(out.data(), out.size());
+        if (!file) throw std::runtime_error("Failed to write instrument cache " + temp);
+    }
+    std::filesystem::rename(temp, path);
+}
+
+bool InstrumentRegistry::restore(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    CacheReader reader{data.data(), data.data() + data.size()};
+    if (data.size() < sizeof(CacheHeader)) return false;
+    CacheHeader header = reader.get<CacheHeader>();
+    if (header.magic != kCacheMagic || header.version != kCacheVersion) return false;
+
+    // Decode everything first so a damaged file changes nothing
+    if (header.instruments > kCapacity) throw std::runtime_error("Corrupt instrument cache");
+    reader.expect(header.instruments, kMinCachedInstrument);
+    std::vector<Instrument> instruments(header.instruments);
+    for (auto& e : instruments) {
+        e.name = reader.get_string();
+        e.kind = reader.get_string();
+        e.base_currency = reader.get_string();
+        e.quote_currency = reader.get_string();
+        e.settlement_currency = reader.get_string();
+        e.option_type = reader.get_string();
+        e.tick_size = reader.get<double>();
+        e.contract_size = reader.get<double>();
+        e.min_trade_amount = reader.get<double>();
+        e.strike = reader.get<double>();
+        e.creation_timestamp = reader.get<uint64_t>();
+        e.expiration_timestamp = reader.get<uint64_t>();
+        e.is_active = reader.get<uint8_t>() != 0;
+    }
+    reader.expect(header.lists, kMinCachedList);
+    std::vector<std::pair<std::pair<std::string, std::string>, std::vector<uint32_t>>> lists(header.lists);
+    for (auto& cached : lists) {
+        cached.first.first = reader.get_string();
+        cached.first.second = reader.get_string();
+        uint32_t positions = reader.get<uint32_t>();
+        reader.expect(positions, sizeof(uint32_t));
+        cached.second.resize(positions);
+        for (auto& position : cached.second) {
+            position = reader.get<uint32_t>();
+            if (position >= instruments.size()) throw std::runtime_error("Corrupt instrument cache");
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    std::vector<InstrumentId> ids;
+    ids.reserve(instruments.size());
+    for (const auto& e : instruments) ids.push_back(store_locked(e));
+    for (const auto& cached : lists) {
+        std::vector<InstrumentId>& list = m_lists[cached.first];
+        list.clear();
+        for (uint32_t position : cached.second) list.push_back(ids[position]);
+    }
+    return true;
+}
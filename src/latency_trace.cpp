@@ -0,0 +1,85 @@
+#include "latency_trace.hpp"
+
+thread_local LatencyTrace::ThreadState LatencyTrace::t_state;
+
+LatencyTrace& LatencyTrace::instance() {
+    static LatencyTrace trace;
+    return trace;
+}
+
+void LatencyTrace::begin_frame() {
+    uint32_t rate = sample_rate();
+    if (rate == 0 || ++t_state.counter < rate) {
+        t_state.active = false;
+        return;
+    }
+    t_state.counter = 0;
+    t_state.active = true;
+    t_state.dispatched = false;
+    t_state.begin = t_state.last = now_ns();
+    m_sampled.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyTrace::end_frame() {
+    if (!t_state.active) return;
+    if (t_state.dispatched) m_stages[TICK_TO_WIRE].record(now_ns() - t_state.begin);
+    t_state.active = false;
+}
+
+LatencyTrace::Handoff LatencyTrace::handoff() {
+    Handoff handoff;
+    if (!t_state.active) return handoff;
+    handoff.active = true;
+    handoff.begin = t_state.begin;
+    handoff.last = now_ns();
+    t_state.active = false;
+    return handoff;
+}
+
+void LatencyTrace::resume(const Handoff& handoff) {
+    t_state.active = handoff.active;
+    if (!handoff.active) return;
+    t_state.dispatched = false;
+    t_state.begin = handoff.begin;
+    t_state.last = now_ns();
+    m_stages[QUEUE_WAIT].record(t_state.last - handoff.last);
+}
+
+void LatencyTrace::record_exchange_timestamp(uint64_t exchange_ms) {
+    if (!t_state.active) return;
+    int64_t local_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    int64_t lag_us = local_us - static_cast<int64_t>(exchange_ms) * 1000;
+    m_stages[EXCHANGE_TO_RECEIVE].record(lag_us > 0 ? uint64_t(lag_us) * 1000 : uint64_t(0));
+}
+
+const char* LatencyTrace::stage_name(Stage stage) {
+    switch (stage) {
+        case EXCHANGE_TO_RECEIVE: return "exchange_to_receive";
+        case PARSE: return "parse";
+        case DISPATCH: return "dispatch";
+        case QUEUE_WAIT: return "queue_wait";
+        case LOCK_ACQUIRE: return "lock_acquire";
+        case SEND_ENQUEUE: return "send_enqueue";
+        case TICK_TO_WIRE: return "tick_to_wire";
+        default: return "unknown";
+    }
+}
+
+nlohmann::json LatencyTrace::to_json() const {
+    nlohmann::json stages = nlohmann::json::object();
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        Stage stage = static_cast<Stage>(i);
+        stages[stage_name(stage)] = LatencyHistogram::to_json(m_stages[i].summary());
+    }
+    return {
+        {"sample_rate", sample_rate()},
+        {"sampled_frames", sampled_frames()},
+        {"stages", stages}
+    };
+}
+
+void LatencyTrace::reset() {
+    for (auto& stage : m_stages) stage.reset();
+    m_sampled.store(0, std::memory_order_relaxed);
+}
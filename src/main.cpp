@@ -2,7 +2,21 @@
 #include "order_manager.hpp"
 #include "market_manager.hpp"
 #include "config.h"
+#include "latency_trace.hpp"
+#include "metrics_server.hpp"
+#include "tick_journal.hpp"
+#include "order_cache.hpp"
+#include "risk_gate.hpp"
+#include "position_cache.hpp"
+#include "instrument_registry.hpp"
+#include "instrument_loader.hpp"
+#include "market_data_publisher.hpp"
+#include <fstream>
+#include <future>
+#include <memory>
 #include <iostream>
+#include <sstream>
+#include <vector>
 #include <csignal>
 #include <atomic>
 #include <thread>
@@ -29,17 +43,164 @@ void signal_handler(int signal) {
     cv.notify_all(); 
 }
 
+// Currencies that orders and positions are listed under by the private API.
+// Linear instruments (BTC_USDC-*, ETH_USDC-*) settle, and are listed, in USDC.
+const char* const kSettlementCurrencies[] = {"BTC", "ETH", "USDC"};
+
+// Startup consistency check of the order cache against REST open orders.
+void reconcile_orders(DeribitClient& client, OrderCache& cache, Logger& logger) {
+    for (const std::string currency : kSettlementCurrencies) {
+        try {
+            cpr::Response r = client.get_open_orders(currency);
+            nlohmann::json j = nlohmann::json::parse(r.text);
+            if (!j.contains("result")) {
+                logger.log(Logger::LogLevel::WARNING, "Could not fetch open " + currency + " orders: " + r.text);
+                continue;
+            }
+            OrderCache::Reconciliation report = cache.reconcile(j["result"], currency);
+            if (report.consistent()) {
+                logger.log(Logger::LogLevel::SUCCESS, "Order cache consistent for " + currency + " (" +
+                           std::to_string(j["result"].size()) + " open)");
+            } else {
+                logger.log(Logger::LogLevel::WARNING, "Order cache reconciled for " + currency + ": " +
+                           std::to_string(report.missing.size()) + " missing, " +
+                           std::to_string(report.stale.size()) + " stale, " +
+                           std::to_string(report.mismatched.size()) + " mismatched");
+            }
+        } catch (const std::exception& e) {
+            logger.log(Logger::LogLevel::ERROR, "Order reconciliation failed: " + std::string(e.what()));
+        }
+    }
+}
+
+// Seeds the position cache and the risk gate; user.changes and user.trades
+// keep them current afterwards.
+void load_positions(DeribitClient& client, PositionCache& cache, RiskGate* gate, Logger& logger) {
+    for (const std::string currency : kSettlementCurrencies) {
+        try {
+            cpr::Response r = client.get_positions(currency, "any");
+            nlohmann::json j = nlohmann::json::parse(r.text);
+            if (!j.contains("result")) {
+                logger.log(Logger::LogLevel::WARNING, "Could not fetch " + currency + " positions: " + r.text);
+                continue;
+            }
+            cache.seed(currency, j["result"]);
+            if (!gate) continue;
+            for (const auto& position : j["result"]) {
+                gate->set_position(position["instrument_name"], position.value("size", 0.0));
+            }
+        } catch (const std::exception& e) {
+            logger.log(Logger::LogLevel::ERROR, "Loading positions failed: " + std::string(e.what()));
+        }
+    }
+}
+
 int main() {
     loadConfig();
+    LatencyTrace::instance().set_sample_rate(TRACE_SAMPLE_RATE);
+    MetricsServer metrics_server;
+    if (METRICS_PORT != 0) {
+        metrics_server.start(METRICS_PORT);
+    }
     
 
     const uint16_t port = 9002;
+    std::unique_ptr<TickJournal> journal;
 
     try {
         DeribitClient deribit_client;
+        if (!JOURNAL_DIR.empty()) {
+            TickJournal::Options options;
+            options.directory = JOURNAL_DIR;
+            options.segment_bytes = JOURNAL_SEGMENT_MB << 20;
+            journal.reset(new TickJournal(options));
+            journal->start();
+            deribit_client.set_journal(journal.get());
+        }
         deribit_client.authenticate();
-        WebSocketServer server(deribit_client);
+        InstrumentLoader instrument_loader(deribit_client, INSTRUMENT_CACHE_FILE);
+        instrument_loader.start(InstrumentLoader::default_lists());
+        // Created before the server so it outlives the feed thread that writes to it
+        std::unique_ptr<MarketDataPublisher> market_data_bus;
+        if (!MARKET_DATA_BUS.empty()) {
+            MarketDataPublisher::Options options;
+            options.name = MARKET_DATA_BUS;
+            market_data_bus.reset(new MarketDataPublisher(options));
+        }
+        WebSocketServer server(deribit_client, FANOUT_WORKERS, FANOUT_QUEUE_CAPACITY);
+        if (market_data_bus) {
+            std::vector<std::string> symbols;
+            std::stringstream list(MARKET_DATA_BUS_SYMBOLS);
+            for (std::string symbol; std::getline(list, symbol, ',');) {
+                if (!symbol.empty()) symbols.push_back(symbol);
+            }
+            server.set_market_data_publisher(market_data_bus.get(), symbols);
+        }
+
+        // One upstream connection carries both the private order and trade
+        // updates and the public market data the server fans out.
+        OrderCache order_cache;
+        deribit_client.add_channel_listener("user.", [&order_cache](const std::string& channel, const nlohmann::json& data) {
+            order_cache.on_channel(channel, data);
+        });
+        std::unique_ptr<RiskGate> risk_gate;
+        if (!RISK_LIMITS_FILE.empty()) {
+            std::ifstream file(RISK_LIMITS_FILE);
+            nlohmann::json limits = nlohmann::json::parse(file);
+            risk_gate = RiskGate::from_json(limits);
+            risk_gate->set_order_cache(&order_cache);
+            RiskGate* gate = risk_gate.get();
+            deribit_client.add_channel_listener("user.trades.", [gate](const std::string& channel, const nlohmann::json& data) {
+                gate->on_channel(channel, data);
+            });
+            // Collars need a BBO for every instrument with its own limits. Each
+            // quote listener resolves its instrument once, here.
+            if (limits.contains("instruments")) {
+                for (const auto& instrument : limits["instruments"].items()) {
+                    std::string quote = "quote." + instrument.key();
+                    InstrumentId id = InstrumentRegistry::instance().intern(instrument.key());
+                    deribit_client.add_channel_listener(quote, [gate, quote, id](const std::string& channel, const nlohmann::json& data) {
+                        // The prefix also matches longer names, such as a future's options
+                        if (channel != quote) return;
+                        gate->update_bbo(id, data.value("best_bid_price", 0.0), data.value("best_ask_price", 0.0));
+                    });
+                    deribit_client.subscribe_public(quote);
+                }
+            }
+        }
+        PositionCache position_cache;
+        auto positions_feed = [&position_cache](const std::string& channel, const nlohmann::json& data) {
+            position_cache.on_channel(channel, data);
+        };
+        deribit_client.add_channel_listener("user.changes.", positions_feed);
+        deribit_client.add_channel_listener("user.portfolio.", positions_feed);
+        deribit_client.add_channel_listener("ticker.", positions_feed);
+        position_cache.set_instrument_callback([&deribit_client](const std::string& instrument) {
+            deribit_client.subscribe_public("ticker." + instrument + ".100ms");
+        });
+        // New listings arrive without metadata; it is fetched off the feed thread
+        deribit_client.add_channel_listener("instrument.state.", [&instrument_loader](const std::string&, const nlohmann::json& data) {
+            if (InstrumentRegistry::instance().on_state(data)) instrument_loader.fetch_later(data["instrument_name"].get<std::string>());
+        });
+        // The listeners above point at objects that go out of scope before the
+        // client, so the feed thread is stopped first.
+        struct FeedStop {
+            DeribitClient& client;
+            ~FeedStop() { client.stop_websocket(); }
+        } feed_stop{deribit_client};
+        deribit_client.subscribe_private("instrument.state.any.any");
+        deribit_client.subscribe_private("user.changes.any.any.raw");
+        deribit_client.subscribe_private("user.portfolio.any");
+        deribit_client.subscribe_private("user.orders.any.any.raw");
+        deribit_client.subscribe_private("user.trades.any.any.raw");
+        deribit_client.connect_websocket();
+        reconcile_orders(deribit_client, order_cache, deribit_client.logger);
+        load_positions(deribit_client, position_cache, risk_gate.get(), deribit_client.logger);
+
         OrderManager order_manager(deribit_client);
+        order_manager.set_order_cache(&order_cache);
+        order_manager.set_risk_gate(risk_gate.get());
+        order_manager.set_position_cache(&position_cache);
         MarketManager market_manager(deribit_client);
         server_ptr = &server;
 
@@ -58,7 +219,8 @@ int main() {
             std::cout << "5. View Orderbook" << std::endl;
             std::cout << "6. Start WebSocket Server" << std::endl;
             std::cout << "7. View All Avalable Instruments (Market Coverage)" << std::endl;
-            std::cout << "8. Exit" << std::endl;
+            std::cout << "8. View Open Orders (local cache)" << std::endl;
+            std::cout << "9. Exit" << std::endl;
             std::cout << "Enter your choice:  ";
             std::cout << RESET;
             int choice;
@@ -80,7 +242,7 @@ int main() {
                 }
                 case 2: {
                     std::string symbol, side, type, quantity, price;
-                    std::cout << "Enter symbol: ";
+                    std::cout << "Enter symbol (comma separated to quote several): ";
                     std::cin >> symbol;
                     std::cout << "Enter side: ";
                     std::cin >> side;
@@ -90,7 +252,13 @@ int main() {
                     std::cin >> quantity;
                     std::cout << "Enter price: ";
                     std::cin >> price;
-                    std::cout << order_manager.place_order(symbol, side, type, quantity, price) << std::endl;
+                    // One order per symbol, all in flight at once
+                    std::vector<std::future<std::string>> results;
+                    std::stringstream symbols(symbol);
+                    for (std::string instrument; std::getline(symbols, instrument, ',');) {
+                        if (!instrument.empty()) results.push_back(order_manager.place_order_async(instrument, side, type, quantity, price));
+                    }
+                    for (auto& result : results) std::cout << result.get() << std::endl;
                     break;
                 }
                 case 3: {
@@ -146,6 +314,13 @@ int main() {
                     break;
                 }
                 case 8: {
+                    std::string instrument_name;
+                    std::cout << "Enter Instrument Name (any for all): ";
+                    std::cin >> instrument_name;
+                    std::cout << order_manager.view_open_orders(instrument_name) << std::endl;
+                    break;
+                }
+                case 9: {
                     std::cout << "Shutting down..." << std::endl;
                     running = false;
                     break;
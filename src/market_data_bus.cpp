@@ -0,0 +1,89 @@
+#include "market_data_bus.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MarketDataBusReader::MarketDataBusReader(const std::string& name) {
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) throw std::runtime_error("Market data bus " + name + " not found: " + std::strerror(errno));
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(mdbus::Header)) {
+        ::close(fd);
+        throw std::runtime_error("Market data bus " + name + " is not initialized");
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    m_map = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_map == MAP_FAILED) {
+        m_map = nullptr;
+        throw std::runtime_error("Failed to map market data bus " + name + ": " + std::strerror(errno));
+    }
+
+    m_header = static_cast<const mdbus::Header*>(m_map);
+    if (m_header->magic.load(std::memory_order_acquire) != mdbus::kMagic || m_header->version != mdbus::kVersion ||
+        m_header->depth != mdbus::kDepth ||
+        m_size < mdbus::mapping_size(m_header->book_slots, m_header->ring_capacity)) {
+        ::munmap(m_map, m_size);
+        m_map = nullptr;
+        throw std::runtime_error("Market data bus " + name + " has an unsupported layout");
+    }
+    const char* base = static_cast<const char*>(m_map);
+    m_books = reinterpret_cast<const mdbus::BookSlot*>(base + m_header->books_offset);
+    m_ring = reinterpret_cast<const mdbus::RingSlot*>(base + m_header->ring_offset);
+    m_mask = m_header->ring_capacity - 1;
+    m_next = m_header->ring_head.load(std::memory_order_acquire);
+}
+
+MarketDataBusReader::~MarketDataBusReader() {
+    if (m_map) ::munmap(m_map, m_size);
+}
+
+int MarketDataBusReader::find(const std::string& instrument) {
+    auto it = m_slots.find(instrument);
+    if (it != m_slots.end()) return it->second;
+    size_t used = instruments();
+    for (; m_indexed < used; ++m_indexed) {
+        m_slots.emplace(this->instrument(m_indexed), static_cast<int>(m_indexed));
+    }
+    it = m_slots.find(instrument);
+    return it == m_slots.end() ? -1 : it->second;
+}
+
+size_t MarketDataBusReader::instruments() const {
+    return m_header->books_used.load(std::memory_order_acquire);
+}
+
+std::string MarketDataBusReader::instrument(size_t slot) const {
+    if (slot >= instruments()) return "";
+    const char* name = m_books[slot].instrument;
+    return std::string(name, ::strnlen(name, mdbus::kNameSize));
+}
+
+mdbus::Book MarketDataBusReader::book(size_t slot) const {
+    if (slot >= instruments()) throw std::out_of_range("No market data bus slot " + std::to_string(slot));
+    return m_books[slot].book.load();
+}
+
+bool MarketDataBusReader::poll(mdbus::Update& update) {
+    const uint64_t capacity = m_mask + 1;
+    for (;;) {
+        uint64_t head = m_header->ring_head.load(std::memory_order_acquire);
+        if (m_next == head) return false;
+        if (head - m_next > capacity) {
+            m_lost += head - capacity - m_next;
+            m_next = head - capacity;
+        }
+        update = m_ring[m_next & m_mask].update.load();
+        if (update.sequence == m_next) {
+            ++m_next;
+            return true;
+        }
+        // Overwritten by a newer record while we got to it
+        ++m_lost;
+        ++m_next;
+    }
+}
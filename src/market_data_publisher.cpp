@@ -0,0 +1,179 @@
+#include "market_data_publisher.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+Counter& bus_updates = MetricsRegistry::instance().counter("deribit_mdbus_updates_total", "Book updates published to the shared-memory bus");
+Gauge& bus_instruments = MetricsRegistry::instance().gauge("deribit_mdbus_instruments", "Instruments with a slot on the shared-memory bus");
+Counter& bus_dropped = MetricsRegistry::instance().counter("deribit_mdbus_queue_dropped_total", "Book notifications dropped because the bus publisher's queue was full");
+
+uint64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t copy_levels(const std::vector<OrderBook::Level>& from, mdbus::Level* to) {
+    size_t count = std::min(from.size(), mdbus::kDepth);
+    for (size_t i = 0; i < count; ++i) to[i] = mdbus::Level{from[i].price, from[i].amount};
+    return count;
+}
+}
+
+MarketDataPublisher::MarketDataPublisher(const Options& options)
+    : m_options(options), m_queue(options.queue_capacity) {
+    size_t capacity = 2;
+    while (capacity < m_options.ring_capacity) capacity <<= 1;
+    m_options.ring_capacity = capacity;
+    m_size = mdbus::mapping_size(m_options.book_slots, capacity);
+
+    ::shm_unlink(m_options.name.c_str());
+    int fd = ::shm_open(m_options.name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) throw std::runtime_error("Failed to create market data bus " + m_options.name + ": " + std::strerror(errno));
+    if (::ftruncate(fd, static_cast<off_t>(m_size)) != 0) {
+        int err = errno;
+        ::close(fd);
+        ::shm_unlink(m_options.name.c_str());
+        throw std::runtime_error("Failed to size market data bus " + m_options.name + ": " + std::strerror(err));
+    }
+    m_map = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_map == MAP_FAILED) {
+        m_map = nullptr;
+        ::shm_unlink(m_options.name.c_str());
+        throw std::runtime_error("Failed to map market data bus " + m_options.name + ": " + std::strerror(errno));
+    }
+
+    char* base = static_cast<char*>(m_map);
+    m_header = new (base) mdbus::Header();
+    m_header->version = mdbus::kVersion;
+    m_header->book_slots = static_cast<uint32_t>(m_options.book_slots);
+    m_header->depth = mdbus::kDepth;
+    m_header->ring_capacity = capacity;
+    m_header->books_offset = mdbus::books_offset();
+    m_header->ring_offset = mdbus::ring_offset(m_options.book_slots);
+    m_header->books_used.store(0, std::memory_order_relaxed);
+    m_header->ring_head.store(0, std::memory_order_relaxed);
+    m_books = reinterpret_cast<mdbus::BookSlot*>(base + m_header->books_offset);
+    m_ring = reinterpret_cast<mdbus::RingSlot*>(base + m_header->ring_offset);
+    for (size_t i = 0; i < m_options.book_slots; ++i) new (&m_books[i]) mdbus::BookSlot();
+    for (size_t i = 0; i < capacity; ++i) new (&m_ring[i]) mdbus::RingSlot();
+    m_header->magic.store(mdbus::kMagic, std::memory_order_release);
+
+    m_local.reserve(m_options.book_slots);
+    logger.log(Logger::LogLevel::INFO, "Publishing market data on shared memory " + m_options.name);
+}
+
+MarketDataPublisher::~MarketDataPublisher() {
+    stop();
+    if (m_map) ::munmap(m_map, m_size);
+    ::shm_unlink(m_options.name.c_str());
+}
+
+int MarketDataPublisher::add_instrument(const std::string& instrument) {
+    InstrumentId id = InstrumentRegistry::instance().intern(instrument);
+    if (id < m_slots.size() && m_slots[id] >= 0) return m_slots[id];
+
+    size_t slot = m_local.size();
+    if (slot == m_options.book_slots || instrument.size() >= mdbus::kNameSize) {
+        if (!m_full_logged) {
+            logger.log(Logger::LogLevel::WARNING, "No market data bus slot for " + instrument);
+            m_full_logged = true;
+        }
+        return -1;
+    }
+    if (id >= m_slots.size()) m_slots.resize(id + 1, -1);
+    m_slots[id] = static_cast<int>(slot);
+    m_local.emplace_back(instrument);
+    std::memcpy(m_books[slot].instrument, instrument.c_str(), instrument.size() + 1);
+    m_header->books_used.store(static_cast<uint32_t>(slot + 1), std::memory_order_release);
+    bus_instruments.set(slot + 1);
+    return static_cast<int>(slot);
+}
+
+void MarketDataPublisher::start() {
+    if (m_running.exchange(true)) return;
+    m_thread = std::thread([this]() {
+        publish_loop();
+    });
+}
+
+void MarketDataPublisher::stop() {
+    if (!m_running.exchange(false)) return;
+    m_waiter.notify();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool MarketDataPublisher::enqueue(int slot, const std::string& payload) {
+    bool queued = m_queue.try_push_with([&](Pending& pending) {
+        pending.slot = slot;
+        pending.payload.assign(payload);
+    });
+    if (queued) m_waiter.notify();
+    else bus_dropped.inc();
+    return queued;
+}
+
+void MarketDataPublisher::publish_loop() {
+    auto apply_pending = [this](Pending& pending) {
+        apply(pending);
+    };
+    for (;;) {
+        if (m_queue.try_pop_with(apply_pending)) continue;
+        if (!m_running) break;
+        m_waiter.wait([this]() { return !m_queue.empty() || !m_running; });
+    }
+}
+
+void MarketDataPublisher::apply(const Pending& pending) {
+    if (pending.slot < 0 || static_cast<size_t>(pending.slot) >= m_local.size()) return;
+    try {
+        json message = json::parse(pending.payload);
+        OrderBook& book = m_local[pending.slot];
+        book.apply(message.at("params").at("data"));
+        publish(pending.slot, book);
+    } catch (const json::exception& e) {
+        logger.log(Logger::LogLevel::ERROR, "Failed to publish book to market data bus: " + std::string(e.what()));
+    }
+}
+
+void MarketDataPublisher::publish(const OrderBook& book) {
+    int slot = add_instrument(book.instrument_name());
+    if (slot >= 0) publish(slot, book);
+}
+
+void MarketDataPublisher::publish(int slot, const OrderBook& book) {
+    mdbus::Book snapshot{};
+    snapshot.change_id = book.change_id();
+    snapshot.timestamp_ms = book.timestamp();
+    snapshot.published_ns = monotonic_ns();
+    snapshot.valid = book.is_valid();
+    snapshot.bid_levels = static_cast<uint32_t>(copy_levels(book.bids(), snapshot.bids));
+    snapshot.ask_levels = static_cast<uint32_t>(copy_levels(book.asks(), snapshot.asks));
+    m_books[slot].book.store(snapshot);
+
+    uint64_t sequence = m_header->ring_head.load(std::memory_order_relaxed);
+    mdbus::Update update{};
+    update.sequence = sequence;
+    update.slot = static_cast<uint32_t>(slot);
+    update.valid = snapshot.valid;
+    update.change_id = snapshot.change_id;
+    update.timestamp_ms = snapshot.timestamp_ms;
+    update.published_ns = snapshot.published_ns;
+    if (snapshot.bid_levels) update.best_bid = snapshot.bids[0];
+    if (snapshot.ask_levels) update.best_ask = snapshot.asks[0];
+    m_ring[sequence & (m_options.ring_capacity - 1)].update.store(update);
+    m_header->ring_head.store(sequence + 1, std::memory_order_release);
+
+    ++m_published;
+    bus_updates.inc();
+}
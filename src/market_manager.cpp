@@ -1,5 +1,6 @@
 #include "performance_tracker.hpp"
 #include "market_manager.hpp"
+#include "instrument_registry.hpp"
 #include <nlohmann/json.hpp>
 #include <vector>
 #include <cpr/cpr.h>
@@ -7,7 +8,7 @@
 using json = nlohmann::json;
 using response = cpr::Response;
 
-MarketManager::MarketManager(DeribitClient client) : client(client) {
+MarketManager::MarketManager(DeribitClient& client) : client(client) {
     this->logger = Logger();
 }
 
@@ -15,26 +16,38 @@ MarketManager::~MarketManager() {}
 
 std::string MarketManager::view_all_instruments(const std::string& currency, const std::string& kind) {
     logger.log(Logger::LogLevel::INFO, "Viewing all instruments");
+    InstrumentRegistry& registry = InstrumentRegistry::instance();
+    if (registry.loaded(currency, kind)) {
+        std::vector<std::string> names;
+        for (const auto& instrument : registry.list(currency, kind)) {
+            names.push_back(instrument.name);
+        }
+        return json(names).dump(4);
+    }
     try {
-        PerformanceTracker tracker("view_all_instruments");
-        response r = client.get_all_instruments(currency, kind);
-        tracker.stop();
-
-        json j = json::parse(r.text);
-        if (j.contains("error")){
-            logger.log(Logger::LogLevel::WARNING, j["error"]["message"]);
-            return j["error"].dump();
-        } else {
-            logger.log(Logger::LogLevel::SUCCESS, "Instruments retrieved successfully");
-            std::vector<std::string> instruments;
-            for (auto& instrument : j["result"]) {
-                instruments.push_back(instrument["instrument_name"]);
-            }
-
-            return json(instruments).dump(4);
+        rpc::Result<std::vector<rpc::Instrument>> result = instruments(currency, kind);
+        if (!result.ok()) {
+            logger.log(Logger::LogLevel::WARNING, result.error.message);
+            return rpc::to_json(result.error).dump();
+        }
+        logger.log(Logger::LogLevel::SUCCESS, "Instruments retrieved successfully");
+        std::vector<std::string> names;
+        for (const auto& instrument : *result.value) {
+            names.push_back(instrument.name);
         }
+        return json(names).dump(4);
     } catch (const std::exception& e) {
         logger.log(Logger::LogLevel::ERROR, e.what());
         return "";
     }
-}
\ No newline at end of file
+}
+
+rpc::Result<std::vector<rpc::Instrument>> MarketManager::instruments(const std::string& currency, const std::string& kind) {
+    PerformanceTracker tracker(PERF_SITE("view_all_instruments"));
+    response r = client.get_all_instruments(currency, kind);
+    tracker.stop();
+
+    rpc::Result<std::vector<rpc::Instrument>> result = rpc::decode_instruments(r.text);
+    if (result.ok()) InstrumentRegistry::instance().load(currency, kind, *result.value);
+    return result;
+}
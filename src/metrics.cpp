@@ -0,0 +1,99 @@
+#include "metrics.hpp"
+#include <sstream>
+#include <stdexcept>
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name, const std::string& help, Type type) {
+    auto it = m_families.find(name);
+    if (it == m_families.end()) {
+        it = m_families.emplace(name, Family{type, help, {}, {}, {}}).first;
+    } else if (it->second.type != type) {
+        throw std::logic_error("Metric " + name + " registered with two types");
+    }
+    return it->second;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& series = family(name, help, Type::COUNTER).counters[labels];
+    if (!series) series.reset(new Counter());
+    return *series;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& series = family(name, help, Type::GAUGE).gauges[labels];
+    if (!series) series.reset(new Gauge());
+    return *series;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& series = family(name, help, Type::SUMMARY).histograms[labels];
+    if (!series) series.reset(new LatencyHistogram());
+    return *series;
+}
+
+std::string MetricsRegistry::label(const std::string& name, const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') escaped += '\\';
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return name + "=\"" + escaped + "\"";
+}
+
+static std::string series_name(const std::string& name, const std::string& labels, const std::string& extra = "") {
+    std::string joined = labels;
+    if (!extra.empty()) joined += (joined.empty() ? "" : ",") + extra;
+    return joined.empty() ? name : name + "{" + joined + "}";
+}
+
+std::string MetricsRegistry::render() const {
+    std::ostringstream out;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& entry : m_families) {
+        const std::string& name = entry.first;
+        const Family& family = entry.second;
+        out << "# HELP " << name << " " << family.help << "\n";
+        switch (family.type) {
+            case Type::COUNTER:
+                out << "# TYPE " << name << " counter\n";
+                for (const auto& series : family.counters) {
+                    out << series_name(name, series.first) << " " << series.second->value() << "\n";
+                }
+                break;
+            case Type::GAUGE:
+                out << "# TYPE " << name << " gauge\n";
+                for (const auto& series : family.gauges) {
+                    out << series_name(name, series.first) << " " << series.second->value() << "\n";
+                }
+                break;
+            case Type::SUMMARY:
+                out << "# TYPE " << name << " summary\n";
+                for (const auto& series : family.histograms) {
+                    LatencyHistogram::Summary s = series.second->summary();
+                    const std::pair<const char*, uint64_t> quantiles[] = {
+                        {"0.5", s.p50}, {"0.9", s.p90}, {"0.99", s.p99}, {"0.999", s.p999}
+                    };
+                    for (const auto& q : quantiles) {
+                        out << series_name(name, series.first, std::string("quantile=\"") + q.first + "\"") << " "
+                            << q.second / 1e9 << "\n";
+                    }
+                    out << series_name(name + "_sum", series.first) << " " << s.mean * s.count / 1e9 << "\n";
+                    out << series_name(name + "_count", series.first) << " " << s.count << "\n";
+                }
+                break;
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,56 @@
+#include "metrics_server.hpp"
+#include "metrics.hpp"
+#include "performance_tracker.hpp"
+
+MetricsServer::MetricsServer() {
+    m_server.clear_access_channels(websocketpp::log::alevel::all);
+    m_server.clear_error_channels(websocketpp::log::elevel::all);
+    m_server.init_asio();
+    m_server.set_reuse_addr(true);
+    m_server.set_http_handler([this](websocketpp::connection_hdl hdl) {
+        on_http(hdl);
+    });
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::start(uint16_t port) {
+    if (m_thread.joinable()) return;
+
+    try {
+        // Loopback only; the endpoint is unauthenticated
+        m_server.listen(websocketpp::lib::asio::ip::tcp::endpoint(websocketpp::lib::asio::ip::address_v4::loopback(), port));
+        m_server.start_accept();
+    } catch (const std::exception& e) {
+        logger.log(Logger::LogLevel::ERROR, "Error starting metrics server: " + std::string(e.what()));
+        return;
+    }
+    m_thread = std::thread([this]() {
+        try {
+            m_server.run();
+        } catch (const std::exception& e) {
+            logger.log(Logger::LogLevel::ERROR, "Error running metrics server: " + std::string(e.what()));
+        }
+    });
+    logger.log(Logger::LogLevel::INFO, "Metrics available on http://127.0.0.1:" + std::to_string(port) + "/metrics");
+}
+
+void MetricsServer::stop() {
+    if (!m_thread.joinable()) return;
+    m_server.stop();
+    m_thread.join();
+}
+
+void MetricsServer::on_http(websocketpp::connection_hdl hdl) {
+    auto con = m_server.get_con_from_hdl(hdl);
+    if (con->get_resource() != "/metrics") {
+        con->set_status(websocketpp::http::status_code::not_found);
+        return;
+    }
+    perf::drain();
+    con->set_status(websocketpp::http::status_code::ok);
+    con->append_header("Content-Type", "text/plain; version=0.0.4");
+    con->set_body(MetricsRegistry::instance().render());
+}
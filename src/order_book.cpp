@@ -0,0 +1,68 @@
+#include "order_book.hpp"
+#include <algorithm>
+
+using json = nlohmann::json;
+
+namespace {
+const json kNoLevels = json::array();
+}
+
+OrderBook::OrderBook(std::string instrument_name) : m_instrument_name(std::move(instrument_name)) {}
+
+bool OrderBook::apply(const json& data) {
+    std::string type = data.value("type", "snapshot");
+    auto bids_it = data.find("bids");
+    auto asks_it = data.find("asks");
+    const json& bids = bids_it != data.end() ? *bids_it : kNoLevels;
+    const json& asks = asks_it != data.end() ? *asks_it : kNoLevels;
+    bool grouped = (!bids.empty() && bids[0].size() == 2) || (!asks.empty() && asks[0].size() == 2);
+
+    if (type == "snapshot" || grouped) {
+        clear();
+        m_valid = true;
+    } else if (!m_valid || data.value("prev_change_id", uint64_t(0)) != m_change_id) {
+        m_valid = false;
+        return false;
+    }
+
+    apply_side(true, bids);
+    apply_side(false, asks);
+    m_change_id = data.value("change_id", m_change_id);
+    m_timestamp = data.value("timestamp", m_timestamp);
+    if (m_instrument_name.empty()) m_instrument_name = data.value("instrument_name", "");
+    return true;
+}
+
+void OrderBook::apply_side(bool bid, const json& entries) {
+    for (const auto& entry : entries) {
+        if (entry.size() == 3) {
+            double amount = entry[0].get_ref<const std::string&>() == "delete" ? 0.0 : entry[2].get<double>();
+            apply_level(bid, entry[1].get<double>(), amount);
+        } else {
+            apply_level(bid, entry[0].get<double>(), entry[1].get<double>());
+        }
+    }
+}
+
+void OrderBook::apply_level(bool bid, double price, double amount) {
+    std::vector<Level>& side = bid ? m_bids : m_asks;
+    auto it = bid
+        ? std::lower_bound(side.begin(), side.end(), price, [](const Level& l, double p) { return l.price > p; })
+        : std::lower_bound(side.begin(), side.end(), price, [](const Level& l, double p) { return l.price < p; });
+
+    bool found = it != side.end() && it->price == price;
+    if (amount <= 0.0) {
+        if (found) side.erase(it);
+    } else if (found) {
+        it->amount = amount;
+    } else {
+        side.insert(it, Level{price, amount});
+    }
+}
+
+void OrderBook::clear() {
+    m_bids.clear();
+    m_asks.clear();
+    m_change_id = 0;
+    m_valid = false;
+}
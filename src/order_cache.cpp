@@ -0,0 +1,327 @@
+#include "order_cache.hpp"
+#include "rpc_decoder.hpp"
+#include "instrument_registry.hpp"
+#include <algorithm>
+#include <mutex>
+
+using json = nlohmann::json;
+
+static bool starts_with(const std::string& value, const std::string& prefix) {
+    return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+// From the registry's metadata when it is loaded, else from the name:
+// BTC-PERPETUAL settles in BTC, BTC_USDC-PERPETUAL in USDC.
+static std::string settlement_currency(const std::string& instrument) {
+    InstrumentId id = InstrumentRegistry::instance().find(instrument);
+    if (id != kNoInstrument) {
+        InstrumentRegistry::Instrument metadata = InstrumentRegistry::instance().get(id);
+        if (metadata.has_metadata && !metadata.settlement_currency.empty()) return metadata.settlement_currency;
+    }
+    std::string base = instrument.substr(0, instrument.find('-'));
+    size_t underscore = base.find('_');
+    return underscore == std::string::npos ? base : base.substr(underscore + 1);
+}
+
+OrderCache::OrderCache(size_t max_closed, size_t max_trade_ids)
+    : m_max_closed(max_closed), m_max_trade_ids(max_trade_ids) {}
+
+OrderCache::Order OrderCache::parse_order(const json& order) {
+    Order parsed;
+    parsed.order_id = order.at("order_id").get<std::string>();
+    parsed.label = order.value("label", "");
+    parsed.instrument_name = order.value("instrument_name", "");
+    parsed.direction = order.value("direction", "");
+    parsed.order_type = order.value("order_type", "");
+    parsed.order_state = order.value("order_state", "");
+    parsed.price = order.contains("price") && order["price"].is_number() ? order["price"].get<double>() : 0.0;
+    parsed.amount = order.value("amount", 0.0);
+    parsed.filled_amount = order.value("filled_amount", 0.0);
+    parsed.average_price = order.value("average_price", 0.0);
+    parsed.creation_timestamp = order.value("creation_timestamp", uint64_t(0));
+    parsed.last_update_timestamp = order.value("last_update_timestamp", uint64_t(0));
+    return parsed;
+}
+
+json OrderCache::to_json(const Order& order) {
+    json fills = json::array();
+    for (const auto& fill : order.fills) {
+        fills.push_back({
+            {"trade_id", fill.trade_id},
+            {"price", fill.price},
+            {"amount", fill.amount},
+            {"fee", fill.fee},
+            {"timestamp", fill.timestamp}
+        });
+    }
+    return {
+        {"order_id", order.order_id},
+        {"label", order.label},
+        {"instrument_name", order.instrument_name},
+        {"direction", order.direction},
+        {"order_type", order.order_type},
+        {"order_state", order.order_state},
+        {"price", order.price},
+        {"amount", order.amount},
+        {"filled_amount", order.filled_amount},
+        {"average_price", order.average_price},
+        {"creation_timestamp", order.creation_timestamp},
+        {"last_update_timestamp", order.last_update_timestamp},
+        {"fills", fills}
+    };
+}
+
+void OrderCache::apply_order(const json& order) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    apply_order_locked(order);
+}
+
+void OrderCache::apply_trade(const json& trade) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    apply_trade_locked(trade);
+}
+
+void OrderCache::apply_ack(const json& result) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if (result.contains("order")) {
+        apply_order_locked(result["order"]);
+        if (result.contains("trades")) {
+            for (const auto& trade : result["trades"]) apply_trade_locked(trade);
+        }
+    } else if (result.contains("order_id")) {
+        apply_order_locked(result);
+    }
+}
+
+void OrderCache::apply_ack(const rpc::OrderAck& ack) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    store_order_locked(ack.order);
+    for (const auto& trade : ack.trades) {
+        store_fill_locked(trade.order_id, Fill{trade.trade_id, trade.price, trade.amount, trade.fee, trade.timestamp});
+    }
+}
+
+void OrderCache::apply_order(const Order& order) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    store_order_locked(order);
+}
+
+void OrderCache::on_channel(const std::string& channel, const json& data) {
+    bool orders = starts_with(channel, "user.orders.");
+    if (!orders && !starts_with(channel, "user.trades.")) return;
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto apply = [&](const json& entry) {
+        if (orders) apply_order_locked(entry);
+        else apply_trade_locked(entry);
+    };
+    if (data.is_array()) {
+        for (const auto& entry : data) apply(entry);
+    } else {
+        apply(data);
+    }
+}
+
+void OrderCache::apply_order_locked(const json& order) {
+    store_order_locked(parse_order(order));
+}
+
+void OrderCache::store_order_locked(Order incoming) {
+    auto it = m_orders.find(incoming.order_id);
+    if (it != m_orders.end()) {
+        Order& current = it->second;
+        // Channel and REST updates can interleave; keep the newest, and at
+        // equal timestamps never move a closed order back to open.
+        if (incoming.last_update_timestamp < current.last_update_timestamp) return;
+        if (incoming.last_update_timestamp == current.last_update_timestamp &&
+            (incoming.filled_amount < current.filled_amount || (incoming.is_open() && !current.is_open()))) {
+            return;
+        }
+        bool was_open = current.is_open();
+        index_open(current, false);
+        if (current.label != incoming.label) m_by_label[current.label].erase(current.order_id);
+        current = std::move(incoming);
+        index_open(current, current.is_open());
+        m_by_label[current.label].insert(current.order_id);
+        if (was_open && !current.is_open()) m_closed.push_back(current.order_id);
+        evict_locked();
+        return;
+    }
+
+    const Order& stored = m_orders.emplace(incoming.order_id, std::move(incoming)).first->second;
+    index_open(stored, stored.is_open());
+    m_by_label[stored.label].insert(stored.order_id);
+    if (!stored.is_open()) m_closed.push_back(stored.order_id);
+    evict_locked();
+}
+
+void OrderCache::erase_locked(std::unordered_map<std::string, Order>::iterator it) {
+    const Order& order = it->second;
+    index_open(order, false);
+    auto label = m_by_label.find(order.label);
+    if (label != m_by_label.end()) {
+        label->second.erase(order.order_id);
+        if (label->second.empty()) m_by_label.erase(label);
+    }
+    m_orders.erase(it);
+}
+
+// An id in m_closed may have been reopened or already dropped by reconcile;
+// those are skipped. Fills go with their order. The fills of a trade whose
+// order never showed up are dropped once the trade id ages out.
+void OrderCache::evict_locked() {
+    while (m_closed.size() > m_max_closed) {
+        auto it = m_orders.find(m_closed.front());
+        if (it != m_orders.end() && !it->second.is_open()) {
+            m_fills.erase(it->first);
+            erase_locked(it);
+        }
+        m_closed.pop_front();
+    }
+    while (m_trade_order.size() > m_max_trade_ids) {
+        const auto& oldest = m_trade_order.front();
+        m_trade_ids.erase(oldest.first);
+        if (!m_orders.count(oldest.second)) m_fills.erase(oldest.second);
+        m_trade_order.pop_front();
+    }
+}
+
+void OrderCache::apply_trade_locked(const json& trade) {
+    Fill fill;
+    fill.trade_id = trade.at("trade_id").get<std::string>();
+    fill.price = trade.value("price", 0.0);
+    fill.amount = trade.value("amount", 0.0);
+    fill.fee = trade.value("fee", 0.0);
+    fill.timestamp = trade.value("timestamp", uint64_t(0));
+    store_fill_locked(trade.at("order_id").get<std::string>(), std::move(fill));
+}
+
+void OrderCache::store_fill_locked(const std::string& order_id, Fill fill) {
+    if (!m_trade_ids.insert(fill.trade_id).second) return;
+    m_trade_order.emplace_back(fill.trade_id, order_id);
+    m_fills[order_id].push_back(std::move(fill));
+    evict_locked();
+}
+
+// Every change to an open order goes through here, out and back in, so the
+// open listener sees the amount an order added taken off again unchanged.
+void OrderCache::index_open(const Order& order, bool open) {
+    double remaining = std::max(0.0, order.amount - order.filled_amount);
+    if (open) {
+        bool added = m_open_by_instrument[order.instrument_name].insert(order.order_id).second;
+        if (added && m_open_listener) m_open_listener(order.instrument_name, order.direction == "buy", remaining);
+        return;
+    }
+    auto it = m_open_by_instrument.find(order.instrument_name);
+    if (it == m_open_by_instrument.end()) return;
+    bool removed = it->second.erase(order.order_id) > 0;
+    if (it->second.empty()) m_open_by_instrument.erase(it);
+    if (removed && m_open_listener) m_open_listener(order.instrument_name, order.direction == "buy", -remaining);
+}
+
+void OrderCache::set_open_listener(OpenListener listener) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_open_listener = std::move(listener);
+    if (!m_open_listener) return;
+    for (const auto& entry : m_open_by_instrument) {
+        for (const auto& id : entry.second) {
+            const Order& order = m_orders.at(id);
+            m_open_listener(order.instrument_name, order.direction == "buy", std::max(0.0, order.amount - order.filled_amount));
+        }
+    }
+}
+
+OrderCache::Order OrderCache::with_fills(const Order& order) const {
+    Order copy = order;
+    auto fills = m_fills.find(order.order_id);
+    if (fills != m_fills.end()) copy.fills = fills->second;
+    return copy;
+}
+
+std::optional<OrderCache::Order> OrderCache::find(const std::string& order_id) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_orders.find(order_id);
+    if (it == m_orders.end()) return std::nullopt;
+    return with_fills(it->second);
+}
+
+std::vector<OrderCache::Order> OrderCache::by_label(const std::string& label) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    std::vector<Order> orders;
+    auto ids = m_by_label.find(label);
+    if (ids == m_by_label.end()) return orders;
+    for (const auto& id : ids->second) orders.push_back(with_fills(m_orders.at(id)));
+    return orders;
+}
+
+std::vector<OrderCache::Order> OrderCache::open_orders(const std::string& instrument_name) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    std::vector<Order> orders;
+    for (const auto& entry : m_open_by_instrument) {
+        if (!instrument_name.empty() && entry.first != instrument_name) continue;
+        for (const auto& id : entry.second) orders.push_back(with_fills(m_orders.at(id)));
+    }
+    return orders;
+}
+
+double OrderCache::open_amount(const std::string& instrument_name, bool buy) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_open_by_instrument.find(instrument_name);
+    if (it == m_open_by_instrument.end()) return 0.0;
+    double amount = 0.0;
+    for (const auto& id : it->second) {
+        const Order& order = m_orders.at(id);
+        if ((order.direction == "buy") == buy) amount += std::max(0.0, order.amount - order.filled_amount);
+    }
+    return amount;
+}
+
+std::vector<OrderCache::Fill> OrderCache::fills(const std::string& order_id) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_fills.find(order_id);
+    return it == m_fills.end() ? std::vector<Fill>() : it->second;
+}
+
+size_t OrderCache::size() const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_orders.size();
+}
+
+OrderCache::Reconciliation OrderCache::reconcile(const json& open_orders, const std::string& currency) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    Reconciliation report;
+
+    std::unordered_set<std::string> remote;
+    for (const auto& order : open_orders) {
+        Order incoming = parse_order(order);
+        remote.insert(incoming.order_id);
+
+        auto it = m_orders.find(incoming.order_id);
+        if (it == m_orders.end() || !it->second.is_open()) {
+            report.missing.push_back(incoming.order_id);
+        } else if (it->second.amount != incoming.amount || it->second.filled_amount != incoming.filled_amount ||
+                   it->second.price != incoming.price) {
+            report.mismatched.push_back(incoming.order_id);
+        } else {
+            continue;
+        }
+        if (it != m_orders.end()) erase_locked(it);
+        apply_order_locked(order);
+    }
+
+    // Closed on the exchange while we were not listening; the final state is
+    // unknown, so the order is dropped rather than guessed.
+    std::vector<std::string> stale;
+    for (const auto& entry : m_open_by_instrument) {
+        if (settlement_currency(entry.first) != currency) continue;
+        for (const auto& id : entry.second) {
+            if (!remote.count(id)) stale.push_back(id);
+        }
+    }
+    for (const auto& id : stale) {
+        erase_locked(m_orders.find(id));
+        m_fills.erase(id);
+        report.stale.push_back(id);
+    }
+    return report;
+}
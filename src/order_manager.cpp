@@ -2,135 +2,269 @@
 #include "deribit_client.hpp"
 #include "logger.hpp"
 #include "performance_tracker.hpp"
+#include "order_cache.hpp"
+#include "thread_pool.hpp"
+#include "thread_affinity.hpp"
+#include "risk_gate.hpp"
+#include "position_cache.hpp"
+#include "config.h"
 #include <nlohmann/json.hpp>
 #include <cpr/cpr.h>
+#include <cstdlib>
 
 using json = nlohmann::json;
 using response = cpr::Response;
 
-OrderManager::OrderManager(DeribitClient client) : client(client) {
+OrderManager::OrderManager(DeribitClient& client)
+    : client(client), m_pool(new ThreadPool(ORDER_WORKERS, ORDER_QUEUE_CAPACITY, []() {
+          ThreadAffinity::instance().pin_current_thread(ThreadAffinity::ORDER);
+      })) {
     this->logger = Logger();
 }
 
 OrderManager::~OrderManager() {}
 
 std::string OrderManager::view_current_positions(const std::string& currency, const std::string& kind) {
-    //logger.log(Logger::LogLevel::INFO, "Viewing current positions");
+    if (m_position_cache && m_position_cache->seeded(currency)) {
+        return m_position_cache->positions(currency, kind).dump(4);
+    }
     try {
-        //PerformanceTracker tracker("view_current_positions");
-        response r = client.get_positions(currency, kind);
-        //tracker.stop();
-
-        json j = json::parse(r.text);
-        if (j.contains("error")){
-            //logger.log(Logger::LogLevel::WARNING, j["error"]["message"]);
-            return j["error"].dump();
-        } else {
-            //logger.log(Logger::LogLevel::SUCCESS, "Positions retrieved successfully");
-            return j["result"].dump(4);
-        }
+        return rpc::render(positions(currency, kind));
     } catch (const std::exception& e) {
-        //logger.log(Logger::LogLevel::ERROR, e.what());
         return "";
     }
 }
 
 std::string OrderManager::get_orderbook(const std::string& instrument_name) {
-    //logger.log(Logger::LogLevel::INFO, "Getting orderbook");
     try {
-        //PerformanceTracker tracker("get_orderbook");
-        response r = client.get_order_book(instrument_name);
-        //tracker.stop();
-        
-        json j = json::parse(r.text);
-        if (j.contains("error")){
-            //logger.log(Logger::LogLevel::WARNING, j["error"]["message"]);
-            return j["error"].dump();
-        }
-        //logger.log(Logger::LogLevel::SUCCESS, "Orderbook retrieved successfully");
-        return j["result"].dump(4);
+        return rpc::render(order_book(instrument_name));
     } catch (const std::exception& e) {
-        //logger.log(Logger::LogLevel::ERROR, e.what());
+        return "";
     }
-    return "";
+}
+
+std::optional<rpc::Error> OrderManager::risk_check(InstrumentId instrument, const std::string& side, const std::string& quantity, const std::string& price, RiskGate::Hold& hold, double replaces) {
+    if (!m_risk_gate) return std::nullopt;
+    // Non-numeric prices (market orders) parse as 0
+    double amount = std::strtod(quantity.c_str(), nullptr);
+    double limit_price = std::strtod(price.c_str(), nullptr);
+    RiskGate::Result result = m_risk_gate->reserve(instrument, side == "buy", amount, limit_price, hold, replaces);
+    if (result == RiskGate::PASS) return std::nullopt;
+    rpc::Error error;
+    error.message = "risk_rejected";
+    error.data = json{{"reason", RiskGate::reason(result)}}.dump();
+    return error;
 }
 
 std::string OrderManager::place_order(const std::string& symbol, const std::string& side, const std::string& type, const std::string& quantity, const std::string& price) {
-    if (side == "buy") {
-            //logger.log(Logger::LogLevel::INFO, "Placing buy order");
-        try {
-            //PerformanceTracker tracker("place_order: buy");
-            response r = client.place_buy_order(symbol, side, type, quantity, price);
-            //tracker.stop();
-
-            json j = json::parse(r.text);
-            if (j.contains("error")){
-                //logger.log(Logger::LogLevel::WARNING, j["error"]["message"]);
-                return j["error"].dump();
-            }
-            //logger.log(Logger::LogLevel::SUCCESS, "Order placed successfully");
-            return j["result"].dump(4);
-        } catch (const std::exception& e) {
-            //logger.log(Logger::LogLevel::ERROR, e.what());
-        }
-            return "";
-    } else {
-        //logger.log(Logger::LogLevel::INFO, "Placing sell order");
-        try {
-            //PerformanceTracker tracker("place_order: sell");
-            response r = client.place_sell_order(symbol, side, type, quantity, price);
-            //tracker.stop();
-
-            json j = json::parse(r.text);
-            if (j.contains("error")){
-                //logger.log(Logger::LogLevel::WARNING, j["error"]["message"]);
-                return j["error"].dump();
-            }
-            //logger.log(Logger::LogLevel::SUCCESS, "Order placed successfully");
-            return j["result"].dump(4);
-        } catch (const std::exception& e) {
-            //logger.log(Logger::LogLevel::ERROR, e.what());
-        }
+    try {
+        return rpc::render(place(OrderRequest{symbol, side, type, quantity, price}));
+    } catch (const std::exception& e) {
         return "";
     }
 }
 
 std::string OrderManager::cancel_order(const std::string& order_id) {
-    //logger.log(Logger::LogLevel::INFO, "Cancelling order");
     try {
-        //PerformanceTracker tracker("cancel_order");
-        response r = client.cancel_order(order_id);
-        //tracker.stop();
-
-        json j = json::parse(r.text);
-        if (j.contains("error")){
-            //logger.log(Logger::LogLevel::WARNING, j["error"]["message"]);
-            return j["error"].dump();
-        }
-        //logger.log(Logger::LogLevel::SUCCESS, "Order cancelled successfully");
-        return j["result"].dump(4);
+        return rpc::render(cancel(order_id));
     } catch (const std::exception& e) {
-        //logger.log(Logger::LogLevel::ERROR, e.what());
-    }
         return "";
+    }
 }
 
 std::string OrderManager::modify_order(const std::string& order_id, const std::string& quantity, const std::string& price) {
-    //logger.log(Logger::LogLevel::INFO, "Modifying order");
     try {
-        //PerformanceTracker tracker("modify_order");
-        response r = client.edit_order(order_id, quantity, price);
-        //tracker.stop();
-
-        json j = json::parse(r.text);
-        if (j.contains("error")){
-            //logger.log(Logger::LogLevel::WARNING, j["error"]["message"]);
-            return j["error"].dump();
+        return rpc::render(modify(order_id, quantity, price));
+    } catch (const std::exception& e) {
+        return "";
+    }
+}
+
+rpc::Result<rpc::OrderAck> OrderManager::place(const OrderRequest& order) {
+    // Released on return, once the acknowledgement is in the order cache
+    RiskGate::Hold hold;
+    InstrumentId instrument = order.instrument;
+    if (m_risk_gate && instrument == kNoInstrument) instrument = InstrumentRegistry::instance().intern(order.symbol);
+    if (auto rejected = risk_check(instrument, order.side, order.quantity, order.type == "market" ? "0" : order.price, hold)) {
+        rpc::Result<rpc::OrderAck> result;
+        result.error = *rejected;
+        return result;
+    }
+    bool buy = order.side == "buy";
+    PerformanceTracker tracker(buy ? PERF_SITE("place_order: buy") : PERF_SITE("place_order: sell"));
+    response r = buy
+        ? client.place_buy_order(order.symbol, order.side, order.type, order.quantity, order.price, order.label)
+        : client.place_sell_order(order.symbol, order.side, order.type, order.quantity, order.price, order.label);
+    tracker.stop();
+
+    rpc::Result<rpc::OrderAck> result = rpc::decode_order_ack(r.text);
+    if (result.ok() && m_order_cache) m_order_cache->apply_ack(*result.value);
+    result.body = std::move(r.text);
+    return result;
+}
+
+rpc::Result<rpc::Order> OrderManager::cancel(const std::string& order_id) {
+    PerformanceTracker tracker(PERF_SITE("cancel_order"));
+    response r = client.cancel_order(order_id);
+    tracker.stop();
+
+    rpc::Result<rpc::Order> result = rpc::decode_order(r.text);
+    if (result.ok() && m_order_cache) m_order_cache->apply_order(*result.value);
+    result.body = std::move(r.text);
+    return result;
+}
+
+rpc::Result<rpc::OrderAck> OrderManager::modify(const std::string& order_id, const std::string& quantity, const std::string& price) {
+    // The instrument and side come from the order cache; unknown orders go
+    // to the exchange unchecked. The order's current open amount is replaced.
+    RiskGate::Hold hold;
+    if (m_risk_gate && m_order_cache) {
+        if (auto order = m_order_cache->find(order_id)) {
+            double open = order->is_open() ? order->amount - order->filled_amount : 0.0;
+            InstrumentId instrument = InstrumentRegistry::instance().intern(order->instrument_name);
+            if (auto rejected = risk_check(instrument, order->direction, quantity, price, hold, open)) {
+                rpc::Result<rpc::OrderAck> result;
+                result.error = *rejected;
+                return result;
+            }
+        }
+    }
+    PerformanceTracker tracker(PERF_SITE("modify_order"));
+    response r = client.edit_order(order_id, quantity, price);
+    tracker.stop();
+
+    rpc::Result<rpc::OrderAck> result = rpc::decode_order_ack(r.text);
+    if (result.ok() && m_order_cache) m_order_cache->apply_ack(*result.value);
+    result.body = std::move(r.text);
+    return result;
+}
+
+rpc::Result<std::vector<rpc::Position>> OrderManager::positions(const std::string& currency, const std::string& kind) {
+    PerformanceTracker tracker(PERF_SITE("view_current_positions"));
+    response r = client.get_positions(currency, kind);
+    tracker.stop();
+    rpc::Result<std::vector<rpc::Position>> result = rpc::decode_positions(r.text);
+    result.body = std::move(r.text);
+    return result;
+}
+
+rpc::Result<rpc::BookSnapshot> OrderManager::order_book(const std::string& instrument_name) {
+    PerformanceTracker tracker(PERF_SITE("get_orderbook"));
+    response r = client.get_order_book(instrument_name);
+    tracker.stop();
+    rpc::Result<rpc::BookSnapshot> result = rpc::decode_book(r.text);
+    result.body = std::move(r.text);
+    return result;
+}
+
+std::string OrderManager::view_open_orders(const std::string& instrument_name) {
+    if (!m_order_cache) return "";
+    json orders = json::array();
+    for (const auto& order : m_order_cache->open_orders(instrument_name == "any" ? "" : instrument_name)) {
+        orders.push_back(OrderCache::to_json(order));
+    }
+    return orders.dump(4);
+}
+
+json OrderManager::submit_order(const OrderRequest& order) {
+    json entry = {{"instrument_name", order.symbol}, {"label", order.label}};
+    try {
+        rpc::Result<rpc::OrderAck> result = place(order);
+        entry["ok"] = result.ok();
+        json raw = result.body.empty() ? json() : rpc::raw_member(result.body, result.ok() ? "result" : "error");
+        if (!raw.is_null()) entry[result.ok() ? "result" : "error"] = raw;
+        else if (result.ok()) entry["result"] = rpc::to_json(*result.value);
+        else entry["error"] = rpc::to_json(result.error);
+    } catch (const std::exception& e) {
+        entry["ok"] = false;
+        entry["error"] = {{"message", e.what()}};
+    }
+    return entry;
+}
+
+std::string OrderManager::place_orders(const std::vector<OrderRequest>& orders) {
+    PerformanceTracker tracker(PERF_SITE("place_orders"));
+    json results = json::array();
+    if (m_pool->on_worker_thread()) {
+        // Waiting on our own pool from a worker could deadlock once the queue
+        // is full, so a batch placed from a callback runs here, in order
+        for (const auto& order : orders) results.push_back(submit_order(order));
+    } else {
+        std::vector<std::future<json>> pending;
+        pending.reserve(orders.size());
+        for (const auto& order : orders) {
+            pending.push_back(m_pool->submit([this, order]() { return submit_order(order); }));
         }
-        //logger.log(Logger::LogLevel::SUCCESS, "Order modified successfully");
-        return j["result"].dump(4);
+        for (auto& entry : pending) results.push_back(entry.get());
+    }
+
+    size_t placed = 0;
+    for (const auto& entry : results) {
+        if (entry["ok"].get<bool>()) ++placed;
+    }
+    tracker.stop();
+
+    json summary = {
+        {"placed", placed},
+        {"failed", orders.size() - placed},
+        {"orders", results}
+    };
+    return summary.dump(4);
+}
+
+std::string OrderManager::mass_cancel_result(response r) {
+    try {
+        rpc::Result<uint64_t> result = rpc::decode_count(r.text);
+        result.body = std::move(r.text);
+        return rpc::render(result);
     } catch (const std::exception& e) {
-        //logger.log(Logger::LogLevel::ERROR, e.what());
     }
-        return "";
+    return "";
+}
+
+std::string OrderManager::cancel_all() {
+    PerformanceTracker tracker(PERF_SITE("cancel_all"));
+    return mass_cancel_result(client.cancel_all());
+}
+
+std::string OrderManager::cancel_by_instrument(const std::string& instrument_name) {
+    PerformanceTracker tracker(PERF_SITE("cancel_by_instrument"));
+    return mass_cancel_result(client.cancel_all_by_instrument(instrument_name));
+}
+
+std::string OrderManager::cancel_by_label(const std::string& label) {
+    PerformanceTracker tracker(PERF_SITE("cancel_by_label"));
+    return mass_cancel_result(client.cancel_by_label(label));
+}
+
+std::future<std::string> OrderManager::place_order_async(const std::string& symbol, const std::string& side, const std::string& type, const std::string& quantity, const std::string& price) {
+    return m_pool->submit([=]() { return place_order(symbol, side, type, quantity, price); });
+}
+
+std::future<std::string> OrderManager::cancel_order_async(const std::string& order_id) {
+    return m_pool->submit([=]() { return cancel_order(order_id); });
+}
+
+std::future<std::string> OrderManager::modify_order_async(const std::string& order_id, const std::string& quantity, const std::string& price) {
+    return m_pool->submit([=]() { return modify_order(order_id, quantity, price); });
+}
+
+// Nobody waits on the future of a callback call, so whatever the callback
+// throws is logged here instead of being lost with it
+void OrderManager::complete(const Completion& on_done, const std::string& result) {
+    try {
+        on_done(result);
+    } catch (const std::exception& e) {
+        logger.log(Logger::LogLevel::ERROR, "Order completion callback failed: " + std::string(e.what()));
+    } catch (...) {
+        logger.log(Logger::LogLevel::ERROR, "Order completion callback failed");
+    }
+}
+
+void OrderManager::place_order_async(const std::string& symbol, const std::string& side, const std::string& type, const std::string& quantity, const std::string& price, Completion on_done) {
+    m_pool->submit([=]() { complete(on_done, place_order(symbol, side, type, quantity, price)); });
+}
+
+void OrderManager::cancel_order_async(const std::string& order_id, Completion on_done) {
+    m_pool->submit([=]() { complete(on_done, cancel_order(order_id)); });
 }
@@ -0,0 +1,171 @@
+#include "performance_tracker.hpp"
+
+#if DERIBIT_SCOPED_TIMERS
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "metrics.hpp"
+#include "spsc_queue.hpp"
+
+namespace perf {
+namespace {
+
+struct Sample {
+    uint32_t site = 0;
+    uint64_t ticks = 0;
+};
+
+struct ThreadBuffer {
+    SpscQueue<Sample> samples{4096};
+    std::atomic<uint64_t> dropped{0};
+};
+
+uint64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Owns the site table and the per-thread buffers. Only registration and
+// draining take the lock; submit() touches nothing but its own buffer. Once
+// the first buffer is attached a background thread drains every
+// kDrainInterval, so the rings neither fill up nor outlive their threads
+// when nothing scrapes the metrics.
+class Aggregator {
+public:
+    static constexpr std::chrono::milliseconds kDrainInterval{100};
+
+    static Aggregator& instance() {
+        static Aggregator aggregator;
+        return aggregator;
+    }
+
+    ~Aggregator() {
+        {
+            std::lock_guard<std::mutex> lock(m_drainer_mutex);
+            m_stopping = true;
+        }
+        m_drainer_wake.notify_one();
+        if (m_drainer.joinable()) m_drainer.join();
+    }
+
+    uint32_t register_site(const char* name) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sites.push_back(&MetricsRegistry::instance().histogram(
+            "deribit_scope_seconds", "Scoped timer durations by call site", MetricsRegistry::label("site", name)));
+        return static_cast<uint32_t>(m_sites.size() - 1);
+    }
+
+    void attach(std::shared_ptr<ThreadBuffer> buffer) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.push_back(std::move(buffer));
+        if (!m_drainer.joinable()) m_drainer = std::thread([this]() { drain_loop(); });
+    }
+
+    uint64_t drain() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        double ns_per_tick = calibrate();
+        uint64_t drained = 0;
+        Sample sample;
+        for (auto it = m_buffers.begin(); it != m_buffers.end();) {
+            ThreadBuffer& buffer = **it;
+            while (buffer.samples.try_pop(sample)) {
+                if (sample.site < m_sites.size()) {
+                    m_sites[sample.site]->record(static_cast<uint64_t>(sample.ticks * ns_per_tick));
+                }
+                ++drained;
+            }
+            m_dropped += buffer.dropped.exchange(0, std::memory_order_relaxed);
+            // The owning thread has exited once we hold the last reference.
+            if (it->use_count() == 1 && buffer.samples.empty()) {
+                it = m_buffers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return drained;
+    }
+
+    uint64_t dropped() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t total = m_dropped;
+        for (const auto& buffer : m_buffers) total += buffer->dropped.load(std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    // The registry is constructed first so that it outlives the drainer
+    Aggregator() : m_base_ticks(ticks()), m_base_ns(steady_ns()) { MetricsRegistry::instance(); }
+
+    void drain_loop() {
+        std::unique_lock<std::mutex> lock(m_drainer_mutex);
+        while (!m_drainer_wake.wait_for(lock, kDrainInterval, [this]() { return m_stopping; })) {
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+    // Tick rate measured over the whole process lifetime, so it only gets
+    // more precise. Assumes an invariant TSC, as on any recent x86.
+    double calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+        if (steady_ns() - m_base_ns < 1000000) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        uint64_t elapsed_ticks = ticks() - m_base_ticks;
+        uint64_t elapsed_ns = steady_ns() - m_base_ns;
+        return elapsed_ticks ? static_cast<double>(elapsed_ns) / elapsed_ticks : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+
+    std::mutex m_mutex;
+    std::vector<LatencyHistogram*> m_sites;
+    std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+    uint64_t m_dropped = 0;
+    uint64_t m_base_ticks;
+    uint64_t m_base_ns;
+    std::mutex m_drainer_mutex;
+    std::condition_variable m_drainer_wake;
+    bool m_stopping = false;
+    std::thread m_drainer;
+};
+
+// The raw pointer is constant-initialised, so the fast path is a plain TLS
+// load; the owning shared_ptr is only touched on a thread's first sample.
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+ThreadBuffer& thread_buffer() {
+    if (t_buffer) return *t_buffer;
+    thread_local std::shared_ptr<ThreadBuffer> owner = std::make_shared<ThreadBuffer>();
+    Aggregator::instance().attach(owner);
+    t_buffer = owner.get();
+    return *t_buffer;
+}
+
+}
+
+TimerSite::TimerSite(const char* name) : m_name(name), m_id(Aggregator::instance().register_site(name)) {}
+
+void submit(uint32_t site, uint64_t elapsed_ticks) {
+    ThreadBuffer& buffer = thread_buffer();
+    if (!buffer.samples.try_push(Sample{site, elapsed_ticks})) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint64_t drain() {
+    return Aggregator::instance().drain();
+}
+
+uint64_t dropped() {
+    return Aggregator::instance().dropped();
+}
+
+}
+
+#endif
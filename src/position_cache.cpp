@@ -0,0 +1,191 @@
+#include "position_cache.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+
+using json = nlohmann::json;
+
+static bool starts_with(const std::string& value, const std::string& prefix) {
+    return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+static uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static std::string upper(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::toupper(c); });
+    return value;
+}
+
+// BTC-PERPETUAL settles in BTC, BTC_USDC-PERPETUAL in USDC
+static std::string settlement_currency(const std::string& instrument) {
+    std::string base = instrument.substr(0, instrument.find('-'));
+    size_t underscore = base.find('_');
+    return underscore == std::string::npos ? base : base.substr(underscore + 1);
+}
+
+PositionCache::PositionCache(size_t capacity) : m_capacity(capacity), m_entries(new Entry[capacity]) {}
+
+PositionCache::Entry* PositionCache::find(const std::string& instrument) const {
+    size_t count = m_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        if (m_entries[i].instrument == instrument) return &m_entries[i];
+    }
+    return nullptr;
+}
+
+PositionCache::Entry* PositionCache::find_or_add(const std::string& instrument, const std::string& kind) {
+    if (Entry* existing = find(instrument)) return existing;
+    size_t count = m_count.load(std::memory_order_relaxed);
+    if (count == m_capacity) return nullptr;
+
+    Entry& entry = m_entries[count];
+    entry.instrument = instrument;
+    entry.kind = kind;
+    entry.currency = settlement_currency(instrument);
+    entry.inverse = kind == "future" && instrument.find('_') == std::string::npos;
+    m_count.store(count + 1, std::memory_order_release);
+    if (m_on_instrument) m_on_instrument(instrument);
+    return &entry;
+}
+
+const PositionCache::Account* PositionCache::find_account(const std::string& currency) const {
+    size_t count = m_account_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        if (m_accounts[i].currency == currency) return &m_accounts[i];
+    }
+    return nullptr;
+}
+
+PositionCache::Account* PositionCache::account(const std::string& currency) {
+    if (const Account* existing = find_account(currency)) return const_cast<Account*>(existing);
+    size_t count = m_account_count.load(std::memory_order_relaxed);
+    if (count == kMaxCurrencies) return nullptr;
+    m_accounts[count].currency = currency;
+    m_account_count.store(count + 1, std::memory_order_release);
+    return &m_accounts[count];
+}
+
+void PositionCache::seed(const std::string& currency, const json& positions) {
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+    for (const auto& position : positions) apply_position_locked(position);
+    if (Account* a = account(upper(currency))) a->seeded.store(true, std::memory_order_release);
+}
+
+bool PositionCache::seeded(const std::string& currency) const {
+    const Account* a = find_account(upper(currency));
+    return a && a->seeded.load(std::memory_order_acquire);
+}
+
+void PositionCache::apply_position(const json& position) {
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+    apply_position_locked(position);
+}
+
+void PositionCache::apply_position_locked(const json& position) {
+    Entry* entry = find_or_add(position.at("instrument_name").get<std::string>(), position.value("kind", ""));
+    if (!entry) return;
+
+    Position state;
+    state.size = position.value("size", 0.0);
+    state.average_price = position.value("average_price", 0.0);
+    state.mark_price = position.value("mark_price", 0.0);
+    state.floating_pnl = position.value("floating_profit_loss", 0.0);
+    state.realized_pnl = position.value("realized_profit_loss", 0.0);
+    state.updated_ms = now_ms();
+    state.reported_mark = state.mark_price;
+    state.reported_floating_pnl = state.floating_pnl;
+    entry->state.store(state);
+}
+
+void PositionCache::apply_portfolio(const json& portfolio) {
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+    Account* a = account(upper(portfolio.at("currency").get<std::string>()));
+    if (!a) return;
+
+    Portfolio state;
+    state.equity = portfolio.value("equity", 0.0);
+    state.balance = portfolio.value("balance", 0.0);
+    state.margin_balance = portfolio.value("margin_balance", 0.0);
+    state.initial_margin = portfolio.value("initial_margin", 0.0);
+    state.maintenance_margin = portfolio.value("maintenance_margin", 0.0);
+    state.available_funds = portfolio.value("available_funds", 0.0);
+    state.total_pl = portfolio.value("total_pl", 0.0);
+    state.session_upl = portfolio.value("session_upl", 0.0);
+    state.updated_ms = now_ms();
+    a->state.store(state);
+}
+
+void PositionCache::on_mark_price(const std::string& instrument, double mark_price) {
+    Entry* entry = find(instrument);
+    if (!entry || mark_price <= 0) return;
+
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+    Position state = entry->state.load();
+    if (state.mark_price == mark_price) return;
+
+    double base_mark = state.reported_mark > 0 ? state.reported_mark : state.average_price;
+    double base_pnl = state.reported_mark > 0 ? state.reported_floating_pnl : 0.0;
+    if (base_mark <= 0) return;
+    double delta = entry->inverse ? state.size * (1.0 / base_mark - 1.0 / mark_price)
+                                  : state.size * (mark_price - base_mark);
+    state.mark_price = mark_price;
+    state.floating_pnl = base_pnl + delta;
+    state.updated_ms = now_ms();
+    entry->state.store(state);
+}
+
+void PositionCache::on_channel(const std::string& channel, const json& data) {
+    if (starts_with(channel, "ticker.")) {
+        on_mark_price(data.at("instrument_name").get<std::string>(), data.value("mark_price", 0.0));
+    } else if (starts_with(channel, "markprice.options.")) {
+        for (const auto& mark : data) on_mark_price(mark.at("instrument_name").get<std::string>(), mark.value("mark_price", 0.0));
+    } else if (starts_with(channel, "user.changes.")) {
+        if (!data.contains("positions")) return;
+        for (const auto& position : data["positions"]) apply_position(position);
+    } else if (starts_with(channel, "user.portfolio.")) {
+        apply_portfolio(data);
+    }
+}
+
+bool PositionCache::position(const std::string& instrument, Position& out) const {
+    const Entry* entry = find(instrument);
+    if (!entry) return false;
+    out = entry->state.load();
+    return true;
+}
+
+json PositionCache::positions(const std::string& currency, const std::string& kind) const {
+    std::string wanted = upper(currency);
+    json result = json::array();
+    size_t count = m_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        const Entry& entry = m_entries[i];
+        if (!wanted.empty() && entry.currency != wanted) continue;
+        if (kind != "any" && entry.kind != kind) continue;
+        Position state = entry.state.load();
+        if (state.size == 0) continue;
+        result.push_back({
+            {"instrument_name", entry.instrument},
+            {"kind", entry.kind},
+            {"direction", state.size > 0 ? "buy" : "sell"},
+            {"size", state.size},
+            {"average_price", state.average_price},
+            {"mark_price", state.mark_price},
+            {"floating_profit_loss", state.floating_pnl},
+            {"realized_profit_loss", state.realized_pnl},
+            {"total_profit_loss", state.floating_pnl + state.realized_pnl},
+            {"updated_ms", state.updated_ms}
+        });
+    }
+    return result;
+}
+
+bool PositionCache::portfolio(const std::string& currency, Portfolio& out) const {
+    const Account* a = find_account(upper(currency));
+    if (!a) return false;
+    out = a->state.load();
+    return true;
+}
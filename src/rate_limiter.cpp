@@ -0,0 +1,103 @@
+#include "rate_limiter.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+static const char* lane_names[] = {"cancel", "order", "query"};
+
+static bool starts_with(const std::string& value, const std::string& prefix) {
+    return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Written so that NaN fails too
+bool RateLimiter::valid(const Limit& limit) {
+    if (!(limit.per_second >= 0)) return false;
+    return limit.per_second == 0 || limit.burst >= 1;
+}
+
+RateLimiter::RateLimiter(const Limit& matching, const Limit& non_matching) {
+    auto now = Clock::now();
+    const Limit* limits[] = {&matching, &non_matching};
+    for (int i = 0; i < 2; ++i) {
+        if (!valid(*limits[i])) {
+            throw std::invalid_argument("Invalid rate limit: burst " + std::to_string(limits[i]->burst) +
+                                        ", per_second " + std::to_string(limits[i]->per_second));
+        }
+        m_buckets[i].limit = *limits[i];
+        m_buckets[i].tokens = limits[i]->burst;
+        m_buckets[i].updated = now;
+    }
+
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    for (int lane = 0; lane < 3; ++lane) {
+        std::string labels = MetricsRegistry::label("lane", lane_names[lane]);
+        m_queued[lane] = &metrics.gauge("deribit_rate_limit_queued", "Requests waiting for rate-limit credit", labels);
+        m_wait[lane] = &metrics.histogram("deribit_rate_limit_wait_seconds", "Time spent waiting for rate-limit credit", labels);
+    }
+    m_rejects = &metrics.counter("deribit_rate_limit_rejects_total", "Requests rejected by the exchange for rate limits");
+}
+
+RateLimiter::Pool RateLimiter::pool_of(const std::string& method) {
+    if (method == "private/buy" || method == "private/sell" || method == "private/edit" ||
+        starts_with(method, "private/cancel")) {
+        return MATCHING;
+    }
+    return NON_MATCHING;
+}
+
+RateLimiter::Lane RateLimiter::lane_of(const std::string& method) {
+    // Auth shares the cancel lane so a token refresh never waits behind queries.
+    if (starts_with(method, "private/cancel") || method == "public/auth") return CANCEL;
+    if (method == "private/buy" || method == "private/sell" || method == "private/edit") return ORDER;
+    return QUERY;
+}
+
+void RateLimiter::refill(Bucket& bucket, Clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - bucket.updated).count();
+    bucket.tokens = std::min(bucket.limit.burst, bucket.tokens + elapsed * bucket.limit.per_second);
+    bucket.updated = now;
+}
+
+void RateLimiter::acquire(Pool pool, Lane lane) {
+    Bucket& bucket = m_buckets[pool];
+    if (bucket.limit.per_second <= 0) return;
+
+    auto start = Clock::now();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t ticket = bucket.next_ticket++;
+    bucket.waiting[lane].push_back(ticket);
+    m_queued[lane]->add();
+
+    for (;;) {
+        auto now = Clock::now();
+        refill(bucket, now);
+        const std::deque<uint64_t>* head = bucket.waiting;
+        while (head->empty()) ++head;
+        bool my_turn = head->front() == ticket;
+
+        if (my_turn && bucket.tokens >= 1.0) {
+            bucket.tokens -= 1.0;
+            bucket.waiting[lane].pop_front();
+            break;
+        }
+        if (my_turn) {
+            double seconds = (1.0 - bucket.tokens) / bucket.limit.per_second;
+            bucket.ready.wait_until(lock, now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds)));
+        } else {
+            bucket.ready.wait(lock);
+        }
+    }
+    lock.unlock();
+    bucket.ready.notify_all();
+
+    m_queued[lane]->sub();
+    m_wait[lane]->record(Clock::now() - start);
+}
+
+void RateLimiter::on_rejected(Pool pool) {
+    m_rejects->inc();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Bucket& bucket = m_buckets[pool];
+    bucket.tokens = 0;
+    bucket.updated = Clock::now();
+}
@@ -0,0 +1,205 @@
+#include "risk_gate.hpp"
+#include "metrics.hpp"
+#include "order_cache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+using json = nlohmann::json;
+
+static bool starts_with(const std::string& value, const std::string& prefix) {
+    return value.compare(0, prefix.size(), prefix) == 0;
+}
+
+static void add(std::atomic<double>& value, double delta) {
+    double current = value.load(std::memory_order_relaxed);
+    while (!value.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+    }
+}
+
+static RiskGate::Limits parse_limits(const json& config, RiskGate::Limits limits) {
+    limits.max_order_amount = config.value("max_order_amount", limits.max_order_amount);
+    limits.max_notional = config.value("max_notional", limits.max_notional);
+    limits.max_position = config.value("max_position", limits.max_position);
+    limits.price_collar = config.value("price_collar", limits.price_collar);
+    return limits;
+}
+
+RiskGate::RiskGate(const Limits& defaults, size_t capacity)
+    : m_defaults(defaults), m_capacity(capacity), m_entries(new Entry[capacity]),
+      m_by_id(new std::atomic<Entry*>[InstrumentRegistry::kCapacity]) {
+    for (size_t i = 0; i < InstrumentRegistry::kCapacity; ++i) m_by_id[i].store(nullptr, std::memory_order_relaxed);
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    for (int result = ORDER_SIZE; result <= TOO_MANY_INSTRUMENTS; ++result) {
+        m_rejects[result] = &metrics.counter("deribit_risk_rejects_total", "Orders stopped by the pre-trade risk gate",
+                                             MetricsRegistry::label("reason", reason(static_cast<Result>(result))));
+    }
+}
+
+RiskGate::~RiskGate() {
+    set_order_cache(nullptr);
+}
+
+void RiskGate::set_order_cache(OrderCache* cache) {
+    if (m_order_cache) m_order_cache->set_open_listener(nullptr);
+    m_order_cache = cache;
+    if (!cache) return;
+    cache->set_open_listener([this](const std::string& instrument, bool buy, double delta) {
+        if (Entry* e = entry(instrument)) add(buy ? e->open_buy : e->open_sell, delta);
+    });
+}
+
+std::unique_ptr<RiskGate> RiskGate::from_json(const json& config) {
+    Limits defaults = parse_limits(config.value("default", json::object()), Limits());
+    std::unique_ptr<RiskGate> gate(new RiskGate(defaults, config.value("capacity", size_t(1024))));
+    if (config.contains("instruments")) {
+        for (const auto& instrument : config["instruments"].items()) {
+            gate->set_limits(instrument.key(), parse_limits(instrument.value(), defaults));
+        }
+    }
+    return gate;
+}
+
+RiskGate::Entry* RiskGate::entry(const std::string& instrument) {
+    return entry(InstrumentRegistry::instance().intern(instrument));
+}
+
+RiskGate::Entry* RiskGate::entry(InstrumentId id) {
+    if (id >= InstrumentRegistry::kCapacity) return nullptr;
+    Entry* existing = m_by_id[id].load(std::memory_order_acquire);
+    if (existing) return existing;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    existing = m_by_id[id].load(std::memory_order_relaxed);
+    if (existing) return existing;
+    if (m_size == m_capacity) return nullptr;
+
+    Entry* created = &m_entries[m_size++];
+    created->limits = m_defaults;
+    m_by_id[id].store(created, std::memory_order_release);
+    return created;
+}
+
+void RiskGate::set_limits(const std::string& instrument, const Limits& limits) {
+    if (Entry* e = entry(instrument)) e->limits = limits;
+}
+
+RiskGate::Result RiskGate::reject(Result result) {
+    m_rejects[result]->inc();
+    return result;
+}
+
+RiskGate::Result RiskGate::check(const std::string& instrument, bool buy, double amount, double price) {
+    return check(InstrumentRegistry::instance().intern(instrument), buy, amount, price);
+}
+
+RiskGate::Result RiskGate::check(InstrumentId instrument, bool buy, double amount, double price) {
+    return evaluate(instrument, buy, amount, price, 0, false);
+}
+
+RiskGate::Result RiskGate::reserve(InstrumentId instrument, bool buy, double amount, double price, Hold& hold, double replaces) {
+    Result result = evaluate(instrument, buy, amount, price, replaces, true);
+    if (result == PASS) {
+        hold.gate = this;
+        hold.instrument = instrument;
+        hold.buy = buy;
+        hold.amount = amount;
+    }
+    return result;
+}
+
+void RiskGate::release(InstrumentId instrument, bool buy, double amount) {
+    Entry* e = entry(instrument);
+    if (!e) return;
+    std::atomic<double>& in_flight = buy ? e->in_flight_buy : e->in_flight_sell;
+    double current = in_flight.load(std::memory_order_relaxed);
+    while (!in_flight.compare_exchange_weak(current, std::max(0.0, current - amount), std::memory_order_relaxed)) {
+    }
+}
+
+RiskGate::Result RiskGate::evaluate(InstrumentId instrument, bool buy, double amount, double price, double replaces, bool hold) {
+    Entry* e = entry(instrument);
+    if (!e) return reject(TOO_MANY_INSTRUMENTS);
+    const Limits& limits = e->limits;
+
+    if (limits.max_order_amount > 0 && amount > limits.max_order_amount) return reject(ORDER_SIZE);
+
+    // Buys are collared against the ask, sells against the bid
+    double reference = (buy ? e->best_ask : e->best_bid).load(std::memory_order_relaxed);
+    if (price <= 0) {
+        if (reference <= 0 && limits.max_notional > 0) return reject(NO_REFERENCE_PRICE);
+        price = reference;
+    } else if (limits.price_collar > 0 && reference > 0) {
+        double band = reference * limits.price_collar;
+        if (buy ? price > reference + band : price < reference - band) return reject(PRICE_COLLAR);
+    }
+
+    if (limits.max_notional > 0 && amount * price > limits.max_notional) return reject(NOTIONAL);
+
+    // Checked last, so the in-flight amount is only taken by an order that
+    // passes, and with a compare-exchange so concurrent orders see each other
+    double open = std::max(0.0, (buy ? e->open_buy : e->open_sell).load(std::memory_order_relaxed) - replaces);
+    std::atomic<double>& in_flight = buy ? e->in_flight_buy : e->in_flight_sell;
+    double held = in_flight.load(std::memory_order_relaxed);
+    for (;;) {
+        double working = open + held + amount;
+        double position = e->position.load(std::memory_order_relaxed) + (buy ? working : -working);
+        if (limits.max_position > 0 && std::fabs(position) > limits.max_position) return reject(POSITION);
+        if (!hold || in_flight.compare_exchange_weak(held, held + amount, std::memory_order_relaxed)) return PASS;
+    }
+}
+
+void RiskGate::update_bbo(const std::string& instrument, double bid, double ask) {
+    update_bbo(InstrumentRegistry::instance().intern(instrument), bid, ask);
+}
+
+void RiskGate::update_bbo(InstrumentId instrument, double bid, double ask) {
+    if (Entry* e = entry(instrument)) {
+        e->best_bid.store(bid, std::memory_order_relaxed);
+        e->best_ask.store(ask, std::memory_order_relaxed);
+    }
+}
+
+void RiskGate::on_fill(const std::string& instrument, double signed_amount) {
+    if (Entry* e = entry(instrument)) add(e->position, signed_amount);
+}
+
+void RiskGate::set_position(const std::string& instrument, double size) {
+    if (Entry* e = entry(instrument)) e->position.store(size, std::memory_order_relaxed);
+}
+
+double RiskGate::position(const std::string& instrument) {
+    Entry* e = entry(instrument);
+    return e ? e->position.load(std::memory_order_relaxed) : 0.0;
+}
+
+void RiskGate::on_channel(const std::string& channel, const json& data) {
+    if (starts_with(channel, "quote.")) {
+        update_bbo(data.at("instrument_name").get<std::string>(),
+                   data.value("best_bid_price", 0.0), data.value("best_ask_price", 0.0));
+        return;
+    }
+    if (!starts_with(channel, "user.trades.")) return;
+    auto apply = [this](const json& trade) {
+        double amount = trade.value("amount", 0.0);
+        on_fill(trade.at("instrument_name").get<std::string>(), trade.value("direction", "") == "buy" ? amount : -amount);
+    };
+    if (data.is_array()) {
+        for (const auto& trade : data) apply(trade);
+    } else {
+        apply(data);
+    }
+}
+
+const char* RiskGate::reason(Result result) {
+    switch (result) {
+        case PASS: return "pass";
+        case ORDER_SIZE: return "max_order_amount";
+        case NOTIONAL: return "max_notional";
+        case POSITION: return "max_position";
+        case PRICE_COLLAR: return "price_collar";
+        case NO_REFERENCE_PRICE: return "no_reference_price";
+        case TOO_MANY_INSTRUMENTS: return "too_many_instruments";
+    }
+    return "unknown";
+}
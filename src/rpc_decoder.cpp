@@ -0,0 +1,325 @@
+#include "rpc_decoder.hpp"
+#include <simdjson.h>
+#include <stdexcept>
+
+using json = nlohmann::json;
+namespace od = simdjson::ondemand;
+
+namespace rpc {
+namespace {
+
+// One parser per thread; it keeps its buffers from call to call
+od::parser& parser() {
+    static thread_local od::parser instance;
+    return instance;
+}
+
+od::document iterate(std::string& body) {
+    if (body.capacity() < body.size() + simdjson::SIMDJSON_PADDING) {
+        body.reserve(body.size() + simdjson::SIMDJSON_PADDING);
+    }
+    return parser().iterate(simdjson::padded_string_view(body));
+}
+
+// Unset fields come as null, and market orders have "market_price" as price
+double number(od::value value) {
+    return value.type() == od::json_type::number ? double(value.get_double()) : 0.0;
+}
+
+uint64_t integer(od::value value) {
+    return value.type() == od::json_type::number ? uint64_t(value.get_uint64()) : 0;
+}
+
+std::string text(od::value value) {
+    if (value.type() != od::json_type::string) return std::string();
+    return std::string(std::string_view(value.get_string()));
+}
+
+bool boolean(od::value value, bool absent) {
+    return value.type() == od::json_type::boolean ? bool(value.get_bool()) : absent;
+}
+
+Error decode_error(od::value value) {
+    Error error;
+    for (od::field field : value.get_object()) {
+        std::string_view key = field.unescaped_key();
+        if (key == "code") error.code = int64_t(field.value().get_int64());
+        else if (key == "message") error.message = text(field.value());
+        else if (key == "data") error.data = std::string(std::string_view(field.value().raw_json()));
+    }
+    return error;
+}
+
+// Reads the JSON-RPC envelope; the result goes through decode_result
+template<typename T, typename Decode>
+Result<T> decode(std::string& body, Decode decode_result) {
+    Result<T> result;
+    bool answered = false;
+    od::document document = iterate(body);
+    for (od::field field : document.get_object()) {
+        std::string_view key = field.unescaped_key();
+        if (key == "result") {
+            result.value = decode_result(field.value());
+            answered = true;
+        } else if (key == "error") {
+            result.error = decode_error(field.value());
+            answered = true;
+        }
+    }
+    if (!answered) throw std::runtime_error("Response has neither result nor error");
+    return result;
+}
+
+Order decode_order_fields(od::value value) {
+    Order order;
+    for (od::field field : value.get_object()) {
+        std::string_view key = field.unescaped_key();
+        if (key == "order_id") order.order_id = text(field.value());
+        else if (key == "label") order.label = text(field.value());
+        else if (key == "instrument_name") order.instrument_name = text(field.value());
+        else if (key == "direction") order.direction = text(field.value());
+        else if (key == "order_type") order.order_type = text(field.value());
+        else if (key == "order_state") order.order_state = text(field.value());
+        else if (key == "price") order.price = number(field.value());
+        else if (key == "amount") order.amount = number(field.value());
+        else if (key == "filled_amount") order.filled_amount = number(field.value());
+        else if (key == "average_price") order.average_price = number(field.value());
+        else if (key == "creation_timestamp") order.creation_timestamp = integer(field.value());
+        else if (key == "last_update_timestamp") order.last_update_timestamp = integer(field.value());
+    }
+    if (order.order_id.empty()) throw std::runtime_error("Order without order_id");
+    return order;
+}
+
+Trade decode_trade(od::value value) {
+    Trade trade;
+    for (od::field field : value.get_object()) {
+        std::string_view key = field.unescaped_key();
+        if (key == "trade_id") trade.trade_id = text(field.value());
+        else if (key == "order_id") trade.order_id = text(field.value());
+        else if (key == "instrument_name") trade.instrument_name = text(field.value());
+        else if (key == "direction") trade.direction = text(field.value());
+        else if (key == "price") trade.price = number(field.value());
+        else if (key == "amount") trade.amount = number(field.value());
+        else if (key == "fee") trade.fee = number(field.value());
+        else if (key == "timestamp") trade.timestamp = integer(field.value());
+    }
+    return trade;
+}
+
+OrderAck decode_ack(od::value value) {
+    OrderAck ack;
+    for (od::field field : value.get_object()) {
+        std::string_view key = field.unescaped_key();
+        if (key == "order") {
+            ack.order = decode_order_fields(field.value());
+        } else if (key == "trades") {
+            for (od::value trade : field.value().get_array()) ack.trades.push_back(decode_trade(trade));
+        }
+    }
+    return ack;
+}
+
+Position decode_position(od::value value) {
+    Position position;
+    for (od::field field : value.get_object()) {
+        std::string_view key = field.unescaped_key();
+        if (key == "instrument_name") position.instrument_name = text(field.value());
+        else if (key == "kind") position.kind = text(field.value());
+        else if (key == "direction") position.direction = text(field.value());
+        else if (key == "size") position.size = number(field.value());
+        else if (key == "average_price") position.average_price = number(field.value());
+        else if (key == "mark_price") position.mark_price = number(field.value());
+        else if (key == "index_price") position.index_price = number(field.value());
+        else if (key == "floating_profit_loss") position.floating_profit_loss = number(field.value());
+        else if (key == "realized_profit_loss") position.realized_profit_loss = number(field.value());
+        else if (key == "total_profit_loss") position.total_profit_loss = number(field.value());
+        else if (key == "delta") position.delta = number(field.value());
+        else if (key == "initial_margin") position.initial_margin = number(field.value());
+        else if (key == "maintenance_margin") position.maintenance_margin = number(field.value());
+        else if (key == "estimated_liquidation_price") position.estimated_liquidation_price = number(field.value());
+        else if (key == "leverage") position.leverage = number(field.value());
+    }
+    return position;
+}
+
+// [[price, amount], ...]
+void decode_levels(od::value value, std::vector<OrderBook::Level>& levels) {
+    for (od::value entry : value.get_array()) {
+        OrderBook::Level level{0.0, 0.0};
+        size_t index = 0;
+        for (od::value element : entry.get_array()) {
+            if (index == 0) level.price = double(element.get_double());
+            else if (index == 1) level.amount = double(element.get_double());
+            ++index;
+        }
+        levels.push_back(level);
+    }
+}
+
+BookSnapshot decode_book_fields(od::value value) {
+    BookSnapshot book;
+    for (od::field field : value.get_object()) {
+        std::string_view key = field.unescaped_key();
+        if (key == "instrument_name") book.instrument_name = text(field.value());
+        else if (key == "state") book.state = text(field.value());
+        else if (key == "change_id") book.change_id = integer(field.value());
+        else if (key == "timestamp") book.timestamp = integer(field.value());
+        else if (key == "best_bid_price") book.best_bid_price = number(field.value());
+        else if (key == "best_bid_amount") book.best_bid_amount = number(field.value());
+        else if (key == "best_ask_price") book.best_ask_price = number(field.value());
+        else if (key == "best_ask_amount") book.best_ask_amount = number(field.value());
+        else if (key == "mark_price") book.mark_price = number(field.value());
+        else if (key == "index_price") book.index_price = number(field.value());
+        else if (key == "last_price") book.last_price = number(field.value());
+        else if (key == "open_interest") book.open_interest = number(field.value());
+        else if (key == "bids") decode_levels(field.value(), book.bids);
+        else if (key == "asks") decode_levels(field.value(), book.asks);
+    }
+    return book;
+}
+
+Instrument decode_instrument(od::value value) {
+    Instrument instrument;
+    instrument.is_active = true;
+    for (od::field field : value.get_object()) {
+        std::string_view key = field.unescaped_key();
+        if (key == "instrument_name") instrument.name = text(field.value());
+        else if (key == "kind") instrument.kind = text(field.value());
+        else if (key == "base_currency") instrument.base_currency = text(field.value());
+        else if (key == "quote_currency") instrument.quote_currency = text(field.value());
+        else if (key == "settlement_currency") instrument.settlement_currency = text(field.value());
+        else if (key == "option_type") instrument.option_type = text(field.value());
+        else if (key == "tick_size") instrument.tick_size = number(field.value());
+        else if (key == "contract_size") instrument.contract_size = number(field.value());
+        else if (key == "min_trade_amount") instrument.min_trade_amount = number(field.value());
+        else if (key == "strike") instrument.strike = number(field.value());
+        else if (key == "creation_timestamp") instrument.creation_timestamp = integer(field.value());
+        else if (key == "expiration_timestamp") instrument.expiration_timestamp = integer(field.value());
+        else if (key == "is_active") instrument.is_active = boolean(field.value(), true);
+    }
+    if (instrument.name.empty()) throw std::runtime_error("Instrument without instrument_name");
+    return instrument;
+}
+
+template<typename T, typename Decode>
+std::vector<T> decode_array(od::value value, Decode decode_entry) {
+    std::vector<T> entries;
+    for (od::value entry : value.get_array()) entries.push_back(decode_entry(entry));
+    return entries;
+}
+
+}
+
+Result<OrderAck> decode_order_ack(std::string& body) {
+    return decode<OrderAck>(body, decode_ack);
+}
+
+Result<Order> decode_order(std::string& body) {
+    return decode<Order>(body, decode_order_fields);
+}
+
+Result<std::vector<Position>> decode_positions(std::string& body) {
+    return decode<std::vector<Position>>(body, [](od::value value) {
+        return decode_array<Position>(value, decode_position);
+    });
+}
+
+Result<BookSnapshot> decode_book(std::string& body) {
+    return decode<BookSnapshot>(body, decode_book_fields);
+}
+
+Result<std::vector<Instrument>> decode_instruments(std::string& body) {
+    return decode<std::vector<Instrument>>(body, [](od::value value) {
+        return decode_array<Instrument>(value, decode_instrument);
+    });
+}
+
+Result<uint64_t> decode_count(std::string& body) {
+    return decode<uint64_t>(body, [](od::value value) { return uint64_t(value.get_uint64()); });
+}
+
+json raw_member(const std::string& body, const char* member) {
+    json parsed = json::parse(body, nullptr, false);
+    if (!parsed.is_object() || !parsed.contains(member)) return json();
+    return parsed[member];
+}
+
+json to_json(const Error& error) {
+    json out = {{"message", error.message}};
+    if (error.code != 0) out["code"] = error.code;
+    if (!error.data.empty()) out["data"] = json::parse(error.data);
+    return out;
+}
+
+json to_json(const Order& order) {
+    json out = OrderCache::to_json(order);
+    out.erase("fills");
+    return out;
+}
+
+json to_json(const Trade& trade) {
+    return {
+        {"trade_id", trade.trade_id},
+        {"order_id", trade.order_id},
+        {"instrument_name", trade.instrument_name},
+        {"direction", trade.direction},
+        {"price", trade.price},
+        {"amount", trade.amount},
+        {"fee", trade.fee},
+        {"timestamp", trade.timestamp}
+    };
+}
+
+json to_json(const OrderAck& ack) {
+    return {
+        {"order", to_json(ack.order)},
+        {"trades", to_json(ack.trades)}
+    };
+}
+
+json to_json(const Position& position) {
+    return {
+        {"instrument_name", position.instrument_name},
+        {"kind", position.kind},
+        {"direction", position.direction},
+        {"size", position.size},
+        {"average_price", position.average_price},
+        {"mark_price", position.mark_price},
+        {"index_price", position.index_price},
+        {"floating_profit_loss", position.floating_profit_loss},
+        {"realized_profit_loss", position.realized_profit_loss},
+        {"total_profit_loss", position.total_profit_loss},
+        {"delta", position.delta},
+        {"initial_margin", position.initial_margin},
+        {"maintenance_margin", position.maintenance_margin},
+        {"estimated_liquidation_price", position.estimated_liquidation_price},
+        {"leverage", position.leverage}
+    };
+}
+
+json to_json(const BookSnapshot& book) {
+    auto levels = [](const std::vector<OrderBook::Level>& side) {
+        json out = json::array();
+        for (const auto& level : side) out.push_back({level.price, level.amount});
+        return out;
+    };
+    return {
+        {"instrument_name", book.instrument_name},
+        {"state", book.state},
+        {"change_id", book.change_id},
+        {"timestamp", book.timestamp},
+        {"best_bid_price", book.best_bid_price},
+        {"best_bid_amount", book.best_bid_amount},
+        {"best_ask_price", book.best_ask_price},
+        {"best_ask_amount", book.best_ask_amount},
+        {"mark_price", book.mark_price},
+        {"index_price", book.index_price},
+        {"last_price", book.last_price},
+        {"open_interest", book.open_interest},
+        {"bids", levels(book.bids)},
+        {"asks", levels(book.asks)}
+    };
+}
+
+}
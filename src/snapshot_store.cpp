@@ -0,0 +1,422 @@
+#include "snapshot_store.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using namespace snapshot_store;
+
+namespace {
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t depth;
+    uint32_t reserved;
+    double price_scale;
+    double amount_scale;
+};
+
+struct Trailer {
+    uint64_t footer_offset;
+    uint32_t magic;
+    uint32_t reserved;
+};
+
+constexpr size_t kSnapshotFixedColumns = 2;   // timestamp, change_id
+constexpr size_t kTradeColumns = 4;           // timestamp, price, amount, direction
+
+void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+const uint8_t* get_varint(const uint8_t* in, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = *in++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return in;
+    }
+    throw std::runtime_error("Corrupt column encoding");
+}
+
+uint64_t zigzag(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+int64_t unzigzag(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+template<typename T>
+void put(std::vector<uint8_t>& out, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+T get(const char*& in, const char* end) {
+    if (in + sizeof(T) > end) throw std::runtime_error("Truncated store footer");
+    T value;
+    std::memcpy(&value, in, sizeof(T));
+    in += sizeof(T);
+    return value;
+}
+
+int64_t fixed(double value, double scale) {
+    return static_cast<int64_t>(std::llround(value * scale));
+}
+
+// Physical column of a requested field, or -1 if the kind has no such column.
+int column_index(Kind kind, const Column& column, uint32_t depth) {
+    if (kind == TRADE) {
+        switch (column.field) {
+            case TRADE_PRICE: return 1;
+            case TRADE_AMOUNT: return 2;
+            case TRADE_DIRECTION: return 3;
+            default: return -1;
+        }
+    }
+    if (column.field == CHANGE_ID) return 1;
+    if (column.field > ASK_AMOUNT || column.level >= depth) return -1;
+    return static_cast<int>(kSnapshotFixedColumns + column.level * 4 + column.field);
+}
+
+// Physical columns every block of a kind has, or 0 for an unknown kind.
+size_t column_count(uint8_t kind, uint32_t depth) {
+    if (kind == TRADE) return kTradeColumns;
+    if (kind == SNAPSHOT) return kSnapshotFixedColumns + size_t(depth) * 4;
+    return 0;
+}
+
+double column_scale(Field field, double price_scale, double amount_scale) {
+    switch (field) {
+        case BID_PRICE: case ASK_PRICE: case TRADE_PRICE: return price_scale;
+        case BID_AMOUNT: case ASK_AMOUNT: case TRADE_AMOUNT: return amount_scale;
+        default: return 1.0;
+    }
+}
+
+std::vector<std::pair<uint64_t, std::string>> list_files(const std::string& directory) {
+    std::vector<std::pair<uint64_t, std::string>> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        unsigned long long index = 0;
+        char tail = 0;
+        std::string name = entry.path().filename().string();
+        if (entry.is_regular_file() && std::sscanf(name.c_str(), "store-%llu.dc%c", &index, &tail) == 2 && tail == 's') {
+            files.emplace_back(index, entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+}
+
+SnapshotStoreWriter::SnapshotStoreWriter(const Options& options) : m_options(options) {
+    if (m_options.depth == 0 || m_options.block_rows == 0) throw std::invalid_argument("Snapshot store needs depth and block_rows");
+
+    fs::create_directories(m_options.directory);
+    auto existing = list_files(m_options.directory);
+    uint64_t index = existing.empty() ? 0 : existing.back().first + 1;
+    char name[32];
+    std::snprintf(name, sizeof(name), "store-%06llu.dcs", static_cast<unsigned long long>(index));
+    m_path = (fs::path(m_options.directory) / name).string();
+
+    m_file = std::fopen(m_path.c_str(), "wbx");
+    if (!m_file) throw std::runtime_error("Cannot create snapshot store file " + m_path);
+
+    FileHeader header{kMagic, kVersion, m_options.depth, 0, m_options.price_scale, m_options.amount_scale};
+    write(&header, sizeof(header));
+}
+
+SnapshotStoreWriter::~SnapshotStoreWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+    }
+}
+
+uint32_t SnapshotStoreWriter::instrument_id(const std::string& name) {
+    auto it = m_instrument_ids.find(name);
+    if (it != m_instrument_ids.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(m_instruments.size());
+    m_instruments.push_back(name);
+    m_instrument_ids.emplace(name, id);
+    return id;
+}
+
+SnapshotStoreWriter::Block& SnapshotStoreWriter::open_block(uint32_t instrument, Kind kind, size_t columns) {
+    Block& block = m_open[{instrument, static_cast<uint8_t>(kind)}];
+    if (block.columns.empty()) {
+        block.instrument = instrument;
+        block.kind = kind;
+        block.columns.resize(columns);
+        for (auto& column : block.columns) column.reserve(m_options.block_rows);
+    }
+    return block;
+}
+
+void SnapshotStoreWriter::add_snapshot(const OrderBook& book) {
+    if (!m_file) throw std::logic_error("Snapshot store already closed");
+
+    Block& block = open_block(instrument_id(book.instrument_name()), SNAPSHOT,
+                              kSnapshotFixedColumns + m_options.depth * 4);
+    block.columns[0].push_back(static_cast<int64_t>(book.timestamp()));
+    block.columns[1].push_back(static_cast<int64_t>(book.change_id()));
+    // Missing levels are stored as zero price and amount.
+    for (uint32_t level = 0; level < m_options.depth; ++level) {
+        size_t base = kSnapshotFixedColumns + level * 4;
+        const OrderBook::Level* bid = level < book.bids().size() ? &book.bids()[level] : nullptr;
+        const OrderBook::Level* ask = level < book.asks().size() ? &book.asks()[level] : nullptr;
+        block.columns[base + BID_PRICE].push_back(bid ? fixed(bid->price, m_options.price_scale) : 0);
+        block.columns[base + BID_AMOUNT].push_back(bid ? fixed(bid->amount, m_options.amount_scale) : 0);
+        block.columns[base + ASK_PRICE].push_back(ask ? fixed(ask->price, m_options.price_scale) : 0);
+        block.columns[base + ASK_AMOUNT].push_back(ask ? fixed(ask->amount, m_options.amount_scale) : 0);
+    }
+    ++m_rows;
+    if (block.rows() >= m_options.block_rows) flush_block(block);
+}
+
+void SnapshotStoreWriter::add_trade(const std::string& instrument, uint64_t timestamp_ms, double price, double amount, bool buy) {
+    if (!m_file) throw std::logic_error("Snapshot store already closed");
+
+    Block& block = open_block(instrument_id(instrument), TRADE, kTradeColumns);
+    block.columns[0].push_back(static_cast<int64_t>(timestamp_ms));
+    block.columns[1].push_back(fixed(price, m_options.price_scale));
+    block.columns[2].push_back(fixed(amount, m_options.amount_scale));
+    block.columns[3].push_back(buy ? 1 : 0);
+    ++m_rows;
+    if (block.rows() >= m_options.block_rows) flush_block(block);
+}
+
+void SnapshotStoreWriter::flush_block(Block& block) {
+    if (block.rows() == 0) return;
+
+    IndexEntry entry;
+    entry.instrument = block.instrument;
+    entry.kind = block.kind;
+    entry.rows = static_cast<uint32_t>(block.rows());
+    entry.first_ms = static_cast<uint64_t>(*std::min_element(block.columns[0].begin(), block.columns[0].end()));
+    entry.last_ms = static_cast<uint64_t>(*std::max_element(block.columns[0].begin(), block.columns[0].end()));
+
+    std::vector<uint8_t> encoded;
+    for (auto& column : block.columns) {
+        encoded.clear();
+        int64_t previous = 0;
+        for (int64_t value : column) {
+            put_varint(encoded, zigzag(value - previous));
+            previous = value;
+        }
+        entry.columns.emplace_back(m_offset, encoded.size());
+        write(encoded.data(), encoded.size());
+        column.clear();
+    }
+    m_index.push_back(std::move(entry));
+}
+
+void SnapshotStoreWriter::write(const void* data, size_t size) {
+    if (size && std::fwrite(data, 1, size, m_file) != size) {
+        throw std::runtime_error("Write to snapshot store " + m_path + " failed");
+    }
+    m_offset += size;
+}
+
+void SnapshotStoreWriter::close() {
+    if (!m_file) return;
+    for (auto& open : m_open) flush_block(open.second);
+    m_open.clear();
+
+    std::vector<uint8_t> footer;
+    put<uint32_t>(footer, static_cast<uint32_t>(m_instruments.size()));
+    for (const auto& name : m_instruments) {
+        put<uint32_t>(footer, static_cast<uint32_t>(name.size()));
+        footer.insert(footer.end(), name.begin(), name.end());
+    }
+    put<uint32_t>(footer, static_cast<uint32_t>(m_index.size()));
+    for (const auto& entry : m_index) {
+        put<uint32_t>(footer, entry.instrument);
+        put<uint8_t>(footer, entry.kind);
+        put<uint32_t>(footer, entry.rows);
+        put<uint64_t>(footer, entry.first_ms);
+        put<uint64_t>(footer, entry.last_ms);
+        put<uint32_t>(footer, static_cast<uint32_t>(entry.columns.size()));
+        for (const auto& column : entry.columns) {
+            put<uint64_t>(footer, column.first);
+            put<uint64_t>(footer, column.second);
+        }
+    }
+    Trailer trailer{m_offset, kMagic, 0};
+    write(footer.data(), footer.size());
+    write(&trailer, sizeof(trailer));
+
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+SnapshotStore::SnapshotStore(const std::string& directory) {
+    for (const auto& file : list_files(directory)) open_file(file.second);
+}
+
+SnapshotStore::~SnapshotStore() {
+    for (auto& file : m_files) ::munmap(const_cast<char*>(file.map), file.size);
+}
+
+// Maps the whole file but reads only the header and footer here; column
+// pages are faulted in by the queries that need them.
+void SnapshotStore::open_file(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader) + sizeof(Trailer)) {
+        ::close(fd);
+        return;
+    }
+    void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return;
+    ::madvise(map, st.st_size, MADV_RANDOM);
+
+    File file;
+    file.map = static_cast<const char*>(map);
+    file.size = st.st_size;
+    const char* end = file.map + file.size;
+
+    FileHeader header;
+    Trailer trailer;
+    std::memcpy(&header, file.map, sizeof(header));
+    std::memcpy(&trailer, end - sizeof(trailer), sizeof(trailer));
+    // A writer that never reached close() leaves no trailer; skip the file.
+    if (header.magic != kMagic || header.version != kVersion || trailer.magic != kMagic ||
+        trailer.footer_offset > file.size - sizeof(trailer)) {
+        ::munmap(map, st.st_size);
+        return;
+    }
+    file.depth = header.depth;
+    file.price_scale = header.price_scale;
+    file.amount_scale = header.amount_scale;
+
+    try {
+        const char* in = file.map + trailer.footer_offset;
+        const char* footer_end = end - sizeof(trailer);
+        // Counts are checked against the bytes left before anything is sized by them
+        uint32_t instruments = get<uint32_t>(in, footer_end);
+        if (instruments > static_cast<size_t>(footer_end - in) / sizeof(uint32_t)) throw std::runtime_error("Truncated store footer");
+        std::vector<std::string> names(instruments);
+        for (auto& name : names) {
+            uint32_t length = get<uint32_t>(in, footer_end);
+            if (in + length > footer_end) throw std::runtime_error("Truncated store footer");
+            name.assign(in, length);
+            in += length;
+        }
+        uint32_t blocks = get<uint32_t>(in, footer_end);
+        for (uint32_t i = 0; i < blocks; ++i) {
+            uint32_t instrument = get<uint32_t>(in, footer_end);
+            BlockRef block;
+            block.kind = get<uint8_t>(in, footer_end);
+            block.rows = get<uint32_t>(in, footer_end);
+            block.first_ms = get<uint64_t>(in, footer_end);
+            block.last_ms = get<uint64_t>(in, footer_end);
+            // Queries index columns by their position for the kind and depth,
+            // and decode `rows` varints of at least one byte from each
+            uint32_t columns = get<uint32_t>(in, footer_end);
+            if (columns == 0 || columns != column_count(block.kind, file.depth)) {
+                throw std::runtime_error("Unexpected column count in store index");
+            }
+            for (uint32_t c = 0; c < columns; ++c) {
+                uint64_t offset = get<uint64_t>(in, footer_end);
+                uint64_t length = get<uint64_t>(in, footer_end);
+                if (offset > trailer.footer_offset || length > trailer.footer_offset - offset) {
+                    throw std::runtime_error("Column outside data section");
+                }
+                if (length < block.rows) throw std::runtime_error("Column shorter than its rows");
+                block.columns.emplace_back(offset, length);
+            }
+            if (instrument >= names.size()) throw std::runtime_error("Unknown instrument in store index");
+            file.blocks[names[instrument]].push_back(std::move(block));
+        }
+    } catch (const std::exception&) {
+        ::munmap(map, st.st_size);
+        return;
+    }
+    m_files.push_back(std::move(file));
+}
+
+std::vector<std::string> SnapshotStore::instruments() const {
+    std::vector<std::string> names;
+    for (const auto& file : m_files) {
+        for (const auto& entry : file.blocks) names.push_back(entry.first);
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+SnapshotStore::Result SnapshotStore::query_snapshots(const std::string& instrument, uint64_t from_ms, uint64_t to_ms,
+                                                     const std::vector<Column>& columns) const {
+    return query(instrument, SNAPSHOT, from_ms, to_ms, columns);
+}
+
+SnapshotStore::Result SnapshotStore::query_trades(const std::string& instrument, uint64_t from_ms, uint64_t to_ms,
+                                                  const std::vector<Column>& columns) const {
+    return query(instrument, TRADE, from_ms, to_ms, columns);
+}
+
+SnapshotStore::Result SnapshotStore::query(const std::string& instrument, Kind kind, uint64_t from_ms, uint64_t to_ms,
+                                           const std::vector<Column>& columns) const {
+    Result result;
+    result.columns.resize(columns.size());
+
+    std::vector<int64_t> timestamps, values;
+    auto decode = [this](const File& file, const std::pair<uint64_t, uint64_t>& range, uint32_t rows, std::vector<int64_t>& out) {
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(file.map + range.first);
+        const uint8_t* end = in + range.second;
+        out.resize(rows);
+        int64_t value = 0;
+        for (uint32_t row = 0; row < rows; ++row) {
+            uint64_t raw;
+            in = get_varint(in, end, raw);
+            value += unzigzag(raw);
+            out[row] = value;
+        }
+        m_bytes_scanned += range.second;
+    };
+
+    for (const auto& file : m_files) {
+        auto blocks = file.blocks.find(instrument);
+        if (blocks == file.blocks.end()) continue;
+
+        std::vector<int> physical;
+        for (const auto& column : columns) {
+            int index = column_index(kind, column, file.depth);
+            if (index < 0) throw std::invalid_argument("Column not stored for this record kind");
+            physical.push_back(index);
+        }
+
+        for (const auto& block : blocks->second) {
+            if (block.kind != kind || block.last_ms < from_ms || block.first_ms > to_ms) continue;
+
+            decode(file, block.columns[0], block.rows, timestamps);
+            std::vector<uint32_t> selected;
+            for (uint32_t row = 0; row < block.rows; ++row) {
+                uint64_t ts = static_cast<uint64_t>(timestamps[row]);
+                if (ts >= from_ms && ts <= to_ms) selected.push_back(row);
+            }
+            if (selected.empty()) continue;
+
+            for (uint32_t row : selected) result.timestamps.push_back(static_cast<uint64_t>(timestamps[row]));
+            for (size_t c = 0; c < columns.size(); ++c) {
+                decode(file, block.columns[physical[c]], block.rows, values);
+                double scale = column_scale(columns[c].field, file.price_scale, file.amount_scale);
+                for (uint32_t row : selected) result.columns[c].push_back(values[row] / scale);
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,82 @@
+#include "thread_affinity.hpp"
+#include <cctype>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+
+ThreadAffinity& ThreadAffinity::instance() {
+    static ThreadAffinity affinity;
+    return affinity;
+}
+
+// A CPU number below CPU_SETSIZE, or -1
+static int parse_cpu(const std::string& text) {
+    if (text.empty() || text.size() > 5) return -1;
+    int cpu = 0;
+    for (char c : text) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) return -1;
+        cpu = cpu * 10 + (c - '0');
+    }
+    return cpu < CPU_SETSIZE ? cpu : -1;
+}
+
+bool ThreadAffinity::parse_cpu_list(const std::string& list, std::vector<int>& cpus) {
+    cpus.clear();
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (item.empty()) continue;
+        size_t dash = item.find('-');
+        int first = parse_cpu(item.substr(0, dash));
+        int last = dash == std::string::npos ? first : parse_cpu(item.substr(dash + 1));
+        if (first < 0 || last < first) {
+            cpus.clear();
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return true;
+}
+
+void ThreadAffinity::set_cpus(Role role, const std::vector<int>& cpus) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cpus[role] = cpus;
+    m_next[role] = 0;
+}
+
+int ThreadAffinity::pin_current_thread(Role role) {
+    int cpu;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_cpus[role].empty()) return -1;
+        cpu = m_cpus[role][m_next[role]++ % m_cpus[role].size()];
+    }
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        logger.log(Logger::LogLevel::WARNING, std::string("Not pinning ") + role_name(role) + " thread: CPU " +
+                   std::to_string(cpu) + " is out of range");
+        return -1;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error != 0) {
+        logger.log(Logger::LogLevel::WARNING, std::string("Could not pin ") + role_name(role) + " thread to CPU " +
+                   std::to_string(cpu) + ": error " + std::to_string(error));
+        return -1;
+    }
+    pthread_setname_np(pthread_self(), role_name(role));
+    logger.log(Logger::LogLevel::INFO, std::string("Pinned ") + role_name(role) + " thread to CPU " + std::to_string(cpu));
+    return cpu;
+}
+
+const char* ThreadAffinity::role_name(Role role) {
+    switch (role) {
+        case FEED: return "deribit-feed";
+        case FANOUT: return "deribit-fanout";
+        case ORDER: return "deribit-order";
+        case SERVER: return "deribit-server";
+        default: return "deribit";
+    }
+}
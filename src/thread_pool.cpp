@@ -0,0 +1,62 @@
+#include "thread_pool.hpp"
+#include <stdexcept>
+
+// The pool whose worker is running on this thread, if any
+static thread_local const ThreadPool* t_current_pool = nullptr;
+
+ThreadPool::ThreadPool(size_t workers, size_t queue_capacity, std::function<void()> thread_init)
+    : m_capacity(queue_capacity ? queue_capacity : 1) {
+    if (workers == 0) workers = 1;
+    m_workers.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        m_workers.emplace_back([this, thread_init]() {
+            t_current_pool = this;
+            if (thread_init) thread_init();
+            run();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+    for (auto& worker : m_workers) worker.join();
+}
+
+bool ThreadPool::on_worker_thread() const {
+    return t_current_pool == this;
+}
+
+size_t ThreadPool::queued() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tasks.size();
+}
+
+void ThreadPool::post(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this]() { return m_tasks.size() < m_capacity || m_stopping; });
+        if (m_stopping) throw std::runtime_error("ThreadPool is stopping");
+        m_tasks.push_back(std::move(task));
+    }
+    m_not_empty.notify_one();
+}
+
+void ThreadPool::run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_empty.wait(lock, [this]() { return !m_tasks.empty() || m_stopping; });
+            if (m_tasks.empty()) return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        m_not_full.notify_one();
+        task();
+    }
+}
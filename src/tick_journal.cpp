@@ -0,0 +1,298 @@
+#include "tick_journal.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static std::string segment_name(uint64_t index) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "journal-%06llu.dtj", static_cast<unsigned long long>(index));
+    return name;
+}
+
+static bool parse_segment_name(const std::string& name, uint64_t& index) {
+    unsigned long long parsed = 0;
+    char tail = 0;
+    if (std::sscanf(name.c_str(), "journal-%llu.dt%c", &parsed, &tail) != 2 || tail != 'j') return false;
+    index = parsed;
+    return true;
+}
+
+static std::vector<std::pair<uint64_t, std::string>> list_segments(const std::string& directory) {
+    std::vector<std::pair<uint64_t, std::string>> segments;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        uint64_t index;
+        if (entry.is_regular_file() && parse_segment_name(entry.path().filename().string(), index)) {
+            segments.emplace_back(index, entry.path().string());
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+// Frames are JSON-RPC text; subscription data carries "channel":"<name>".
+static std::string_view find_channel(const std::string& payload) {
+    static const char kKey[] = "\"channel\":\"";
+    size_t start = payload.find(kKey);
+    if (start == std::string::npos) return {};
+    start += sizeof(kKey) - 1;
+    size_t end = payload.find('"', start);
+    if (end == std::string::npos) return {};
+    return std::string_view(payload).substr(start, end - start);
+}
+
+TickJournal::TickJournal(const Options& options)
+    : m_options(options), m_queue(options.queue_capacity) {
+    logger = Logger();
+}
+
+TickJournal::~TickJournal() {
+    stop();
+}
+
+uint64_t TickJournal::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void TickJournal::start() {
+    if (m_running) return;
+
+    fs::create_directories(m_options.directory);
+    auto existing = list_segments(m_options.directory);
+    m_next_index = existing.empty() ? 0 : existing.back().first + 1;
+    open_segment();
+
+    m_running = true;
+    m_writer = std::thread([this]() {
+        writer_loop();
+    });
+    logger.log(Logger::LogLevel::INFO, "Journaling upstream frames to " + m_options.directory);
+}
+
+void TickJournal::stop() {
+    if (!m_running) return;
+    m_running = false;
+    if (m_writer.joinable()) m_writer.join();
+    close_segment();
+}
+
+bool TickJournal::append(uint64_t received_ns, std::string&& payload) {
+    if (!m_queue.try_push(Entry{received_ns, std::move(payload)})) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void TickJournal::writer_loop() {
+    Entry entry;
+    unsigned idle = 0;
+    for (;;) {
+        if (m_queue.try_pop(entry)) {
+            idle = 0;
+            try {
+                write_frame(entry);
+            } catch (const std::exception& e) {
+                logger.log(Logger::LogLevel::ERROR, "Journal write failed: " + std::string(e.what()));
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+        if (!m_running) break;
+        // Spin briefly for bursts, then back off so an idle feed costs nothing.
+        if (++idle < 256) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+void TickJournal::write_frame(const Entry& entry) {
+    if (entry.payload.empty()) return;
+    if (!m_map) open_segment();
+    std::string_view channel = find_channel(entry.payload);
+    uint32_t id = channel.empty() ? 0 : channel_id(channel);
+
+    size_t needed = sizeof(journal::RecordHeader) + journal::padded(entry.payload.size());
+    if (id != 0 && !m_defined[id]) {
+        needed += sizeof(journal::RecordHeader) + journal::padded(channel.size());
+    }
+    // Leave room for the zero end marker.
+    if (m_offset + needed + sizeof(uint32_t) > m_options.segment_bytes) {
+        if (needed + sizeof(journal::SegmentHeader) + sizeof(uint32_t) > m_options.segment_bytes) {
+            throw std::runtime_error("frame larger than journal segment");
+        }
+        close_segment();
+        open_segment();
+    }
+
+    if (id != 0 && !m_defined[id]) {
+        write_record(journal::CHANNEL, id, entry.received_ns, channel);
+        m_defined[id] = true;
+    }
+    write_record(journal::FRAME, id, entry.received_ns, entry.payload);
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TickJournal::write_record(journal::RecordType type, uint32_t channel_id, uint64_t received_ns, std::string_view payload) {
+    journal::RecordHeader header{};
+    header.length = static_cast<uint32_t>(payload.size());
+    header.type = type;
+    header.channel_id = channel_id;
+    header.received_ns = received_ns;
+
+    // Payload first, header last, so a reader of a live segment never sees a
+    // non-zero length ahead of its payload.
+    char* record = m_map + m_offset;
+    std::memcpy(record + sizeof(header), payload.data(), payload.size());
+    std::memcpy(record + sizeof(uint32_t), reinterpret_cast<const char*>(&header) + sizeof(uint32_t),
+                sizeof(header) - sizeof(uint32_t));
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(record, &header.length, sizeof(uint32_t));
+
+    size_t written = sizeof(header) + journal::padded(payload.size());
+    m_offset += written;
+    m_bytes.fetch_add(written, std::memory_order_relaxed);
+}
+
+uint32_t TickJournal::channel_id(std::string_view channel) {
+    auto it = m_channel_ids.find(std::string(channel));
+    if (it != m_channel_ids.end()) return it->second;
+
+    if (m_channel_names.empty()) {
+        m_channel_names.emplace_back();
+        m_defined.push_back(false);
+    }
+    uint32_t id = static_cast<uint32_t>(m_channel_names.size());
+    m_channel_names.emplace_back(channel);
+    m_defined.push_back(false);
+    m_channel_ids.emplace(std::string(channel), id);
+    return id;
+}
+
+void TickJournal::open_segment() {
+    std::string path = (fs::path(m_options.directory) / segment_name(m_next_index)).string();
+    m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (m_fd < 0) throw std::runtime_error("Cannot create journal segment " + path + ": " + std::strerror(errno));
+
+    // Reserve the blocks up front so page faults never wait on the allocator.
+    int err = ::posix_fallocate(m_fd, 0, static_cast<off_t>(m_options.segment_bytes));
+    if (err != 0 && ::ftruncate(m_fd, static_cast<off_t>(m_options.segment_bytes)) != 0) {
+        ::close(m_fd);
+        throw std::runtime_error("Cannot size journal segment " + path);
+    }
+    void* map = ::mmap(nullptr, m_options.segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        ::close(m_fd);
+        throw std::runtime_error("Cannot map journal segment " + path + ": " + std::strerror(errno));
+    }
+    m_map = static_cast<char*>(map);
+    ::madvise(m_map, m_options.segment_bytes, MADV_SEQUENTIAL);
+
+    journal::SegmentHeader header{journal::kSegmentMagic, journal::kVersion, m_next_index, now_ns(), 0};
+    std::memcpy(m_map, &header, sizeof(header));
+    m_offset = sizeof(header);
+    std::fill(m_defined.begin(), m_defined.end(), false);
+    ++m_next_index;
+    m_segment_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TickJournal::close_segment() {
+    if (!m_map) return;
+    ::msync(m_map, m_offset, MS_ASYNC);
+    ::munmap(m_map, m_options.segment_bytes);
+    // Trim the unused tail, keeping the zero end marker.
+    if (::ftruncate(m_fd, static_cast<off_t>(m_offset + sizeof(uint32_t))) != 0) {
+        logger.log(Logger::LogLevel::WARNING, "Could not trim journal segment");
+    }
+    ::close(m_fd);
+    m_map = nullptr;
+    m_fd = -1;
+}
+
+TickJournalReader::TickJournalReader(const std::string& directory) {
+    for (auto& segment : list_segments(directory)) m_paths.push_back(segment.second);
+}
+
+TickJournalReader::~TickJournalReader() {
+    close_segment();
+}
+
+bool TickJournalReader::next(Record& out) {
+    for (;;) {
+        if (m_map && m_offset + sizeof(journal::RecordHeader) <= m_size) {
+            journal::RecordHeader header;
+            std::memcpy(&header, m_map + m_offset, sizeof(header));
+            size_t end = m_offset + sizeof(header) + journal::padded(header.length);
+            if (header.length != 0) {
+                if (end > m_size) {
+                    close_segment();
+                    continue;
+                }
+                std::string_view payload(m_map + m_offset + sizeof(header), header.length);
+                m_offset = end;
+                if (header.type == journal::CHANNEL) {
+                    m_channels[header.channel_id] = std::string(payload);
+                    continue;
+                }
+                auto channel = m_channels.find(header.channel_id);
+                out.received_ns = header.received_ns;
+                out.channel_id = header.channel_id;
+                out.channel = channel == m_channels.end() ? std::string_view() : std::string_view(channel->second);
+                out.payload = payload;
+                return true;
+            }
+        }
+        if (!open_next_segment()) return false;
+    }
+}
+
+bool TickJournalReader::open_next_segment() {
+    close_segment();
+    while (m_next_path < m_paths.size()) {
+        const std::string& path = m_paths[m_next_path++];
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(journal::SegmentHeader)) {
+            ::close(fd);
+            continue;
+        }
+        void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) continue;
+
+        journal::SegmentHeader header;
+        std::memcpy(&header, map, sizeof(header));
+        if (header.magic != journal::kSegmentMagic || header.version != journal::kVersion) {
+            ::munmap(map, st.st_size);
+            continue;
+        }
+        m_map = static_cast<const char*>(map);
+        m_size = st.st_size;
+        m_offset = sizeof(header);
+        m_segment = header.index;
+        m_channels.clear();
+        ::madvise(const_cast<char*>(m_map), m_size, MADV_SEQUENTIAL);
+        return true;
+    }
+    return false;
+}
+
+void TickJournalReader::close_segment() {
+    if (!m_map) return;
+    ::munmap(const_cast<char*>(m_map), m_size);
+    m_map = nullptr;
+    m_size = 0;
+}
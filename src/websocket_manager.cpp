@@ -1,11 +1,22 @@
 #include "websocket_manager.hpp"
 #include <nlohmann/json.hpp>
-#include "performance_tracker.hpp"
+#include "feed_monitor.hpp"
+#include "latency_trace.hpp"
+#include "thread_affinity.hpp"
+#include <chrono>
+#include <functional>
 #include <iostream>
 
 using json = nlohmann::json;
 
-WebSocketServer::WebSocketServer(DeribitClient& deribit_client)
+namespace {
+Gauge& connected_clients = MetricsRegistry::instance().gauge("deribit_fanout_clients", "Connected local WebSocket clients");
+Counter& send_errors = MetricsRegistry::instance().counter("deribit_fanout_send_errors_total", "Failed sends to local subscribers");
+Counter& queue_dropped = MetricsRegistry::instance().counter("deribit_fanout_queue_dropped_total", "Updates dropped because a fan-out queue was full");
+LatencyHistogram& queue_wait = MetricsRegistry::instance().histogram("deribit_fanout_queue_wait_seconds", "Time updates spend queued for a fan-out worker");
+}
+
+WebSocketServer::WebSocketServer(DeribitClient& deribit_client, size_t fanout_workers, size_t queue_capacity)
     : m_running(false), m_deribit_client(deribit_client) {
     
     logger = Logger();
@@ -15,14 +26,18 @@ WebSocketServer::WebSocketServer(DeribitClient& deribit_client)
     m_server.set_open_handler([this](connection_hdl hdl) {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_connections.insert(hdl);
+        connected_clients.set(m_connections.size());
         logger.log(Logger::LogLevel::INFO, "Client connected");
     });
 
     m_server.set_close_handler([this](connection_hdl hdl) {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_connections.erase(hdl);
-        for (auto& pair : m_subscriptions) {
-            pair.second.erase(hdl);
+        connected_clients.set(m_connections.size());
+        for (auto& entry : m_subscriptions) {
+            if (entry.connections.erase(hdl)) {
+                entry.metrics.subscribers->set(entry.connections.size());
+            }
         }
         logger.log(Logger::LogLevel::INFO, "Client disconnected");
     });
@@ -32,11 +47,95 @@ WebSocketServer::WebSocketServer(DeribitClient& deribit_client)
     });
 
     m_deribit_client.set_broadcast_callback([this](const std::string& channel, const std::string& data) {
-        PerformanceTracker t("broadcast_orderbook");
-        logger.log(Logger::LogLevel::INFO, "Received broadcast from Deribit");
-        broadcast_orderbook(channel, data);
-        t.stop();
+        publish(channel, data);
+    });
+
+    m_fanout_running = true;
+    std::vector<std::promise<void>> ready(fanout_workers);
+    for (size_t i = 0; i < fanout_workers; ++i) {
+        m_workers.emplace_back(new FanoutWorker());
+        FanoutWorker& worker = *m_workers.back();
+        worker.depth = &MetricsRegistry::instance().gauge("deribit_fanout_queue_depth", "Updates waiting for a fan-out worker",
+                                                          MetricsRegistry::label("worker", std::to_string(i)));
+        std::promise<void>& started = ready[i];
+        worker.thread = std::thread([this, &worker, queue_capacity, &started]() {
+            fanout_loop(worker, queue_capacity, started);
+        });
+    }
+    for (auto& started : ready) started.get_future().wait();
+}
+
+WebSocketServer::~WebSocketServer() {
+    m_deribit_client.set_broadcast_callback(nullptr);
+    m_fanout_running = false;
+    for (auto& worker : m_workers) {
+        worker->waiter.notify();
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+void WebSocketServer::publish(const std::string& channel, const std::string& data) {
+    LatencyTrace& trace = LatencyTrace::instance();
+    trace.mark(LatencyTrace::DISPATCH);
+    InstrumentId instrument = channel_instrument(channel);
+    if (instrument == kNoInstrument) return;
+    if (instrument < m_bus_slots.size() && m_bus_slots[instrument] >= 0) {
+        m_publisher->enqueue(m_bus_slots[instrument], data);
+    }
+    if (m_workers.empty()) {
+        broadcast_orderbook(instrument, data);
+        return;
+    }
+
+    FanoutWorker& worker = *m_workers[instrument % m_workers.size()];
+    LatencyTrace::Handoff handoff = trace.handoff();
+    bool queued = worker.queue->try_push_with([&](Update& slot) {
+        slot.instrument = instrument;
+        slot.data.assign(data);
+        slot.enqueued_ns = LatencyTrace::now_ns();
+        slot.trace = handoff;
     });
+    if (queued) worker.waiter.notify();
+    else queue_dropped.inc();
+}
+
+void WebSocketServer::set_market_data_publisher(MarketDataPublisher* publisher, const std::vector<std::string>& symbols) {
+    m_publisher = publisher;
+    for (const auto& symbol : symbols) {
+        int slot = publisher->add_instrument(symbol);
+        if (slot < 0) continue;
+        InstrumentId id = InstrumentRegistry::instance().find(symbol);
+        if (id >= m_bus_slots.size()) m_bus_slots.resize(id + 1, -1);
+        m_bus_slots[id] = slot;
+        m_deribit_client.subscribe_public("book." + symbol + ".agg2");
+    }
+    publisher->start();
+}
+
+void WebSocketServer::fanout_loop(FanoutWorker& worker, size_t queue_capacity, std::promise<void>& ready) {
+    ThreadAffinity& affinity = ThreadAffinity::instance();
+    affinity.pin_current_thread(ThreadAffinity::FANOUT);
+    worker.queue.reset(new SpscQueue<Update>(queue_capacity));
+    ready.set_value();
+
+    LatencyTrace& trace = LatencyTrace::instance();
+    SpscQueue<Update>& queue = *worker.queue;
+    auto deliver = [&](Update& update) {
+        queue_wait.record(LatencyTrace::now_ns() - update.enqueued_ns);
+        worker.depth->set(queue.size_approx());
+        trace.resume(update.trace);
+        broadcast_orderbook(update.instrument, update.data);
+        trace.end_frame();
+    };
+    for (;;) {
+        if (queue.try_pop_with(deliver)) continue;
+        if (!m_fanout_running) break;
+        if (affinity.busy_poll()) {
+            ThreadAffinity::cpu_relax();
+        } else {
+            worker.waiter.wait([&]() { return !queue.empty() || !m_fanout_running; });
+        }
+    }
 }
 
 void WebSocketServer::run(uint16_t port) {
@@ -49,7 +148,8 @@ void WebSocketServer::run(uint16_t port) {
         m_deribit_client.connect_websocket();
         
         m_running = true;
-        m_server.run();
+        ThreadAffinity::instance().pin_current_thread(ThreadAffinity::SERVER);
+        ThreadAffinity::instance().run(m_server);
     } catch (const std::exception& e) {
         logger.log(Logger::LogLevel::ERROR, "Error running WebSocket server: " + std::string(e.what()));
         m_running = false;
@@ -85,24 +185,46 @@ void WebSocketServer::on_message(connection_hdl hdl, server::message_ptr msg) {
             
             std::string symbol = request["symbol"];
             handle_subscription(hdl, symbol);
+        } else if (request.contains("action") && request["action"] == "latency") {
+            send_latency_report(hdl, request);
         }
     } catch (const json::exception& e) {
         logger.log(Logger::LogLevel::ERROR, "Failed to parse WebSocket message: " + std::string(e.what()));
+    } catch (const std::exception& e) {
+        logger.log(Logger::LogLevel::ERROR, "Failed to handle WebSocket message: " + std::string(e.what()));
     }
 }
 
+// Only instruments the registry already knows are accepted; client input is
+// never interned, so clients cannot fill the process-wide table.
 void WebSocketServer::handle_subscription(connection_hdl hdl, const std::string& symbol) {
+    InstrumentId id = InstrumentRegistry::instance().find(symbol);
+    if (id == kNoInstrument) {
+        json response = {
+            {"status", "error"},
+            {"symbol", symbol},
+            {"message", "unknown instrument"}
+        };
+        try {
+            m_server.send(hdl, response.dump(), websocketpp::frame::opcode::text);
+        } catch (const std::exception& e) {
+            logger.log(Logger::LogLevel::ERROR, "Error sending subscription error: " + std::string(e.what()));
+        }
+        return;
+    }
     std::string channel = "book." + symbol + ".agg2";
+    Subscribers& entry = subscribers(id, channel);
+
+    entry.connections.insert(hdl);
+    entry.metrics.subscribers->set(entry.connections.size());
     
-    m_subscriptions[channel].insert(hdl);
-    
-    if (m_subscriptions[channel].size() == 1) {
+    if (entry.connections.size() == 1) {
         std::cout << "First subscriber for " << symbol << ", subscribing to Deribit" << std::endl;
         m_deribit_client.subscribe_to_channel(channel);
     }
     
     std::cout << "Client subscribed to: " << symbol << std::endl;
-    std::cout << "Total subscribers for " << symbol << ": " << m_subscriptions[channel].size() << std::endl;
+    std::cout << "Total subscribers for " << symbol << ": " << entry.connections.size() << std::endl;
     
     send_subscription_confirmation(hdl, channel);
 }
@@ -121,21 +243,123 @@ void WebSocketServer::send_subscription_confirmation(connection_hdl hdl, const s
     }
 }
 
-void WebSocketServer::broadcast_orderbook(const std::string& symbol, const std::string& orderbook_update) {
+// Reports the per-stage feed latency and the upstream round trip, clock
+// offset and exchange-side lag; "sample_rate" in the request changes how many
+// frames are traced (0 disables tracing).
+void WebSocketServer::send_latency_report(connection_hdl hdl, const json& request) {
+    LatencyTrace& trace = LatencyTrace::instance();
+    if (request.contains("sample_rate")) {
+        trace.set_sample_rate(request["sample_rate"].get<uint32_t>());
+    }
+    if (request.value("reset", false)) {
+        trace.reset();
+    }
+
+    json response = {
+        {"action", "latency"},
+        {"trace", trace.to_json()},
+        {"upstream", m_deribit_client.feed_monitor().to_json()}
+    };
+    try {
+        m_server.send(hdl, response.dump(), websocketpp::frame::opcode::text);
+    } catch (const std::exception& e) {
+        logger.log(Logger::LogLevel::ERROR, "Error sending latency report: " + std::string(e.what()));
+    }
+}
+
+// Called with m_mutex held.
+WebSocketServer::Subscribers& WebSocketServer::subscribers(InstrumentId id, const std::string& channel) {
+    if (id >= m_subscriptions.size()) m_subscriptions.resize(id + 1);
+    Subscribers& entry = m_subscriptions[id];
+    if (entry.metrics.sent) return entry;
+
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    std::string labels = MetricsRegistry::label("channel", channel);
+    entry.channel = channel;
+    entry.metrics = ChannelMetrics{
+        &metrics.gauge("deribit_fanout_subscribers", "Local subscribers per channel", labels),
+        &metrics.gauge("deribit_fanout_send_queue_bytes", "Bytes queued to a channel's subscribers after the last update", labels),
+        &metrics.counter("deribit_fanout_messages_total", "Updates sent to local subscribers per channel", labels)
+    };
+    return entry;
+}
+
+// Only book.{instrument}.agg2 channels map to an instrument. Upstream only
+// sends channels that were subscribed, and a book channel is only subscribed
+// once its instrument is interned, so misses are cached as well and the
+// table stays as small as the subscription list.
+InstrumentId WebSocketServer::channel_instrument(const std::string& channel) {
+    auto cached = m_channel_ids.find(channel);
+    if (cached != m_channel_ids.end()) return cached->second;
+
+    InstrumentId id = kNoInstrument;
+    static const char kPrefix[] = "book.";
+    static const char kSuffix[] = ".agg2";
+    size_t prefix = sizeof(kPrefix) - 1;
+    size_t suffix = sizeof(kSuffix) - 1;
+    if (channel.size() > prefix + suffix && channel.compare(0, prefix, kPrefix) == 0 &&
+        channel.compare(channel.size() - suffix, suffix, kSuffix) == 0) {
+        id = InstrumentRegistry::instance().find(channel.substr(prefix, channel.size() - prefix - suffix));
+    }
+    m_channel_ids.emplace(channel, id);
+    return id;
+}
+
+// Called with m_mutex held. A server frame is not masked, so it is framed
+// once here and the same message is queued to every subscriber; a pooled
+// message is reused once no send queue holds it any more. The scan starts
+// after the last message handed out, which is usually the one still in use.
+server::message_ptr WebSocketServer::outbound_message(const std::string& payload) {
+    server::message_ptr message;
+    for (size_t i = 0; i < m_message_pool.size(); ++i) {
+        size_t slot = (m_message_pool_next + i) % m_message_pool.size();
+        if (m_message_pool[slot].use_count() == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            message = m_message_pool[slot];
+            m_message_pool_next = slot + 1;
+            break;
+        }
+    }
+    if (!message) {
+        message = std::make_shared<server::message_ptr::element_type>(nullptr, websocketpp::frame::opcode::text, payload.size());
+        if (m_message_pool.size() < kMessagePoolSize) {
+            m_message_pool.push_back(message);
+            m_message_pool_next = m_message_pool.size();
+        }
+    }
+
+    websocketpp::frame::basic_header header(websocketpp::frame::opcode::text, payload.size(), true, false);
+    websocketpp::frame::extended_header extended(payload.size());
+    message->set_header(websocketpp::frame::prepare_header(header, extended));
+    message->set_payload(payload);
+    message->set_prepared(true);
+    return message;
+}
+
+void WebSocketServer::broadcast_orderbook(InstrumentId instrument, const std::string& orderbook_update) {
+    LatencyTrace& trace = LatencyTrace::instance();
     std::lock_guard<std::mutex> lock(m_mutex);
-    std::cout << "Broadcasting to subscribers of " << symbol << std::endl;
-    
-    if (m_subscriptions.count(symbol)) {
-        std::cout << "Found " << m_subscriptions[symbol].size() << " subscribers" << std::endl;
-        for (const auto& hdl : m_subscriptions[symbol]) {
+    trace.mark(LatencyTrace::LOCK_ACQUIRE);
+
+    if (instrument < m_subscriptions.size() && m_subscriptions[instrument].metrics.sent) {
+        Subscribers& entry = m_subscriptions[instrument];
+        ChannelMetrics& channel = entry.metrics;
+        server::message_ptr message = entry.connections.empty() ? nullptr : outbound_message(orderbook_update);
+        size_t queued = 0;
+        for (const auto& hdl : entry.connections) {
             try {
-                m_server.send(hdl, orderbook_update, websocketpp::frame::opcode::text);
-                logger.log(Logger::LogLevel::INFO, "Broadcasted orderbook update to client");
+                uint64_t started = trace.start();
+                server::connection_ptr con = m_server.get_con_from_hdl(hdl);
+                websocketpp::lib::error_code ec = con->send(message);
+                trace.finish(LatencyTrace::SEND_ENQUEUE, started);
+                if (ec) throw websocketpp::exception(ec);
+                queued += con->get_buffered_amount();
+                channel.sent->inc();
             } catch (const std::exception& e) {
+                send_errors.inc();
                 logger.log(Logger::LogLevel::ERROR, "Error broadcasting orderbook update: " + std::string(e.what()));
             }
         }
-    } else {
-        std::cout << "No subscribers found for " << symbol << std::endl;
+        channel.queued_bytes->set(queued);
     }
 }
\ No newline at end of file
@@ -0,0 +1,538 @@
+#include "websocket_manager.hpp"
+#include "instrument_registry.hpp"
+#include "latency_histogram.hpp"
+#include "market_data_publisher.hpp"
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+// Load generator for the local fan-out server. An in-process WebSocketServer
+// is fed synthetic book updates through publish(), as DeribitClient would,
+// while a growing number of loopback clients subscribe across symbols. Each
+// update carries its publish time so the clients can record the
+// publish-to-receive delay; at each subscriber step the tool reports delay
+// percentiles, dropped connections, missed updates and server CPU, plus how
+// long each publish() held the publishing (upstream reader) thread. With
+// --bus-readers the server also hands each update to a shared-memory market
+// data bus publisher and that many reader threads record the same delay from
+// the bus.
+
+typedef websocketpp::client<websocketpp::config::asio_client> load_client;
+using json = nlohmann::json;
+
+struct LoadConfig {
+    std::vector<size_t> steps{10, 100, 500, 1000, 2000, 5000};
+    size_t symbols = 4;
+    size_t client_threads = 4;
+    uint32_t rate = 100;          // publishes per second across all symbols
+    double duration = 5.0;        // seconds measured per step
+    double knee_factor = 2.0;     // p99 growth over the first step that marks the knee
+    uint16_t port = 19002;
+    size_t fanout_workers = 1;    // 0 broadcasts on the publishing thread
+    size_t bus_readers = 0;       // market data bus readers; 0 leaves the bus off
+    bool server_log = false;
+    std::string json_path, csv_path;
+};
+
+struct StepResult {
+    size_t target = 0;
+    size_t connected = 0;
+    uint64_t dropped = 0;
+    uint64_t published = 0;
+    uint64_t expected = 0;
+    uint64_t received = 0;
+    LatencyHistogram::Summary delay;
+    LatencyHistogram::Summary publish;   // time the publishing thread spent in publish()
+    LatencyHistogram::Summary bus;       // publish-to-read delay of the bus readers
+    uint64_t bus_lost = 0;
+    uint64_t queue_dropped = 0;
+    double server_cpu = 0.0;    // server io thread, percent of one core
+    double publish_cpu = 0.0;   // publishing (upstream) thread, percent of one core
+};
+
+static const char* kStampKey = "\"loadgen_ns\":";
+
+static uint64_t steady_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint64_t thread_cpu_ns(clockid_t clock) {
+    timespec ts{};
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static std::string symbol_name(size_t index) {
+    return index == 0 ? "BTC-PERPETUAL" : "LOAD-" + std::to_string(index) + "-PERPETUAL";
+}
+
+// A book change shaped like the upstream agg2 notification, with the publish
+// timestamp appended last so clients can find it without parsing. The first
+// update of a symbol (prev_change_id 0) is a snapshot.
+static std::string make_update(const std::string& symbol, uint64_t prev_change_id, uint64_t change_id, uint64_t stamp) {
+    std::string frame = R"({"jsonrpc":"2.0","method":"subscription","params":{"channel":"book.)" + symbol +
+                        R"(.agg2","data":{"type":")" + (prev_change_id ? "change" : "snapshot") +
+                        R"(","instrument_name":")" + symbol +
+                        R"(","prev_change_id":)" + std::to_string(prev_change_id) +
+                        R"(,"change_id":)" + std::to_string(change_id) +
+                        R"(,"bids":[["change",60000.5,1250.0]],"asks":[["new",60001.0,400.0]]}},)";
+    frame += kStampKey;
+    frame += std::to_string(stamp) + "}";
+    return frame;
+}
+
+// Publish times by change_id, for the bus readers
+static constexpr size_t kStampSlots = 1 << 16;
+static std::atomic<uint64_t> publish_stamps[kStampSlots];
+
+// Threads reading the shared-memory bus as co-located consumers would,
+// recording the delay from publish to read.
+class BusReaders {
+public:
+    BusReaders(const std::string& name, size_t readers) {
+        for (size_t i = 0; i < readers; ++i) {
+            m_threads.emplace_back([this, name]() {
+                MarketDataBusReader reader(name);
+                mdbus::Update update{};
+                uint64_t lost = 0;
+                while (m_running.load(std::memory_order_relaxed)) {
+                    if (!reader.poll(update)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    if (reader.lost() != lost) {
+                        m_lost += reader.lost() - lost;
+                        lost = reader.lost();
+                    }
+                    uint64_t now = steady_ns();
+                    uint64_t sent = publish_stamps[update.change_id & (kStampSlots - 1)].load(std::memory_order_relaxed);
+                    m_delay.record(now > sent ? now - sent : 0);
+                }
+            });
+        }
+    }
+
+    ~BusReaders() {
+        stop();
+    }
+
+    void stop() {
+        m_running = false;
+        for (auto& thread : m_threads) {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    uint64_t lost() const { return m_lost; }
+    LatencyHistogram& delay() { return m_delay; }
+
+private:
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_running{true};
+    std::atomic<uint64_t> m_lost{0};
+    LatencyHistogram m_delay;
+};
+
+// Clients split over several io threads so the receive side is not the bottleneck.
+class ClientPool {
+public:
+    ClientPool(size_t threads, uint16_t port, size_t symbols)
+        : m_uri("ws://127.0.0.1:" + std::to_string(port)), m_symbols(symbols) {
+        for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+            m_endpoints.emplace_back(new load_client());
+            init(*m_endpoints.back());
+        }
+        for (auto& endpoint : m_endpoints) {
+            load_client* raw = endpoint.get();
+            m_threads.emplace_back([raw]() {
+                raw->run();
+            });
+        }
+    }
+
+    ~ClientPool() {
+        stop();
+    }
+
+    // Opens clients until `total` have been requested, subscribing client i to symbol i % symbols.
+    void grow(size_t total) {
+        for (size_t i = m_requested; i < total; ++i) {
+            load_client& endpoint = *m_endpoints[i % m_endpoints.size()];
+            std::string subscribe = R"({"action":"subscribe","symbol":")" + symbol_name(i % m_symbols) + "\"}";
+            endpoint.get_io_service().post([this, &endpoint, subscribe]() {
+                websocketpp::lib::error_code ec;
+                auto con = endpoint.get_connection(m_uri, ec);
+                if (ec) {
+                    ++m_failed;
+                    return;
+                }
+                con->set_open_handler([&endpoint, subscribe](websocketpp::connection_hdl hdl) {
+                    websocketpp::lib::error_code send_ec;
+                    endpoint.send(hdl, subscribe, websocketpp::frame::opcode::text, send_ec);
+                });
+                endpoint.connect(con);
+            });
+        }
+        m_requested = std::max(m_requested, total);
+    }
+
+    bool wait_subscribed(size_t total, std::chrono::seconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (m_subscribed + m_failed < total && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return m_subscribed >= total;
+    }
+
+    void stop() {
+        for (auto& endpoint : m_endpoints) {
+            endpoint->stop_perpetual();
+            endpoint->stop();
+        }
+        for (auto& thread : m_threads) {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    size_t subscribed() const { return m_subscribed; }
+    uint64_t failed() const { return m_failed; }
+    uint64_t closed() const { return m_closed; }
+    uint64_t received() const { return m_received; }
+    LatencyHistogram& delay() { return m_delay; }
+
+private:
+    void init(load_client& endpoint) {
+        endpoint.clear_access_channels(websocketpp::log::alevel::all);
+        endpoint.clear_error_channels(websocketpp::log::elevel::all);
+        endpoint.init_asio();
+        endpoint.start_perpetual();
+
+        endpoint.set_message_handler([this](websocketpp::connection_hdl, load_client::message_ptr msg) {
+            uint64_t now = steady_ns();
+            const std::string& payload = msg->get_payload();
+            size_t pos = payload.rfind(kStampKey);
+            if (pos == std::string::npos) {
+                if (payload.compare(0, 10, "{\"status\":") == 0) ++m_subscribed;
+                return;
+            }
+            uint64_t sent = std::strtoull(payload.c_str() + pos + std::strlen(kStampKey), nullptr, 10);
+            m_delay.record(now > sent ? now - sent : 0);
+            ++m_received;
+        });
+        endpoint.set_fail_handler([this](websocketpp::connection_hdl) {
+            ++m_failed;
+        });
+        endpoint.set_close_handler([this](websocketpp::connection_hdl) {
+            ++m_closed;
+        });
+    }
+
+    std::string m_uri;
+    size_t m_symbols;
+    size_t m_requested = 0;
+    std::vector<std::unique_ptr<load_client>> m_endpoints;
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_subscribed{0};
+    std::atomic<uint64_t> m_failed{0};
+    std::atomic<uint64_t> m_closed{0};
+    std::atomic<uint64_t> m_received{0};
+    LatencyHistogram m_delay;
+};
+
+// Publishes at the configured rate for the step duration, round-robin over
+// symbols, and returns the thread CPU time it spent doing so.
+static uint64_t publish_step(WebSocketServer& server, const LoadConfig& config, uint64_t& change_id,
+                             std::vector<uint64_t>& last_change_id, uint64_t& published, LatencyHistogram& publish_time) {
+    using clock = std::chrono::steady_clock;
+    auto interval = std::chrono::nanoseconds(1000000000ull / std::max<uint32_t>(config.rate, 1));
+    auto end = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(config.duration));
+    auto next = clock::now();
+    uint64_t cpu_start = thread_cpu_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    size_t symbol = 0;
+    while (next < end) {
+        std::this_thread::sleep_until(next);
+        std::string name = symbol_name(symbol);
+        std::string channel = "book." + name + ".agg2";
+        uint64_t stamp = steady_ns();
+        publish_stamps[++change_id & (kStampSlots - 1)].store(stamp, std::memory_order_relaxed);
+        std::string update = make_update(name, last_change_id[symbol], change_id, stamp);
+        last_change_id[symbol] = change_id;
+        uint64_t started = steady_ns();
+        server.publish(channel, update);
+        publish_time.record(steady_ns() - started);
+        ++published;
+        symbol = (symbol + 1) % config.symbols;
+        next += interval;
+    }
+    return thread_cpu_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start;
+}
+
+static void raise_fd_limit() {
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static std::vector<size_t> parse_steps(const std::string& list) {
+    std::vector<size_t> steps;
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) steps.push_back(std::stoul(item));
+    }
+    std::sort(steps.begin(), steps.end());
+    return steps;
+}
+
+// First step whose p99 exceeds knee_factor times the p99 of the first step.
+static size_t find_knee(const std::vector<StepResult>& results, double factor) {
+    if (results.empty() || results.front().delay.count == 0) return results.size();
+    double baseline = static_cast<double>(std::max<uint64_t>(results.front().delay.p99, 1));
+    for (size_t i = 1; i < results.size(); ++i) {
+        if (results[i].delay.count == 0 || results[i].delay.p99 > baseline * factor) return i;
+    }
+    return results.size();
+}
+
+static json step_to_json(const StepResult& r) {
+    json entry = LatencyHistogram::to_json(r.delay);
+    entry["subscribers"] = r.target;
+    entry["connected"] = r.connected;
+    entry["dropped"] = r.dropped;
+    entry["published"] = r.published;
+    entry["expected"] = r.expected;
+    entry["received"] = r.received;
+    entry["server_cpu_pct"] = r.server_cpu;
+    entry["publish_cpu_pct"] = r.publish_cpu;
+    entry["publish_p50_ns"] = r.publish.p50;
+    entry["publish_p99_ns"] = r.publish.p99;
+    entry["publish_max_ns"] = r.publish.max;
+    entry["queue_dropped"] = r.queue_dropped;
+    entry["bus_p50_ns"] = r.bus.p50;
+    entry["bus_p99_ns"] = r.bus.p99;
+    entry["bus_max_ns"] = r.bus.max;
+    entry["bus_lost"] = r.bus_lost;
+    return entry;
+}
+
+void usage() {
+    std::cout << "Usage: fanout_loadgen [--steps N,N,...] [--symbols N] [--rate PER_SEC] [--duration SECONDS]" << std::endl;
+    std::cout << "                      [--client-threads N] [--port N] [--knee-factor X] [--server-log]" << std::endl;
+    std::cout << "                      [--fanout-workers N] [--bus-readers N]" << std::endl;
+    std::cout << "                      [--json PATH] [--csv PATH]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    LoadConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--server-log") {
+            config.server_log = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--steps") config.steps = parse_steps(value);
+        else if (arg == "--symbols") config.symbols = std::max<size_t>(std::stoul(value), 1);
+        else if (arg == "--rate") config.rate = static_cast<uint32_t>(std::stoul(value));
+        else if (arg == "--duration") config.duration = std::stod(value);
+        else if (arg == "--client-threads") config.client_threads = std::stoul(value);
+        else if (arg == "--port") config.port = static_cast<uint16_t>(std::stoul(value));
+        else if (arg == "--knee-factor") config.knee_factor = std::stod(value);
+        else if (arg == "--fanout-workers") config.fanout_workers = std::stoul(value);
+        else if (arg == "--bus-readers") config.bus_readers = std::stoul(value);
+        else if (arg == "--json") config.json_path = value;
+        else if (arg == "--csv") config.csv_path = value;
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (config.steps.empty()) {
+        usage();
+        return 1;
+    }
+    raise_fd_limit();
+
+    // The server logs every connection and subscription to stdout; keep the report
+    // readable unless asked otherwise. The logging cost is still paid.
+    std::ostream report(std::cout.rdbuf());
+    std::ofstream null_sink;
+    if (!config.server_log) {
+        null_sink.open("/dev/null");
+        std::cout.rdbuf(null_sink.rdbuf());
+    }
+
+    std::unique_ptr<MarketDataPublisher> bus;
+    if (config.bus_readers > 0) {
+        MarketDataPublisher::Options options;
+        options.name = "/deribit-md-loadgen-" + std::to_string(::getpid());
+        bus.reset(new MarketDataPublisher(options));
+    }
+    // The server only accepts instruments the registry knows
+    std::vector<std::string> symbols;
+    for (size_t i = 0; i < config.symbols; ++i) {
+        symbols.push_back(symbol_name(i));
+        InstrumentRegistry::instance().intern(symbols.back());
+    }
+    DeribitClient upstream;
+    WebSocketServer server(upstream, config.fanout_workers);
+    if (bus) server.set_market_data_publisher(bus.get(), symbols);
+    Counter& queue_dropped = MetricsRegistry::instance().counter("deribit_fanout_queue_dropped_total",
+                                                                 "Updates dropped because a fan-out queue was full");
+    std::thread server_thread([&]() {
+        try {
+            server.run(config.port);
+        } catch (const std::exception& e) {
+            std::cerr << "Server failed: " << e.what() << std::endl;
+        }
+    });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!server.is_running() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (!server.is_running()) {
+        server_thread.join();
+        std::cout.rdbuf(report.rdbuf());
+        return 1;
+    }
+
+    clockid_t server_clock;
+    pthread_getcpuclockid(server_thread.native_handle(), &server_clock);
+
+    report << "Fan-out load: " << config.symbols << " symbols, " << config.rate << " updates/s, "
+           << config.duration << "s per step, " << config.fanout_workers << " fan-out workers" << std::endl;
+    report << std::setw(12) << "subscribers" << std::setw(11) << "connected" << std::setw(9) << "dropped"
+           << std::setw(9) << "missed" << std::setw(11) << "p50_us" << std::setw(11) << "p99_us"
+           << std::setw(11) << "p999_us" << std::setw(11) << "max_us" << std::setw(10) << "srv_cpu%"
+           << std::setw(10) << "pub_cpu%" << std::setw(12) << "pub_p99_us" << std::setw(9) << "q_drop"
+           << std::setw(11) << "bus_p50_us" << std::setw(11) << "bus_p99_us" << std::endl;
+
+    std::vector<StepResult> results;
+    {
+        ClientPool clients(config.client_threads, config.port, config.symbols);
+        std::unique_ptr<BusReaders> bus_readers;
+        if (bus) bus_readers.reset(new BusReaders(bus->name(), config.bus_readers));
+        uint64_t change_id = 1;
+        std::vector<uint64_t> last_change_id(config.symbols, 0);
+        for (size_t target : config.steps) {
+            clients.grow(target);
+            if (!clients.wait_subscribed(target, std::chrono::seconds(60))) {
+                report << "Only " << clients.subscribed() << " of " << target << " clients subscribed" << std::endl;
+            }
+
+            StepResult result;
+            result.target = target;
+            result.connected = clients.subscribed();
+            uint64_t dropped_before = clients.failed() + clients.closed();
+            uint64_t received_before = clients.received();
+            clients.delay().reset();
+            if (bus_readers) bus_readers->delay().reset();
+            uint64_t bus_lost_before = bus_readers ? bus_readers->lost() : 0;
+            LatencyHistogram publish_time;
+            uint64_t queue_dropped_before = queue_dropped.value();
+
+            // Every symbol gets an equal share of subscribers (client i -> symbol i % symbols)
+            // and of updates, so each update is expected by connected / symbols clients.
+            auto wall_start = std::chrono::steady_clock::now();
+            uint64_t server_cpu_start = thread_cpu_ns(server_clock);
+            uint64_t publish_cpu = publish_step(server, config, change_id, last_change_id, result.published, publish_time);
+            for (size_t i = 0; i < result.published; ++i) {
+                size_t symbol = i % config.symbols;
+                result.expected += result.connected / config.symbols + (symbol < result.connected % config.symbols ? 1 : 0);
+            }
+
+            // Let queued sends drain before closing the step.
+            auto drain_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (clients.received() - received_before < result.expected &&
+                   std::chrono::steady_clock::now() < drain_deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+            double wall_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wall_start).count();
+            result.server_cpu = 100.0 * (thread_cpu_ns(server_clock) - server_cpu_start) / wall_ns;
+            result.publish_cpu = 100.0 * publish_cpu / wall_ns;
+            result.received = clients.received() - received_before;
+            result.dropped = clients.failed() + clients.closed() - dropped_before;
+            result.delay = clients.delay().summary();
+            result.publish = publish_time.summary();
+            result.queue_dropped = queue_dropped.value() - queue_dropped_before;
+            if (bus_readers) {
+                result.bus = bus_readers->delay().summary();
+                result.bus_lost = bus_readers->lost() - bus_lost_before;
+            }
+            results.push_back(result);
+
+            uint64_t missed = result.expected > result.received ? result.expected - result.received : 0;
+            report << std::setw(12) << target << std::setw(11) << result.connected << std::setw(9) << result.dropped
+                   << std::setw(9) << missed << std::fixed << std::setprecision(1)
+                   << std::setw(11) << result.delay.p50 / 1000.0 << std::setw(11) << result.delay.p99 / 1000.0
+                   << std::setw(11) << result.delay.p999 / 1000.0 << std::setw(11) << result.delay.max / 1000.0
+                   << std::setw(10) << result.server_cpu << std::setw(10) << result.publish_cpu
+                   << std::setw(12) << result.publish.p99 / 1000.0 << std::setw(9) << result.queue_dropped
+                   << std::setw(11) << result.bus.p50 / 1000.0 << std::setw(11) << result.bus.p99 / 1000.0 << std::endl;
+        }
+        clients.stop();
+        if (bus_readers) bus_readers->stop();
+    }
+    server.stop();
+    server_thread.join();
+    std::cout.rdbuf(report.rdbuf());
+
+    size_t knee = find_knee(results, config.knee_factor);
+    if (knee < results.size()) {
+        std::cout << "Knee: p99 delay exceeds " << config.knee_factor << "x the " << results.front().target
+                  << "-subscriber baseline at " << results[knee].target << " subscribers" << std::endl;
+    } else {
+        std::cout << "Knee: not reached (p99 stayed within " << config.knee_factor << "x of baseline)" << std::endl;
+    }
+
+    if (!config.json_path.empty()) {
+        json steps = json::array();
+        for (const auto& r : results) steps.push_back(step_to_json(r));
+        json out = {
+            {"symbols", config.symbols},
+            {"rate", config.rate},
+            {"duration", config.duration},
+            {"fanout_workers", config.fanout_workers},
+            {"bus_readers", config.bus_readers},
+            {"knee_subscribers", knee < results.size() ? json(results[knee].target) : json(nullptr)},
+            {"steps", steps}
+        };
+        std::ofstream file(config.json_path);
+        file << out.dump(4) << std::endl;
+    }
+    if (!config.csv_path.empty()) {
+        std::ofstream file(config.csv_path);
+        file << "subscribers,connected,dropped,published,expected,received,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,"
+                "server_cpu_pct,publish_cpu_pct,publish_p99_ns,queue_dropped,bus_p50_ns,bus_p99_ns,bus_lost\n";
+        for (const auto& r : results) {
+            file << r.target << "," << r.connected << "," << r.dropped << "," << r.published << "," << r.expected
+                 << "," << r.received << "," << r.delay.p50 << "," << r.delay.p90 << "," << r.delay.p99 << ","
+                 << r.delay.p999 << "," << r.delay.max << "," << r.server_cpu << "," << r.publish_cpu << ","
+                 << r.publish.p99 << "," << r.queue_dropped << "," << r.bus.p50 << "," << r.bus.p99 << "," << r.bus_lost << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include "mock_exchange.hpp"
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+MockExchange* exchange_ptr = nullptr;
+
+void signal_handler(int signal) {
+    std::cout << "\nReceived signal " << signal << ", shutting down..." << std::endl;
+    if (exchange_ptr) {
+        exchange_ptr->stop();
+    }
+}
+
+void usage() {
+    std::cout << "Usage: mock_deribit [--help] [--rest-port N] [--ws-port N] [--latency-us N] [--jitter-us N]" << std::endl;
+    std::cout << "                    [--book-interval-ms N] [--book-depth N] [--seed N]" << std::endl;
+    std::cout << "                    [--matching-rate N] [--matching-burst N]" << std::endl;
+    std::cout << "                    [--non-matching-rate N] [--non-matching-burst N]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    MockConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            usage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string text = argv[++i];
+        unsigned long value;
+        try {
+            size_t used = 0;
+            value = std::stoul(text, &used);
+            if (used != text.size()) throw std::invalid_argument(text);
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << ": " << text << std::endl;
+            usage();
+            return 1;
+        }
+        if (arg == "--rest-port") config.rest_port = static_cast<uint16_t>(value);
+        else if (arg == "--ws-port") config.ws_port = static_cast<uint16_t>(value);
+        else if (arg == "--latency-us") config.latency_us = static_cast<uint32_t>(value);
+        else if (arg == "--jitter-us") config.jitter_us = static_cast<uint32_t>(value);
+        else if (arg == "--book-interval-ms") config.book_interval_ms = static_cast<uint32_t>(value);
+        else if (arg == "--book-depth") config.book_depth = static_cast<uint32_t>(value);
+        else if (arg == "--seed") config.seed = static_cast<unsigned>(value);
+        else if (arg == "--matching-rate") config.matching_rate = static_cast<uint32_t>(value);
+        else if (arg == "--matching-burst") config.matching_burst = static_cast<uint32_t>(value);
+        else if (arg == "--non-matching-rate") config.non_matching_rate = static_cast<uint32_t>(value);
+        else if (arg == "--non-matching-burst") config.non_matching_burst = static_cast<uint32_t>(value);
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    try {
+        MockExchange exchange(config);
+        exchange_ptr = &exchange;
+        std::signal(SIGINT, signal_handler);
+        std::signal(SIGTERM, signal_handler);
+        exchange.run();
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,339 @@
+#include "matching_engine.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using json = nlohmann::json;
+
+MatchingEngine::MatchingEngine(std::string instrument_name, double tick_size)
+    : m_instrument_name(std::move(instrument_name)), m_tick_size(tick_size) {}
+
+int64_t MatchingEngine::to_ticks(double price) const {
+    return static_cast<int64_t>(std::llround(price / m_tick_size));
+}
+
+MatchingEngine::Order MatchingEngine::submit(Side side, const std::string& type, double amount, double price,
+                                             const std::string& label, uint64_t now, std::vector<Trade>& trades) {
+    Order order;
+    order.order_id = m_instrument_name + "-" + std::to_string(m_next_order_id++);
+    order.side = side;
+    order.type = type;
+    order.label = label;
+    order.amount = amount;
+    order.created = now;
+    order.updated = now;
+    order.state = "open";
+
+    int64_t limit_ticks;
+    if (type == "market") {
+        limit_ticks = side == Side::BUY ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int64_t>::min();
+    } else {
+        limit_ticks = to_ticks(price);
+        order.price_ticks = limit_ticks;
+    }
+
+    match(order, limit_ticks, now, trades);
+
+    if (order.filled >= order.amount) {
+        order.state = "filled";
+    } else if (type == "market") {
+        order.state = order.filled > 0 ? "filled" : "cancelled";
+    } else {
+        rest(order);
+    }
+    m_orders[order.order_id] = order;
+    return order;
+}
+
+bool MatchingEngine::cancel(const std::string& order_id, uint64_t now, Order& cancelled) {
+    auto it = m_orders.find(order_id);
+    if (it == m_orders.end() || it->second.synthetic || it->second.state != "open") return false;
+
+    unlink(it->second);
+    it->second.state = "cancelled";
+    it->second.updated = now;
+    cancelled = it->second;
+    return true;
+}
+
+bool MatchingEngine::edit(const std::string& order_id, double amount, double price, uint64_t now,
+                          Order& edited, std::vector<Trade>& trades) {
+    auto it = m_orders.find(order_id);
+    if (it == m_orders.end() || it->second.synthetic || it->second.state != "open") return false;
+
+    Order order = it->second;
+    unlink(order);
+    order.amount = amount;
+    order.price_ticks = to_ticks(price);
+    order.updated = now;
+
+    if (order.filled >= order.amount) {
+        order.state = "filled";
+    } else {
+        match(order, order.price_ticks, now, trades);
+        if (order.filled >= order.amount) {
+            order.state = "filled";
+        } else {
+            rest(order);
+        }
+    }
+    m_orders[order_id] = order;
+    edited = order;
+    return true;
+}
+
+std::vector<MatchingEngine::Order> MatchingEngine::cancel_all(uint64_t now,
+                                                              const std::function<bool(const Order&)>& predicate) {
+    std::vector<Order> cancelled;
+    for (auto& pair : m_orders) {
+        Order& order = pair.second;
+        if (order.synthetic || order.state != "open" || !predicate(order)) continue;
+        unlink(order);
+        order.state = "cancelled";
+        order.updated = now;
+        cancelled.push_back(order);
+    }
+    return cancelled;
+}
+
+const MatchingEngine::Order* MatchingEngine::find(const std::string& order_id) const {
+    auto it = m_orders.find(order_id);
+    if (it == m_orders.end() || it->second.synthetic) return nullptr;
+    return &it->second;
+}
+
+std::vector<MatchingEngine::Order> MatchingEngine::open_orders() const {
+    std::vector<Order> orders;
+    for (const auto& entry : m_orders) {
+        if (!entry.second.synthetic && entry.second.state == "open") orders.push_back(entry.second);
+    }
+    std::sort(orders.begin(), orders.end(), [](const Order& a, const Order& b) {
+        return a.created < b.created;
+    });
+    return orders;
+}
+
+bool MatchingEngine::has_synthetic(Side side, int64_t price_ticks) const {
+    const auto& synthetic = side == Side::BUY ? m_synthetic_bids : m_synthetic_asks;
+    return synthetic.count(price_ticks) > 0;
+}
+
+void MatchingEngine::set_synthetic(Side side, int64_t price_ticks, double amount, uint64_t now,
+                                   std::vector<Trade>& trades) {
+    auto& synthetic = side == Side::BUY ? m_synthetic_bids : m_synthetic_asks;
+    auto existing = synthetic.find(price_ticks);
+
+    if (existing != synthetic.end()) {
+        auto order_it = m_orders.find(existing->second);
+        if (amount <= 0) {
+            unlink(order_it->second);
+            m_orders.erase(order_it);
+            synthetic.erase(existing);
+        } else {
+            order_it->second.amount = order_it->second.filled + amount;
+            mark_dirty(side, price_ticks);
+        }
+        return;
+    }
+    if (amount <= 0) return;
+
+    Order order;
+    order.order_id = "mm-" + std::to_string(m_next_order_id++);
+    order.synthetic = true;
+    order.side = side;
+    order.type = "limit";
+    order.state = "open";
+    order.price_ticks = price_ticks;
+    order.amount = amount;
+    order.created = now;
+    order.updated = now;
+
+    match(order, price_ticks, now, trades);
+    if (order.filled < order.amount) {
+        rest(order);
+        synthetic[price_ticks] = order.order_id;
+        m_orders[order.order_id] = order;
+    }
+}
+
+void MatchingEngine::retain_synthetic(int64_t bid_low, int64_t bid_high, int64_t ask_low, int64_t ask_high) {
+    auto retain = [this](std::map<int64_t, std::string>& synthetic, int64_t low, int64_t high) {
+        for (auto it = synthetic.begin(); it != synthetic.end();) {
+            if (it->first >= low && it->first <= high) {
+                ++it;
+                continue;
+            }
+            auto order_it = m_orders.find(it->second);
+            unlink(order_it->second);
+            m_orders.erase(order_it);
+            it = synthetic.erase(it);
+        }
+    };
+    retain(m_synthetic_bids, bid_low, bid_high);
+    retain(m_synthetic_asks, ask_low, ask_high);
+}
+
+void MatchingEngine::match(Order& taker, int64_t limit_ticks, uint64_t now, std::vector<Trade>& trades) {
+    bool buying = taker.side == Side::BUY;
+    Levels& book = buying ? m_asks : m_bids;
+
+    while (taker.filled < taker.amount && !book.empty()) {
+        auto level = buying ? book.begin() : std::prev(book.end());
+        int64_t level_ticks = level->first;
+        if (buying ? level_ticks > limit_ticks : level_ticks < limit_ticks) break;
+
+        auto& queue = level->second;
+        while (taker.filled < taker.amount && !queue.empty()) {
+            Order& maker = m_orders[queue.front()];
+            double quantity = std::min(taker.amount - taker.filled, maker.amount - maker.filled);
+            double price = to_price(level_ticks);
+
+            taker.filled += quantity;
+            taker.notional += quantity * price;
+            taker.updated = now;
+            maker.filled += quantity;
+            maker.notional += quantity * price;
+            maker.updated = now;
+
+            if (!taker.synthetic) {
+                trades.push_back({std::to_string(m_next_trade_id++), taker.order_id, taker.side, price, quantity, false, now});
+            }
+            if (!maker.synthetic) {
+                trades.push_back({std::to_string(m_next_trade_id++), maker.order_id, maker.side, price, quantity, true, now});
+            }
+
+            if (maker.filled >= maker.amount) {
+                queue.pop_front();
+                if (maker.synthetic) {
+                    auto& synthetic = maker.side == Side::BUY ? m_synthetic_bids : m_synthetic_asks;
+                    synthetic.erase(level_ticks);
+                    std::string maker_id = maker.order_id;
+                    m_orders.erase(maker_id);
+                } else {
+                    maker.state = "filled";
+                }
+            }
+        }
+        mark_dirty(buying ? Side::SELL : Side::BUY, level_ticks);
+        if (queue.empty()) book.erase(level);
+    }
+}
+
+void MatchingEngine::rest(Order& order) {
+    Levels& book = order.side == Side::BUY ? m_bids : m_asks;
+    book[order.price_ticks].push_back(order.order_id);
+    mark_dirty(order.side, order.price_ticks);
+}
+
+void MatchingEngine::unlink(const Order& order) {
+    Levels& book = order.side == Side::BUY ? m_bids : m_asks;
+    auto level = book.find(order.price_ticks);
+    if (level == book.end()) return;
+
+    auto& queue = level->second;
+    queue.erase(std::remove(queue.begin(), queue.end(), order.order_id), queue.end());
+    if (queue.empty()) book.erase(level);
+    mark_dirty(order.side, order.price_ticks);
+}
+
+double MatchingEngine::level_amount(Side side, int64_t price_ticks) const {
+    const Levels& book = side == Side::BUY ? m_bids : m_asks;
+    auto level = book.find(price_ticks);
+    if (level == book.end()) return 0.0;
+
+    double total = 0.0;
+    for (const auto& order_id : level->second) {
+        const Order& order = m_orders.at(order_id);
+        total += order.amount - order.filled;
+    }
+    return total;
+}
+
+void MatchingEngine::mark_dirty(Side side, int64_t price_ticks) {
+    (side == Side::BUY ? m_dirty_bids : m_dirty_asks).insert(price_ticks);
+}
+
+std::vector<std::pair<double, double>> MatchingEngine::levels(Side side, size_t depth) const {
+    std::vector<std::pair<double, double>> result;
+    auto add = [&](int64_t ticks) {
+        result.emplace_back(to_price(ticks), level_amount(side, ticks));
+    };
+    if (side == Side::BUY) {
+        for (auto it = m_bids.rbegin(); it != m_bids.rend() && result.size() < depth; ++it) add(it->first);
+    } else {
+        for (auto it = m_asks.begin(); it != m_asks.end() && result.size() < depth; ++it) add(it->first);
+    }
+    return result;
+}
+
+double MatchingEngine::best_bid() const {
+    return m_bids.empty() ? 0.0 : to_price(m_bids.rbegin()->first);
+}
+
+double MatchingEngine::best_ask() const {
+    return m_asks.empty() ? 0.0 : to_price(m_asks.begin()->first);
+}
+
+void MatchingEngine::take_changes(std::vector<LevelChange>& bids, std::vector<LevelChange>& asks) {
+    auto collect = [this](Side side, std::set<int64_t>& dirty, std::map<int64_t, double>& published,
+                          std::vector<LevelChange>& out) {
+        for (int64_t ticks : dirty) {
+            double amount = level_amount(side, ticks);
+            auto prev = published.find(ticks);
+            if (amount <= 0) {
+                if (prev != published.end()) {
+                    out.push_back({"delete", to_price(ticks), 0.0});
+                    published.erase(prev);
+                }
+            } else if (prev == published.end()) {
+                out.push_back({"new", to_price(ticks), amount});
+                published[ticks] = amount;
+            } else if (prev->second != amount) {
+                out.push_back({"change", to_price(ticks), amount});
+                prev->second = amount;
+            }
+        }
+        dirty.clear();
+    };
+    collect(Side::BUY, m_dirty_bids, m_published_bids, bids);
+    collect(Side::SELL, m_dirty_asks, m_published_asks, asks);
+}
+
+json MatchingEngine::order_to_json(const MatchingEngine& engine, const Order& order) {
+    json j = {
+        {"order_id", order.order_id},
+        {"instrument_name", engine.instrument_name()},
+        {"direction", order.side == Side::BUY ? "buy" : "sell"},
+        {"order_type", order.type},
+        {"order_state", order.state},
+        {"label", order.label},
+        {"amount", order.amount},
+        {"filled_amount", order.filled},
+        {"average_price", order.filled > 0 ? order.notional / order.filled : 0.0},
+        {"time_in_force", "good_til_cancelled"},
+        {"post_only", false},
+        {"reduce_only", false},
+        {"api", true},
+        {"creation_timestamp", order.created},
+        {"last_update_timestamp", order.updated}
+    };
+    if (order.type == "market") {
+        j["price"] = "market_price";
+    } else {
+        j["price"] = engine.to_price(order.price_ticks);
+    }
+    return j;
+}
+
+json MatchingEngine::trade_to_json(const MatchingEngine& engine, const Trade& trade) {
+    return {
+        {"trade_id", trade.trade_id},
+        {"order_id", trade.order_id},
+        {"instrument_name", engine.instrument_name()},
+        {"direction", trade.side == Side::BUY ? "buy" : "sell"},
+        {"price", trade.price},
+        {"amount", trade.amount},
+        {"liquidity", trade.maker ? "M" : "T"},
+        {"timestamp", trade.timestamp}
+    };
+}
@@ -0,0 +1,114 @@
+#ifndef MOCK_MATCHING_ENGINE_HPP
+#define MOCK_MATCHING_ENGINE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Price-time priority limit order book for one instrument of the mock
+// exchange. Resting liquidity is a mix of user orders and synthetic
+// market-maker levels driven by the book-update generator; only user orders
+// produce order/trade reports.
+class MatchingEngine {
+public:
+    enum class Side { BUY, SELL };
+
+    struct Order {
+        std::string order_id;
+        bool synthetic = false;
+        Side side = Side::BUY;
+        std::string type;
+        std::string label;
+        std::string state;
+        int64_t price_ticks = 0;
+        double amount = 0.0;
+        double filled = 0.0;
+        double notional = 0.0;
+        uint64_t created = 0;
+        uint64_t updated = 0;
+    };
+
+    struct Trade {
+        std::string trade_id;
+        std::string order_id;
+        Side side = Side::BUY;
+        double price = 0.0;
+        double amount = 0.0;
+        bool maker = false;
+        uint64_t timestamp = 0;
+    };
+
+    struct LevelChange {
+        std::string action;
+        double price;
+        double amount;
+    };
+
+    MatchingEngine(std::string instrument_name, double tick_size);
+
+    // User order entry. Trades executed by the call are appended to trades.
+    Order submit(Side side, const std::string& type, double amount, double price,
+                 const std::string& label, uint64_t now, std::vector<Trade>& trades);
+    bool cancel(const std::string& order_id, uint64_t now, Order& cancelled);
+    bool edit(const std::string& order_id, double amount, double price, uint64_t now,
+              Order& edited, std::vector<Trade>& trades);
+    std::vector<Order> cancel_all(uint64_t now, const std::function<bool(const Order&)>& predicate);
+    const Order* find(const std::string& order_id) const;
+    // Resting user orders, oldest first.
+    std::vector<Order> open_orders() const;
+
+    // Replace the synthetic liquidity at a price. Crossing user orders trade.
+    bool has_synthetic(Side side, int64_t price_ticks) const;
+    void set_synthetic(Side side, int64_t price_ticks, double amount, uint64_t now, std::vector<Trade>& trades);
+    // Drop synthetic levels outside [low, high] on each side.
+    void retain_synthetic(int64_t bid_low, int64_t bid_high, int64_t ask_low, int64_t ask_high);
+
+    std::vector<std::pair<double, double>> levels(Side side, size_t depth) const;
+    double best_bid() const;
+    double best_ask() const;
+
+    // Aggregated level changes since the previous call, in Deribit's
+    // ["new"|"change"|"delete", price, amount] form.
+    void take_changes(std::vector<LevelChange>& bids, std::vector<LevelChange>& asks);
+
+    const std::string& instrument_name() const { return m_instrument_name; }
+    double tick_size() const { return m_tick_size; }
+    int64_t to_ticks(double price) const;
+    double to_price(int64_t ticks) const { return ticks * m_tick_size; }
+
+    static nlohmann::json order_to_json(const MatchingEngine& engine, const Order& order);
+    static nlohmann::json trade_to_json(const MatchingEngine& engine, const Trade& trade);
+
+private:
+    typedef std::map<int64_t, std::deque<std::string>> Levels;
+
+    void match(Order& taker, int64_t limit_ticks, uint64_t now, std::vector<Trade>& trades);
+    void rest(Order& order);
+    void unlink(const Order& order);
+    double level_amount(Side side, int64_t price_ticks) const;
+    void mark_dirty(Side side, int64_t price_ticks);
+
+    std::string m_instrument_name;
+    double m_tick_size;
+    uint64_t m_next_order_id = 1;
+    uint64_t m_next_trade_id = 1;
+
+    Levels m_bids;
+    Levels m_asks;
+    std::unordered_map<std::string, Order> m_orders;
+    std::map<int64_t, std::string> m_synthetic_bids;
+    std::map<int64_t, std::string> m_synthetic_asks;
+
+    std::map<int64_t, double> m_published_bids;
+    std::map<int64_t, double> m_published_asks;
+    std::set<int64_t> m_dirty_bids;
+    std::set<int64_t> m_dirty_asks;
+};
+
+#endif
@@ -0,0 +1,844 @@
+#include "mock_exchange.hpp"
+#include <openssl/ec.h>
+#include <openssl/obj_mac.h>
+#include <openssl/ssl.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using json = nlohmann::json;
+
+namespace {
+
+struct RpcError {
+    int code;
+    std::string message;
+};
+
+const uint64_t kDec26Expiry = 1798185600000ULL;
+
+uint64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// The client sends amounts and prices as strings, so accept both forms.
+double number(const json& value) {
+    if (value.is_string()) return std::stod(value.get<std::string>());
+    return value.get<double>();
+}
+
+bool starts_with(const std::string& s, const std::string& prefix) {
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
+}
+
+MockExchange::MockExchange(const MockConfig& config)
+    : m_config(config), m_book_timer(m_io), m_rng(config.seed) {
+    logger = Logger();
+
+    m_instruments = {
+        {"BTC-PERPETUAL", "future", "BTC", "USD", "", 0.5, 10, 10, 60000, 0, 0},
+        {"BTC-25DEC26", "future", "BTC", "USD", "", 2.5, 10, 10, 61500, 0, kDec26Expiry},
+        {"BTC-25DEC26-60000-C", "option", "BTC", "BTC", "call", 0.0005, 1, 0.1, 0.05, 60000, kDec26Expiry},
+        {"BTC-25DEC26-60000-P", "option", "BTC", "BTC", "put", 0.0005, 1, 0.1, 0.045, 60000, kDec26Expiry},
+        {"ETH-PERPETUAL", "future", "ETH", "USD", "", 0.05, 1, 1, 3000, 0, 0},
+        {"ETH-25DEC26", "future", "ETH", "USD", "", 0.05, 1, 1, 3050, 0, kDec26Expiry},
+        {"ETH-25DEC26-3000-C", "option", "ETH", "ETH", "call", 0.0005, 1, 1, 0.06, 3000, kDec26Expiry},
+        {"BTC_USDC", "spot", "BTC", "USDC", "", 1, 0.0001, 0.0001, 60000, 0, 0},
+        {"ETH_USDC", "spot", "ETH", "USDC", "", 0.1, 0.0001, 0.0001, 3000, 0, 0},
+        {"BTC_USDC-PERPETUAL", "future", "BTC", "USDC", "", 1, 0.001, 0.001, 60000, 0, 0},
+        {"BTC_USDC-25DEC26-60000-C", "option", "BTC", "USDC", "call", 5, 0.01, 0.01, 3000, 60000, kDec26Expiry}
+    };
+
+    generate_certificate();
+
+    m_rest.clear_access_channels(websocketpp::log::alevel::all);
+    m_rest.init_asio(&m_io);
+    m_rest.set_reuse_addr(true);
+    m_rest.set_http_handler([this](connection_hdl hdl) {
+        on_http(hdl);
+    });
+
+    m_ws.clear_access_channels(websocketpp::log::alevel::all);
+    m_ws.init_asio(&m_io);
+    m_ws.set_reuse_addr(true);
+    m_ws.set_tls_init_handler([this](connection_hdl hdl) {
+        return on_tls_init(hdl);
+    });
+    m_ws.set_open_handler([this](connection_hdl hdl) {
+        m_sessions[hdl] = Session();
+    });
+    m_ws.set_close_handler([this](connection_hdl hdl) {
+        on_ws_close(hdl);
+    });
+    m_ws.set_message_handler([this](connection_hdl hdl, ws_server::message_ptr msg) {
+        on_ws_message(hdl, msg);
+    });
+}
+
+MockExchange::~MockExchange() {
+    X509_free(m_tls_cert);
+    EVP_PKEY_free(m_tls_key);
+}
+
+void MockExchange::run() {
+    m_rest.listen(m_config.rest_port);
+    m_rest.start_accept();
+    m_ws.listen(m_config.ws_port);
+    m_ws.start_accept();
+    schedule_book_tick();
+
+    logger.log(Logger::LogLevel::SUCCESS, "Mock Deribit listening: REST http://127.0.0.1:" +
+               std::to_string(m_config.rest_port) + "/api/v2, WebSocket wss://127.0.0.1:" +
+               std::to_string(m_config.ws_port) + "/ws/api/v2");
+    m_io.run();
+}
+
+void MockExchange::stop() {
+    m_io.stop();
+}
+
+void MockExchange::generate_certificate() {
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    EVP_PKEY_keygen_init(ctx);
+    EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx, NID_X9_62_prime256v1);
+    EVP_PKEY_keygen(ctx, &m_tls_key);
+    EVP_PKEY_CTX_free(ctx);
+
+    m_tls_cert = X509_new();
+    X509_set_version(m_tls_cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(m_tls_cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(m_tls_cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(m_tls_cert), 60L * 60 * 24 * 365);
+    X509_set_pubkey(m_tls_cert, m_tls_key);
+    X509_NAME* name = X509_get_subject_name(m_tls_cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(m_tls_cert, name);
+    X509_sign(m_tls_cert, m_tls_key, EVP_sha256());
+}
+
+std::shared_ptr<boost::asio::ssl::context> MockExchange::on_tls_init(connection_hdl) {
+    auto ctx = std::make_shared<boost::asio::ssl::context>(boost::asio::ssl::context::tlsv12);
+    SSL_CTX_use_certificate(ctx->native_handle(), m_tls_cert);
+    SSL_CTX_use_PrivateKey(ctx->native_handle(), m_tls_key);
+    return ctx;
+}
+
+void MockExchange::deliver_later(std::function<void()> action) {
+    uint32_t delay = m_config.latency_us;
+    if (m_config.jitter_us) {
+        delay += std::uniform_int_distribution<uint32_t>(0, m_config.jitter_us)(m_rng);
+    }
+    if (delay == 0) {
+        action();
+        return;
+    }
+    auto timer = std::make_shared<boost::asio::steady_timer>(m_io, std::chrono::microseconds(delay));
+    timer->async_wait([timer, action](const boost::system::error_code& ec) {
+        if (!ec) action();
+    });
+}
+
+void MockExchange::on_http(connection_hdl hdl) {
+    auto con = m_rest.get_con_from_hdl(hdl);
+    std::string bearer = con->get_request_header("Authorization");
+    if (starts_with(bearer, "Bearer ")) bearer = bearer.substr(7);
+
+    json response;
+    try {
+        json request = json::parse(con->get_request_body());
+        response = dispatch(request, bearer, nullptr, hdl);
+    } catch (const json::exception& e) {
+        response = {
+            {"jsonrpc", "2.0"},
+            {"error", {{"code", -32700}, {"message", "Parse error"}}}
+        };
+    }
+
+    std::string body = response.dump();
+    auto respond = [con, body]() {
+        con->set_status(websocketpp::http::status_code::ok);
+        con->append_header("Content-Type", "application/json");
+        con->set_body(body);
+    };
+    if (m_config.latency_us == 0 && m_config.jitter_us == 0) {
+        respond();
+        return;
+    }
+    con->defer_http_response();
+    deliver_later([con, respond]() {
+        respond();
+        con->send_http_response();
+    });
+}
+
+void MockExchange::on_ws_message(connection_hdl hdl, ws_server::message_ptr msg) {
+    auto session = m_sessions.find(hdl);
+    if (session == m_sessions.end()) return;
+
+    json response;
+    try {
+        json request = json::parse(msg->get_payload());
+        response = dispatch(request, "", &session->second, hdl);
+    } catch (const json::exception& e) {
+        response = {
+            {"jsonrpc", "2.0"},
+            {"error", {{"code", -32700}, {"message", "Parse error"}}}
+        };
+    }
+
+    std::string payload = response.dump();
+    deliver_later([this, hdl, payload]() {
+        send(hdl, payload);
+
+        // Book snapshots must follow the subscribe acknowledgement.
+        auto current = m_sessions.find(hdl);
+        if (current == m_sessions.end()) return;
+        auto pending = std::move(current->second.pending_snapshots);
+        current->second.pending_snapshots.clear();
+        for (const auto& channel : pending) {
+            std::string name = channel.substr(5, channel.find('.', 5) - 5);
+            if (auto* instrument = find_instrument(name)) {
+                send_book_snapshot(hdl, channel, *instrument, book_for(*instrument));
+            }
+        }
+    });
+}
+
+void MockExchange::on_ws_close(connection_hdl hdl) {
+    auto session = m_sessions.find(hdl);
+    if (session == m_sessions.end()) return;
+
+    if (session->second.heartbeat) session->second.heartbeat->cancel();
+    for (const auto& channel : session->second.channels) {
+        auto subscribers = m_subscriptions.find(channel);
+        if (subscribers == m_subscriptions.end()) continue;
+        subscribers->second.erase(hdl);
+        if (subscribers->second.empty()) m_subscriptions.erase(subscribers);
+    }
+    m_sessions.erase(session);
+}
+
+void MockExchange::send(connection_hdl hdl, const std::string& payload) {
+    websocketpp::lib::error_code ec;
+    m_ws.send(hdl, payload, websocketpp::frame::opcode::text, ec);
+    if (ec) {
+        logger.log(Logger::LogLevel::WARNING, "Mock send failed: " + ec.message());
+    }
+}
+
+json MockExchange::dispatch(const json& request, const std::string& bearer, Session* session, connection_hdl hdl) {
+    uint64_t us_in = now_us();
+    std::string method = request.value("method", "");
+    json params = request.value("params", json::object());
+
+    json response = {{"jsonrpc", "2.0"}};
+    if (request.contains("id")) response["id"] = request["id"];
+
+    try {
+        if (starts_with(method, "private/")) {
+            bool authorized = session ? session->authenticated : m_access_tokens.count(bearer) > 0;
+            if (!authorized && params.contains("access_token")) {
+                authorized = m_access_tokens.count(params["access_token"].get<std::string>()) > 0;
+            }
+            if (!authorized) throw RpcError{13009, "unauthorized"};
+        }
+        if (!take_credit(method)) throw RpcError{10028, "too_many_requests"};
+
+        json result;
+        if (method == "public/auth") {
+            result = handle_auth(params);
+            if (session) session->authenticated = true;
+        } else if (method == "public/test") {
+            result = {{"version", "mock-1.0.0"}};
+        } else if (method == "public/get_time") {
+            result = now_ms();
+        } else if (method == "private/buy") {
+            result = handle_order(MatchingEngine::Side::BUY, params);
+        } else if (method == "private/sell") {
+            result = handle_order(MatchingEngine::Side::SELL, params);
+        } else if (method == "private/edit") {
+            result = handle_edit(params);
+        } else if (method == "private/cancel") {
+            result = handle_cancel(params);
+        } else if (starts_with(method, "private/cancel_all") || method == "private/cancel_by_label") {
+            result = handle_cancel_all(params);
+        } else if (method == "private/get_open_orders_by_currency" || method == "private/get_open_orders_by_instrument") {
+            result = handle_get_open_orders(params);
+        } else if (method == "private/get_positions") {
+            result = handle_get_positions(params);
+        } else if (method == "public/get_order_book") {
+            result = handle_get_order_book(params);
+        } else if (method == "public/get_instruments") {
+            result = handle_get_instruments(params);
+        } else if (method == "public/get_instrument") {
+            result = handle_get_instrument(params);
+        } else if (method == "public/subscribe" || method == "private/subscribe") {
+            result = handle_subscribe(params, session, hdl);
+        } else if (method == "public/unsubscribe" || method == "private/unsubscribe") {
+            if (!session) throw RpcError{-32600, "Invalid request"};
+            result = json::array();
+            for (const auto& channel : params.at("channels")) {
+                std::string name = channel.get<std::string>();
+                session->channels.erase(name);
+                m_subscriptions[name].erase(hdl);
+                result.push_back(name);
+            }
+        } else if (method == "public/set_heartbeat") {
+            result = handle_set_heartbeat(params, session, hdl);
+        } else if (method == "public/disable_heartbeat") {
+            if (session && session->heartbeat) session->heartbeat->cancel();
+            result = "ok";
+        } else {
+            throw RpcError{-32601, "Method not found"};
+        }
+        response["result"] = result;
+    } catch (const RpcError& e) {
+        response["error"] = {{"code", e.code}, {"message", e.message}};
+    } catch (const std::exception& e) {
+        response["error"] = {{"code", -32602}, {"message", "Invalid params"}, {"data", {{"reason", e.what()}}}};
+    }
+
+    uint64_t us_out = now_us();
+    response["usIn"] = us_in;
+    response["usOut"] = us_out;
+    response["usDiff"] = us_out - us_in;
+    response["testnet"] = true;
+    return response;
+}
+
+json MockExchange::handle_auth(const json& params) {
+    std::string grant_type = params.at("grant_type");
+    if (grant_type == "refresh_token") {
+        std::string token = params.at("refresh_token");
+        if (!m_refresh_tokens.count(token)) throw RpcError{13004, "invalid_credentials"};
+        m_refresh_tokens.erase(token);
+    } else if (grant_type == "client_credentials") {
+        if (params.value("client_id", "").empty()) throw RpcError{13004, "invalid_credentials"};
+    } else {
+        throw RpcError{13004, "invalid_credentials"};
+    }
+
+    std::string id = std::to_string(m_next_token++);
+    std::string access_token = "mock-access-" + id;
+    std::string refresh_token = "mock-refresh-" + id;
+    m_access_tokens.insert(access_token);
+    m_refresh_tokens.insert(refresh_token);
+    return {
+        {"access_token", access_token},
+        {"refresh_token", refresh_token},
+        {"expires_in", 900},
+        {"scope", "connection mainaccount trade:read_write"},
+        {"token_type", "bearer"}
+    };
+}
+
+json MockExchange::handle_order(MatchingEngine::Side side, const json& params) {
+    const Instrument* instrument = find_instrument(params.at("instrument_name"));
+    if (!instrument) throw RpcError{-32602, "Invalid params"};
+
+    std::string type = params.value("type", "limit");
+    double amount = number(params.at("amount"));
+    double price = type == "market" ? 0.0 : number(params.at("price"));
+    if (amount <= 0 || (type != "market" && price <= 0)) throw RpcError{-32602, "Invalid params"};
+
+    MatchingEngine& engine = *book_for(*instrument).engine;
+    std::vector<MatchingEngine::Trade> trades;
+    auto order = engine.submit(side, type, amount, price, params.value("label", ""), now_ms(), trades);
+    m_order_instruments[order.order_id] = instrument->name;
+
+    json own_trades = json::array();
+    for (const auto& trade : trades) {
+        if (trade.order_id == order.order_id) own_trades.push_back(MatchingEngine::trade_to_json(engine, trade));
+    }
+    report_fills(engine, trades);
+    report_order(engine, order);
+    return {{"order", MatchingEngine::order_to_json(engine, order)}, {"trades", own_trades}};
+}
+
+json MockExchange::handle_edit(const json& params) {
+    std::string order_id = params.at("order_id");
+    MatchingEngine* engine = engine_for_order(order_id);
+    if (!engine) throw RpcError{10004, "order_not_found"};
+
+    MatchingEngine::Order order;
+    std::vector<MatchingEngine::Trade> trades;
+    if (!engine->edit(order_id, number(params.at("amount")), number(params.at("price")), now_ms(), order, trades)) {
+        throw RpcError{10004, "order_not_found"};
+    }
+
+    json own_trades = json::array();
+    for (const auto& trade : trades) {
+        if (trade.order_id == order_id) own_trades.push_back(MatchingEngine::trade_to_json(*engine, trade));
+    }
+    report_fills(*engine, trades);
+    report_order(*engine, order);
+    return {{"order", MatchingEngine::order_to_json(*engine, order)}, {"trades", own_trades}};
+}
+
+json MockExchange::handle_cancel(const json& params) {
+    std::string order_id = params.at("order_id");
+    MatchingEngine* engine = engine_for_order(order_id);
+    MatchingEngine::Order order;
+    if (!engine || !engine->cancel(order_id, now_ms(), order)) throw RpcError{10004, "order_not_found"};
+
+    report_order(*engine, order);
+    return MatchingEngine::order_to_json(*engine, order);
+}
+
+bool MockExchange::take_credit(const std::string& method) {
+    bool matching = method == "private/buy" || method == "private/sell" || method == "private/edit" ||
+                    starts_with(method, "private/cancel");
+    uint32_t rate = matching ? m_config.matching_rate : m_config.non_matching_rate;
+    if (rate == 0) return true;
+    double burst = matching ? m_config.matching_burst : m_config.non_matching_burst;
+    Credits& credits = matching ? m_matching_credits : m_non_matching_credits;
+
+    uint64_t now = now_us();
+    if (credits.tokens < 0) credits.tokens = burst;
+    credits.tokens = std::min(burst, credits.tokens + (now - credits.updated_us) * 1e-6 * rate);
+    credits.updated_us = now;
+    if (credits.tokens < 1.0) return false;
+    credits.tokens -= 1.0;
+    return true;
+}
+
+json MockExchange::handle_cancel_all(const json& params) {
+    std::string instrument_name = params.value("instrument_name", "");
+    std::string currency = params.value("currency", "");
+    std::string kind = params.value("kind", "any");
+    std::string label = params.value("label", "");
+
+    uint64_t cancelled = 0;
+    for (const auto& instrument : m_instruments) {
+        if (!instrument_name.empty() && instrument.name != instrument_name) continue;
+        if (!currency.empty() && instrument.base_currency != currency) continue;
+        if (kind != "any" && instrument.kind != kind) continue;
+
+        auto book = m_books.find(instrument.name);
+        if (book == m_books.end()) continue;
+        auto orders = book->second.engine->cancel_all(now_ms(), [&](const MatchingEngine::Order& order) {
+            return label.empty() || order.label == label;
+        });
+        for (const auto& order : orders) report_order(*book->second.engine, order);
+        cancelled += orders.size();
+    }
+    return cancelled;
+}
+
+json MockExchange::handle_get_open_orders(const json& params) {
+    std::string instrument_name = params.value("instrument_name", "");
+    std::string currency = params.value("currency", "");
+    std::string kind = params.value("kind", "any");
+
+    json result = json::array();
+    for (const auto& instrument : m_instruments) {
+        if (!instrument_name.empty() && instrument.name != instrument_name) continue;
+        if (!currency.empty() && instrument.base_currency != currency) continue;
+        if (kind != "any" && instrument.kind != kind) continue;
+
+        auto book = m_books.find(instrument.name);
+        if (book == m_books.end()) continue;
+        for (const auto& order : book->second.engine->open_orders()) {
+            result.push_back(MatchingEngine::order_to_json(*book->second.engine, order));
+        }
+    }
+    return result;
+}
+
+json MockExchange::handle_get_positions(const json& params) {
+    std::string currency = params.value("currency", "any");
+    std::string kind = params.value("kind", "any");
+
+    json result = json::array();
+    for (const auto& instrument : m_instruments) {
+        if (currency != "any" && instrument.base_currency != currency && instrument.quote_currency != currency) continue;
+        if (kind != "any" && instrument.kind != kind) continue;
+
+        auto position = m_positions.find(instrument.name);
+        if (position == m_positions.end()) continue;
+
+        result.push_back(position_to_json(instrument, position->second));
+    }
+    return result;
+}
+
+json MockExchange::position_to_json(const Instrument& instrument, const Position& p) {
+    auto book = m_books.find(instrument.name);
+    double mark_price = instrument.reference_price;
+    if (book != m_books.end()) mark_price = book->second.engine->to_price(book->second.mid_ticks);
+    double floating = p.size * (mark_price - p.average_price);
+
+    return {
+        {"instrument_name", instrument.name},
+        {"kind", instrument.kind},
+        {"direction", p.size > 0 ? "buy" : (p.size < 0 ? "sell" : "zero")},
+        {"size", p.size},
+        {"average_price", p.average_price},
+        {"mark_price", mark_price},
+        {"index_price", mark_price},
+        {"floating_profit_loss", floating},
+        {"realized_profit_loss", p.realized_pnl},
+        {"total_profit_loss", floating + p.realized_pnl}
+    };
+}
+
+json MockExchange::handle_get_order_book(const json& params) {
+    const Instrument* instrument = find_instrument(params.at("instrument_name"));
+    if (!instrument) throw RpcError{-32602, "Invalid params"};
+    size_t depth = params.value("depth", 5);
+
+    Book& book = book_for(*instrument);
+    const MatchingEngine& engine = *book.engine;
+    auto bids = engine.levels(MatchingEngine::Side::BUY, depth);
+    auto asks = engine.levels(MatchingEngine::Side::SELL, depth);
+    double mark_price = engine.to_price(book.mid_ticks);
+
+    json result = {
+        {"instrument_name", instrument->name},
+        {"timestamp", now_ms()},
+        {"state", "open"},
+        {"change_id", book.change_id},
+        {"bids", json::array()},
+        {"asks", json::array()},
+        {"best_bid_price", bids.empty() ? 0.0 : bids[0].first},
+        {"best_bid_amount", bids.empty() ? 0.0 : bids[0].second},
+        {"best_ask_price", asks.empty() ? 0.0 : asks[0].first},
+        {"best_ask_amount", asks.empty() ? 0.0 : asks[0].second},
+        {"mark_price", mark_price},
+        {"index_price", mark_price},
+        {"last_price", mark_price}
+    };
+    for (const auto& level : bids) result["bids"].push_back({level.first, level.second});
+    for (const auto& level : asks) result["asks"].push_back({level.first, level.second});
+    return result;
+}
+
+json MockExchange::handle_get_instruments(const json& params) {
+    std::string currency = params.value("currency", "any");
+    std::string kind = params.value("kind", "any");
+
+    json result = json::array();
+    for (const auto& instrument : m_instruments) {
+        if (currency != "any" && instrument.base_currency != currency && instrument.quote_currency != currency) continue;
+        if (kind != "any" && instrument.kind != kind) continue;
+        result.push_back(instrument_to_json(instrument));
+    }
+    return result;
+}
+
+json MockExchange::handle_get_instrument(const json& params) {
+    const Instrument* instrument = find_instrument(params.at("instrument_name"));
+    if (!instrument) throw RpcError{-32602, "Invalid params"};
+    return instrument_to_json(*instrument);
+}
+
+json MockExchange::instrument_to_json(const Instrument& instrument) const {
+    bool inverse = instrument.quote_currency == "USD";
+    json j = {
+        {"instrument_name", instrument.name},
+        {"instrument_id", &instrument - m_instruments.data() + 1},
+        {"kind", instrument.kind},
+        {"base_currency", instrument.base_currency},
+        {"quote_currency", instrument.quote_currency},
+        {"counter_currency", instrument.quote_currency},
+        {"settlement_currency", inverse ? instrument.base_currency : instrument.quote_currency},
+        {"price_index", instrument.base_currency == "BTC" ? "btc_usd" : "eth_usd"},
+        {"tick_size", instrument.tick_size},
+        {"contract_size", instrument.contract_size},
+        {"min_trade_amount", instrument.min_trade_amount},
+        {"creation_timestamp", 1700000000000ULL},
+        {"expiration_timestamp", instrument.expiration_timestamp ? instrument.expiration_timestamp : 32503708800000ULL},
+        {"settlement_period", instrument.expiration_timestamp ? "month" : "perpetual"},
+        {"is_active", true},
+        {"maker_commission", 0.0},
+        {"taker_commission", 0.0005}
+    };
+    if (instrument.kind == "option") {
+        j["option_type"] = instrument.option_type;
+        j["strike"] = instrument.strike;
+    }
+    return j;
+}
+
+json MockExchange::handle_subscribe(const json& params, Session* session, connection_hdl hdl) {
+    if (!session) throw RpcError{-32600, "Invalid request"};
+
+    json result = json::array();
+    for (const auto& entry : params.at("channels")) {
+        std::string channel = entry.get<std::string>();
+        if (starts_with(channel, "user.") && !session->authenticated) continue;
+        if (starts_with(channel, "book.")) {
+            std::string name = channel.substr(5, channel.find('.', 5) - 5);
+            if (!find_instrument(name)) continue;
+            session->pending_snapshots.push_back(channel);
+        }
+        session->channels.insert(channel);
+        m_subscriptions[channel].insert(hdl);
+        result.push_back(channel);
+    }
+    return result;
+}
+
+json MockExchange::handle_set_heartbeat(const json& params, Session* session, connection_hdl hdl) {
+    if (!session) throw RpcError{-32600, "Invalid request"};
+    int interval = params.at("interval");
+    if (interval < 1) throw RpcError{-32602, "Invalid params"};
+
+    if (session->heartbeat) session->heartbeat->cancel();
+    session->heartbeat_interval = interval;
+    session->heartbeat = std::make_shared<boost::asio::steady_timer>(m_io);
+    schedule_heartbeat(hdl);
+    return "ok";
+}
+
+void MockExchange::schedule_heartbeat(connection_hdl hdl) {
+    auto session = m_sessions.find(hdl);
+    if (session == m_sessions.end() || !session->second.heartbeat) return;
+
+    auto timer = session->second.heartbeat;
+    timer->expires_from_now(std::chrono::seconds(session->second.heartbeat_interval));
+    timer->async_wait([this, hdl, timer](const boost::system::error_code& ec) {
+        if (ec) return;
+        json heartbeat = {
+            {"jsonrpc", "2.0"},
+            {"method", "heartbeat"},
+            {"params", {{"type", "test_request"}}}
+        };
+        send(hdl, heartbeat.dump());
+        schedule_heartbeat(hdl);
+    });
+}
+
+const MockExchange::Instrument* MockExchange::find_instrument(const std::string& name) const {
+    for (const auto& instrument : m_instruments) {
+        if (instrument.name == name) return &instrument;
+    }
+    return nullptr;
+}
+
+MockExchange::Book& MockExchange::book_for(const Instrument& instrument) {
+    auto it = m_books.find(instrument.name);
+    if (it != m_books.end()) return it->second;
+
+    Book& book = m_books[instrument.name];
+    book.engine.reset(new MatchingEngine(instrument.name, instrument.tick_size));
+    book.mid_ticks = book.engine->to_ticks(instrument.reference_price);
+    std::vector<MatchingEngine::Trade> trades;
+    regenerate_levels(instrument, book, true, trades);
+
+    std::vector<MatchingEngine::LevelChange> bids, asks;
+    book.engine->take_changes(bids, asks);
+    return book;
+}
+
+MatchingEngine* MockExchange::engine_for_order(const std::string& order_id) {
+    auto it = m_order_instruments.find(order_id);
+    if (it == m_order_instruments.end()) return nullptr;
+    auto book = m_books.find(it->second);
+    return book == m_books.end() ? nullptr : book->second.engine.get();
+}
+
+// Random-walks the synthetic mid and refreshes the market-maker levels
+// around it. Resting user orders crossed by the new levels are filled.
+void MockExchange::regenerate_levels(const Instrument& instrument, Book& book, bool all_levels,
+                                     std::vector<MatchingEngine::Trade>& trades) {
+    MatchingEngine& engine = *book.engine;
+    int64_t depth = m_config.book_depth;
+    int64_t mid = book.mid_ticks;
+    uint64_t now = now_ms();
+
+    engine.retain_synthetic(mid - depth, mid - 1, mid + 1, mid + depth);
+
+    std::uniform_int_distribution<int> lots(1, 200);
+    std::bernoulli_distribution refresh(0.3);
+    for (int64_t i = 1; i <= depth; ++i) {
+        if (all_levels || refresh(m_rng) || !engine.has_synthetic(MatchingEngine::Side::BUY, mid - i)) {
+            engine.set_synthetic(MatchingEngine::Side::BUY, mid - i, instrument.min_trade_amount * lots(m_rng), now, trades);
+        }
+        if (all_levels || refresh(m_rng) || !engine.has_synthetic(MatchingEngine::Side::SELL, mid + i)) {
+            engine.set_synthetic(MatchingEngine::Side::SELL, mid + i, instrument.min_trade_amount * lots(m_rng), now, trades);
+        }
+    }
+}
+
+void MockExchange::schedule_book_tick() {
+    m_book_timer.expires_from_now(std::chrono::milliseconds(m_config.book_interval_ms));
+    m_book_timer.async_wait([this](const boost::system::error_code& ec) {
+        if (ec) return;
+        book_tick();
+        schedule_book_tick();
+    });
+}
+
+void MockExchange::book_tick() {
+    std::uniform_int_distribution<int> step(-2, 2);
+    for (auto& pair : m_books) {
+        const Instrument* instrument = find_instrument(pair.first);
+        Book& book = pair.second;
+
+        int64_t next = book.mid_ticks + step(m_rng);
+        if (next > static_cast<int64_t>(m_config.book_depth) + 1) book.mid_ticks = next;
+
+        std::vector<MatchingEngine::Trade> trades;
+        regenerate_levels(*instrument, book, false, trades);
+        report_fills(*book.engine, trades);
+        publish_book_changes(*instrument, book);
+    }
+}
+
+void MockExchange::publish_book_changes(const Instrument& instrument, Book& book) {
+    std::vector<MatchingEngine::LevelChange> bids, asks;
+    book.engine->take_changes(bids, asks);
+    if (bids.empty() && asks.empty()) return;
+
+    uint64_t prev_change_id = book.change_id++;
+    json data = {
+        {"type", "change"},
+        {"timestamp", now_ms()},
+        {"instrument_name", instrument.name},
+        {"prev_change_id", prev_change_id},
+        {"change_id", book.change_id},
+        {"bids", json::array()},
+        {"asks", json::array()}
+    };
+    for (const auto& change : bids) data["bids"].push_back({change.action, change.price, change.amount});
+    for (const auto& change : asks) data["asks"].push_back({change.action, change.price, change.amount});
+
+    std::string prefix = "book." + instrument.name + ".";
+    for (auto it = m_subscriptions.lower_bound(prefix); it != m_subscriptions.end() && starts_with(it->first, prefix); ++it) {
+        publish(it->first, data);
+    }
+
+    for (const char* interval : {".100ms", ".raw"}) {
+        std::string ticker_channel = "ticker." + instrument.name + interval;
+        if (!m_subscriptions.count(ticker_channel)) continue;
+        publish(ticker_channel, {
+            {"timestamp", now_ms()},
+            {"instrument_name", instrument.name},
+            {"mark_price", book.engine->to_price(book.mid_ticks)},
+            {"best_bid_price", book.engine->best_bid()},
+            {"best_ask_price", book.engine->best_ask()}
+        });
+    }
+
+    std::string quote_channel = "quote." + instrument.name;
+    if (m_subscriptions.count(quote_channel)) {
+        auto bid = book.engine->levels(MatchingEngine::Side::BUY, 1);
+        auto ask = book.engine->levels(MatchingEngine::Side::SELL, 1);
+        publish(quote_channel, {
+            {"timestamp", now_ms()},
+            {"instrument_name", instrument.name},
+            {"best_bid_price", bid.empty() ? 0.0 : bid[0].first},
+            {"best_bid_amount", bid.empty() ? 0.0 : bid[0].second},
+            {"best_ask_price", ask.empty() ? 0.0 : ask[0].first},
+            {"best_ask_amount", ask.empty() ? 0.0 : ask[0].second}
+        });
+    }
+}
+
+void MockExchange::send_book_snapshot(connection_hdl hdl, const std::string& channel, const Instrument& instrument,
+                                      Book& book) {
+    json data = {
+        {"type", "snapshot"},
+        {"timestamp", now_ms()},
+        {"instrument_name", instrument.name},
+        {"change_id", book.change_id},
+        {"bids", json::array()},
+        {"asks", json::array()}
+    };
+    for (const auto& level : book.engine->levels(MatchingEngine::Side::BUY, SIZE_MAX)) {
+        data["bids"].push_back({"new", level.first, level.second});
+    }
+    for (const auto& level : book.engine->levels(MatchingEngine::Side::SELL, SIZE_MAX)) {
+        data["asks"].push_back({"new", level.first, level.second});
+    }
+    json notification = {
+        {"jsonrpc", "2.0"},
+        {"method", "subscription"},
+        {"params", {{"channel", channel}, {"data", data}}}
+    };
+    send(hdl, notification.dump());
+}
+
+void MockExchange::report_fills(const MatchingEngine& engine, const std::vector<MatchingEngine::Trade>& trades) {
+    if (trades.empty()) return;
+    const Instrument* instrument = find_instrument(engine.instrument_name());
+
+    std::set<std::string> touched;
+    json reports = json::array();
+    for (const auto& trade : trades) {
+        apply_fill(engine.instrument_name(), trade.side, trade.price, trade.amount);
+        reports.push_back(MatchingEngine::trade_to_json(engine, trade));
+        if (trade.maker) touched.insert(trade.order_id);
+    }
+    publish_user("trades", *instrument, reports);
+    publish_user("changes", *instrument, {
+        {"instrument_name", instrument->name},
+        {"trades", reports},
+        {"orders", json::array()},
+        {"positions", {position_to_json(*instrument, m_positions[instrument->name])}}
+    });
+
+    // Takers are reported by the request handler; resting orders hit by the
+    // trades are reported here.
+    for (const auto& order_id : touched) {
+        if (auto* order = engine.find(order_id)) report_order(engine, *order);
+    }
+}
+
+void MockExchange::report_order(const MatchingEngine& engine, const MatchingEngine::Order& order) {
+    publish_user("orders", *find_instrument(engine.instrument_name()), MatchingEngine::order_to_json(engine, order));
+}
+
+void MockExchange::publish_user(const std::string& stream, const Instrument& instrument, const json& data) {
+    std::string prefix = "user." + stream + ".";
+    const std::string channels[] = {
+        prefix + instrument.name + ".raw",
+        prefix + "any.any.raw",
+        prefix + "any." + instrument.base_currency + ".raw",
+        prefix + instrument.kind + ".any.raw",
+        prefix + instrument.kind + "." + instrument.base_currency + ".raw"
+    };
+    for (const auto& channel : channels) publish(channel, data);
+}
+
+void MockExchange::publish(const std::string& channel, const json& data) {
+    auto subscribers = m_subscriptions.find(channel);
+    if (subscribers == m_subscriptions.end() || subscribers->second.empty()) return;
+
+    json notification = {
+        {"jsonrpc", "2.0"},
+        {"method", "subscription"},
+        {"params", {{"channel", channel}, {"data", data}}}
+    };
+    std::string payload = notification.dump();
+    for (const auto& hdl : subscribers->second) send(hdl, payload);
+}
+
+void MockExchange::apply_fill(const std::string& instrument_name, MatchingEngine::Side side, double price, double amount) {
+    Position& p = m_positions[instrument_name];
+    double signed_amount = side == MatchingEngine::Side::BUY ? amount : -amount;
+
+    if (p.size == 0 || (p.size > 0) == (signed_amount > 0)) {
+        p.average_price = (std::fabs(p.size) * p.average_price + amount * price) / (std::fabs(p.size) + amount);
+        p.size += signed_amount;
+        return;
+    }
+
+    double closing = std::min(amount, std::fabs(p.size));
+    p.realized_pnl += closing * (price - p.average_price) * (p.size > 0 ? 1 : -1);
+    p.size += signed_amount;
+    if (p.size == 0) {
+        p.average_price = 0.0;
+    } else if ((p.size > 0) == (signed_amount > 0)) {
+        p.average_price = price;
+    }
+}
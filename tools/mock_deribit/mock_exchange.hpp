@@ -0,0 +1,159 @@
+#ifndef MOCK_EXCHANGE_HPP
+#define MOCK_EXCHANGE_HPP
+
+#include <websocketpp/config/asio.hpp>
+#include <websocketpp/server.hpp>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <nlohmann/json.hpp>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include "logger.hpp"
+#include "matching_engine.hpp"
+
+struct MockConfig {
+    uint16_t rest_port = 8080;
+    uint16_t ws_port = 8443;
+    uint32_t latency_us = 0;
+    uint32_t jitter_us = 0;
+    uint32_t book_interval_ms = 100;
+    uint32_t book_depth = 10;
+    unsigned seed = 42;
+    // Credit limits in requests; a rate of 0 disables the check. Requests over
+    // the limit fail with too_many_requests (10028) like the real exchange.
+    uint32_t matching_rate = 0;
+    uint32_t matching_burst = 20;
+    uint32_t non_matching_rate = 0;
+    uint32_t non_matching_burst = 100;
+};
+
+// Local stand-in for the Deribit JSON-RPC API. REST is served over plain HTTP
+// on rest_port, the WebSocket API over TLS (self-signed certificate generated
+// at startup) on ws_port. Everything runs on a single io thread.
+class MockExchange {
+public:
+    explicit MockExchange(const MockConfig& config);
+    ~MockExchange();
+
+    void run();
+    void stop();
+
+    Logger logger;
+private:
+    typedef websocketpp::server<websocketpp::config::asio> rest_server;
+    typedef websocketpp::server<websocketpp::config::asio_tls> ws_server;
+    typedef websocketpp::connection_hdl connection_hdl;
+    typedef std::set<connection_hdl, std::owner_less<connection_hdl>> connection_set;
+
+    struct Instrument {
+        std::string name;
+        std::string kind;
+        std::string base_currency;
+        std::string quote_currency;
+        std::string option_type;
+        double tick_size;
+        double contract_size;
+        double min_trade_amount;
+        double reference_price;
+        double strike;
+        uint64_t expiration_timestamp;
+    };
+
+    struct Position {
+        double size = 0.0;
+        double average_price = 0.0;
+        double realized_pnl = 0.0;
+    };
+
+    struct Session {
+        bool authenticated = false;
+        std::set<std::string> channels;
+        std::vector<std::string> pending_snapshots;
+        std::shared_ptr<boost::asio::steady_timer> heartbeat;
+        int heartbeat_interval = 0;
+    };
+
+    struct Credits {
+        double tokens = -1.0;   // negative until first use, then starts full
+        uint64_t updated_us = 0;
+    };
+
+    struct Book {
+        std::unique_ptr<MatchingEngine> engine;
+        int64_t mid_ticks = 0;
+        uint64_t change_id = 0;
+    };
+
+    // JSON-RPC dispatch shared by REST and WebSocket. session is null for REST.
+    nlohmann::json dispatch(const nlohmann::json& request, const std::string& bearer, Session* session,
+                            connection_hdl hdl);
+    nlohmann::json handle_auth(const nlohmann::json& params);
+    nlohmann::json handle_order(MatchingEngine::Side side, const nlohmann::json& params);
+    nlohmann::json handle_edit(const nlohmann::json& params);
+    nlohmann::json handle_cancel(const nlohmann::json& params);
+    nlohmann::json handle_cancel_all(const nlohmann::json& params);
+    nlohmann::json handle_get_positions(const nlohmann::json& params);
+    nlohmann::json position_to_json(const Instrument& instrument, const Position& position);
+    nlohmann::json handle_get_open_orders(const nlohmann::json& params);
+    nlohmann::json handle_get_order_book(const nlohmann::json& params);
+    nlohmann::json handle_get_instruments(const nlohmann::json& params);
+    nlohmann::json handle_get_instrument(const nlohmann::json& params);
+    nlohmann::json instrument_to_json(const Instrument& instrument) const;
+    nlohmann::json handle_subscribe(const nlohmann::json& params, Session* session, connection_hdl hdl);
+    nlohmann::json handle_set_heartbeat(const nlohmann::json& params, Session* session, connection_hdl hdl);
+
+    void on_http(connection_hdl hdl);
+    void on_ws_message(connection_hdl hdl, ws_server::message_ptr msg);
+    void on_ws_close(connection_hdl hdl);
+    std::shared_ptr<boost::asio::ssl::context> on_tls_init(connection_hdl hdl);
+
+    void schedule_heartbeat(connection_hdl hdl);
+    void schedule_book_tick();
+    void book_tick();
+    void regenerate_levels(const Instrument& instrument, Book& book, bool all_levels,
+                           std::vector<MatchingEngine::Trade>& trades);
+    void publish_book_changes(const Instrument& instrument, Book& book);
+    void send_book_snapshot(connection_hdl hdl, const std::string& channel, const Instrument& instrument, Book& book);
+    void report_fills(const MatchingEngine& engine, const std::vector<MatchingEngine::Trade>& trades);
+    void report_order(const MatchingEngine& engine, const MatchingEngine::Order& order);
+    void publish(const std::string& channel, const nlohmann::json& data);
+    void publish_user(const std::string& stream, const Instrument& instrument, const nlohmann::json& data);
+    void send(connection_hdl hdl, const std::string& payload);
+    void deliver_later(std::function<void()> action);
+
+    const Instrument* find_instrument(const std::string& name) const;
+    Book& book_for(const Instrument& instrument);
+    MatchingEngine* engine_for_order(const std::string& order_id);
+    void apply_fill(const std::string& instrument_name, MatchingEngine::Side side, double price, double amount);
+    void generate_certificate();
+    bool take_credit(const std::string& method);
+
+    MockConfig m_config;
+    boost::asio::io_service m_io;
+    boost::asio::steady_timer m_book_timer;
+    rest_server m_rest;
+    ws_server m_ws;
+    std::mt19937 m_rng;
+
+    std::vector<Instrument> m_instruments;
+    std::map<std::string, Book> m_books;
+    std::map<std::string, Position> m_positions;
+    std::map<std::string, std::string> m_order_instruments;
+    std::set<std::string> m_access_tokens;
+    std::set<std::string> m_refresh_tokens;
+    uint64_t m_next_token = 1;
+    Credits m_matching_credits;
+    Credits m_non_matching_credits;
+
+    std::map<connection_hdl, Session, std::owner_less<connection_hdl>> m_sessions;
+    std::map<std::string, connection_set> m_subscriptions;
+
+    EVP_PKEY* m_tls_key = nullptr;
+    X509* m_tls_cert = nullptr;
+};
+
+#endif